@@ -8,6 +8,7 @@ using System.Text.RegularExpressions;
 using Force.Blazer.Algorithms;
 using Force.Blazer.Exe.CommandLine;
 using Force.Blazer.Helpers;
+using Force.Blazer.Native;
 
 namespace Force.Blazer.Exe
 {
@@ -138,7 +139,7 @@ namespace Force.Blazer.Exe
 			else if (mode == "stream")
 				compressionOptions.SetEncoderByAlgorithm(BlazerAlgorithm.Stream);
 			else if (mode == "streamhigh")
-				compressionOptions.Encoder = new StreamEncoderHigh();
+				compressionOptions.Encoder = NativeHelper.IsStreamHighAvailable ? (IEncoder)new StreamEncoderHighNative() : new StreamEncoderHigh();
 			else if (mode == "block")
 			{
 				compressionOptions.SetEncoderByAlgorithm(BlazerAlgorithm.Block);
@@ -0,0 +1,581 @@
+// Native benchmark of Blazer codecs without P/Invoke and GC overhead
+//
+// Usage: blazer_bench [options] [files...]
+//   --min-block <size>   minimal block size (default 512)
+//   --max-block <size>   maximal block size (default 16M)
+//   --corpus-size <size> size of synthetic corpora (default 16M)
+//   --time <ms>          minimal measuring time for every result (default 300)
+//   --threads <count>    threads for parallel block codecs (default 0 - count of processors)
+//   --no-synthetic       do not run synthetic corpora, only given files
+//   --json <file>        write results in JSON format to file ("-" for stdout)
+// Sizes can have K or M suffix.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define BENCH_HAS_TSC
+#endif
+
+#include "Blazer.h"
+
+struct BenchOptions
+{
+	int minBlockSize;
+	int maxBlockSize;
+	size_t corpusSize;
+	double minTime;
+	int threads;
+	bool synthetic;
+	const char* jsonFile;
+	std::vector<std::string> files;
+};
+
+struct BenchResult
+{
+	std::string corpus;
+	std::string algorithm;
+	std::string operation;
+	int blockSize;
+	size_t inputSize;
+	size_t outputSize;
+	double mbPerSecond;
+	double cyclesPerByte;
+};
+
+// human-readable results are written to stderr if json is written to stdout
+static FILE* _log = stdout;
+
+struct Corpus
+{
+	std::string name;
+	std::vector<unsigned char> data;
+};
+
+struct Timer
+{
+	std::chrono::steady_clock::time_point start;
+	uint64_t startTsc;
+
+	void Start()
+	{
+		start = std::chrono::steady_clock::now();
+#ifdef BENCH_HAS_TSC
+		startTsc = __rdtsc();
+#endif
+	}
+
+	double Seconds() const
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// timestamp counter ticks with nominal frequency, so it is equal to cycles only with fixed cpu frequency
+	double Cycles() const
+	{
+#ifdef BENCH_HAS_TSC
+		return (double)(__rdtsc() - startTsc);
+#else
+		return 0;
+#endif
+	}
+};
+
+static uint32_t _rndState = 123456789;
+
+static uint32_t NextRandom()
+{
+	_rndState ^= _rndState << 13;
+	_rndState ^= _rndState >> 17;
+	_rndState ^= _rndState << 5;
+	return _rndState;
+}
+
+static void AppendString(std::vector<unsigned char>& data, const char* s)
+{
+	data.insert(data.end(), s, s + strlen(s));
+}
+
+static std::vector<unsigned char> GenerateLogs(size_t length)
+{
+	static const char* levels[] = { "INFO ", "DEBUG", "WARN ", "ERROR" };
+	static const char* messages[] = {
+		"Request completed", "Connection accepted from", "Session started for user", "Timeout while waiting for",
+		"Cache miss for key", "Retrying operation", "Failed to resolve host", "Writing block to disk" };
+	std::vector<unsigned char> data;
+	data.reserve(length + 256);
+	uint32_t time = 36000000;
+	char line[256];
+	while (data.size() < length)
+	{
+		time += NextRandom() % 2000;
+		sprintf(line, "2016-05-01 %02u:%02u:%02u.%03u [%s] %s %u.%u.%u.%u id=%u\n",
+			time / 3600000 % 24, time / 60000 % 60, time / 1000 % 60, time % 1000,
+			levels[NextRandom() % 4], messages[NextRandom() % 8],
+			10, NextRandom() % 4, NextRandom() % 256, NextRandom() % 256, NextRandom() % 100000);
+		AppendString(data, line);
+	}
+
+	data.resize(length);
+	return data;
+}
+
+static std::vector<unsigned char> GenerateJson(size_t length)
+{
+	static const char* names[] = { "alice", "bob", "carol", "dave", "eve", "mallory", "trent", "victor" };
+	std::vector<unsigned char> data;
+	data.reserve(length + 256);
+	char item[256];
+	uint32_t id = 1000;
+	AppendString(data, "[");
+	while (data.size() < length)
+	{
+		id += 1 + NextRandom() % 3;
+		sprintf(item, "{\"id\":%u,\"name\":\"%s\",\"active\":%s,\"balance\":%u.%02u,\"tags\":[\"t%u\",\"t%u\"]},\n",
+			id, names[NextRandom() % 8], NextRandom() % 2 ? "true" : "false",
+			NextRandom() % 10000, NextRandom() % 100, NextRandom() % 20, NextRandom() % 20);
+		AppendString(data, item);
+	}
+
+	data.resize(length);
+	return data;
+}
+
+static std::vector<unsigned char> GenerateRandom(size_t length)
+{
+	std::vector<unsigned char> data(length);
+	for (size_t i = 0; i < length; i++)
+		data[i] = (unsigned char)(NextRandom() >> 24);
+	return data;
+}
+
+static bool ReadFile(const char* fileName, std::vector<unsigned char>& data)
+{
+	FILE* f = fopen(fileName, "rb");
+	if (f == NULL)
+		return false;
+	unsigned char buf[65536];
+	size_t cnt;
+	while ((cnt = fread(buf, 1, sizeof(buf), f)) > 0)
+		data.insert(data.end(), buf, buf + cnt);
+	fclose(f);
+	return true;
+}
+
+// emulates StreamEncoder: all blocks are in one buffer, so previous blocks are used as history
+static size_t CompressStream(const std::vector<unsigned char>& data, int blockSize, std::vector<unsigned char>& bufferIn, std::vector<unsigned char>& bufferOut, std::vector<int32_t>& blockSizes, std::vector<int32_t>& hashArr, int32_t level = BLAZER_STREAM_LEVEL_DEFAULT, int32_t flags = 0)
+{
+	// level 0 means default encoder with flags
+	hashArr.assign(blazer_stream_hash_size(level == 0 ? BLAZER_STREAM_LEVEL_DEFAULT : level), 0);
+	size_t outPos = 0;
+	int32_t len = (int32_t)data.size();
+	blockSizes.clear();
+	for (int32_t pos = 0; pos < len; pos += blockSize)
+	{
+		int32_t end = len - pos > blockSize ? pos + blockSize : len;
+		int32_t cnt = level == 0
+			? blazer_stream_compress_block_ex(&bufferIn[0], pos, end, 0, &bufferOut[outPos], 0, &hashArr[0], flags)
+			: blazer_stream_compress_block_level(&bufferIn[0], pos, end, 0, &bufferOut[outPos], 0, &hashArr[0], level);
+		blockSizes.push_back(cnt);
+		outPos += cnt;
+	}
+
+	return outPos;
+}
+
+static size_t DecompressStream(const std::vector<unsigned char>& compressed, const std::vector<int32_t>& blockSizes, std::vector<unsigned char>& bufferOut, size_t length)
+{
+	int32_t outPos = 0;
+	int32_t inPos = 0;
+	for (size_t i = 0; i < blockSizes.size(); i++)
+	{
+		outPos = blazer_stream_decompress_block((unsigned char*)&compressed[0], inPos, inPos + blockSizes[i], &bufferOut[0], outPos, (int32_t)length);
+		if (outPos < 0)
+			return 0;
+		inPos += blockSizes[i];
+	}
+
+	return outPos;
+}
+
+// emulates BlockEncoderNative: every block is independent, hash array is cleared after block
+static size_t CompressBlock(const std::vector<unsigned char>& data, int blockSize, std::vector<unsigned char>& bufferIn, std::vector<unsigned char>& bufferOut, std::vector<int32_t>& blockSizes, std::vector<int32_t>& hashArr)
+{
+	size_t outPos = 0;
+	int32_t len = (int32_t)data.size();
+	blockSizes.clear();
+	for (int32_t pos = 0; pos < len; pos += blockSize)
+	{
+		int32_t cnt = len - pos > blockSize ? blockSize : len - pos;
+		cnt = blazer_block_compress_block(&bufferIn[pos], 0, cnt, &bufferOut[outPos], 0, &hashArr[0]);
+		memset(&hashArr[0], 0, hashArr.size() * sizeof(int32_t));
+		blockSizes.push_back(cnt);
+		outPos += cnt;
+	}
+
+	return outPos;
+}
+
+static size_t DecompressBlock(const std::vector<unsigned char>& compressed, const std::vector<int32_t>& blockSizes, std::vector<unsigned char>& bufferOut, size_t length, int blockSize, std::vector<int32_t>& hashArr)
+{
+	size_t outPos = 0;
+	int32_t inPos = 0;
+	for (size_t i = 0; i < blockSizes.size(); i++)
+	{
+		int32_t maxOut = length - outPos > (size_t)blockSize ? blockSize : (int32_t)(length - outPos);
+		int32_t cnt = blazer_block_decompress_block((unsigned char*)&compressed[0], inPos, inPos + blockSizes[i], &bufferOut[outPos], 0, maxOut, &hashArr[0]);
+		memset(&hashArr[0], 0, hashArr.size() * sizeof(int32_t));
+		if (cnt < 0)
+			return 0;
+		outPos += cnt;
+		inPos += blockSizes[i];
+	}
+
+	return outPos;
+}
+
+// same blocks with context, hash table is not cleared between blocks
+static size_t CompressBlockCtx(const std::vector<unsigned char>& data, int blockSize, std::vector<unsigned char>& bufferIn, std::vector<unsigned char>& bufferOut, std::vector<int32_t>& blockSizes, blazer_ctx* ctx)
+{
+	size_t outPos = 0;
+	int32_t len = (int32_t)data.size();
+	blockSizes.clear();
+	for (int32_t pos = 0; pos < len; pos += blockSize)
+	{
+		int32_t cnt = len - pos > blockSize ? blockSize : len - pos;
+		cnt = blazer_ctx_block_compress(ctx, &bufferIn[pos], 0, cnt, &bufferOut[outPos], 0);
+		blockSizes.push_back(cnt);
+		outPos += cnt;
+	}
+
+	return outPos;
+}
+
+static size_t DecompressBlockCtx(const std::vector<unsigned char>& compressed, const std::vector<int32_t>& blockSizes, std::vector<unsigned char>& bufferOut, size_t length, int blockSize, blazer_ctx* ctx)
+{
+	size_t outPos = 0;
+	int32_t inPos = 0;
+	for (size_t i = 0; i < blockSizes.size(); i++)
+	{
+		int32_t maxOut = length - outPos > (size_t)blockSize ? blockSize : (int32_t)(length - outPos);
+		int32_t cnt = blazer_ctx_block_decompress(ctx, (unsigned char*)&compressed[0], inPos, inPos + blockSizes[i], &bufferOut[outPos], 0, maxOut);
+		if (cnt < 0)
+			return 0;
+		outPos += cnt;
+		inPos += blockSizes[i];
+	}
+
+	return outPos;
+}
+
+template <typename TFunc>
+static void Measure(const BenchOptions& options, TFunc func, size_t bytes, double& mbPerSecond, double& cyclesPerByte)
+{
+	// warm-up
+	func();
+
+	double bestSeconds = 1e100;
+	double bestCycles = 0;
+	double total = 0;
+	int iterations = 0;
+	Timer timer;
+	while (total < options.minTime || iterations < 3)
+	{
+		timer.Start();
+		func();
+		double seconds = timer.Seconds();
+		double cycles = timer.Cycles();
+		if (seconds < bestSeconds)
+		{
+			bestSeconds = seconds;
+			bestCycles = cycles;
+		}
+
+		total += seconds;
+		iterations++;
+	}
+
+	mbPerSecond = bytes / bestSeconds / 1048576;
+	cyclesPerByte = bestCycles / bytes;
+}
+
+static void AddResult(std::vector<BenchResult>& results, const char* corpus, const char* algorithm, const char* operation, int blockSize, size_t inputSize, size_t outputSize, double mbPerSecond, double cyclesPerByte)
+{
+	BenchResult r;
+	r.corpus = corpus;
+	r.algorithm = algorithm;
+	r.operation = operation;
+	r.blockSize = blockSize;
+	r.inputSize = inputSize;
+	r.outputSize = outputSize;
+	r.mbPerSecond = mbPerSecond;
+	r.cyclesPerByte = cyclesPerByte;
+	results.push_back(r);
+	fprintf(_log, "%-12s %-8s %-10s %9d %7.3f%% %9.1f MB/s %7.3f c/b\n",
+		corpus, algorithm, operation, blockSize, 100.0 * outputSize / (inputSize ? inputSize : 1), mbPerSecond, cyclesPerByte);
+}
+
+static void BenchCrc32C(const BenchOptions& options, const Corpus& corpus, std::vector<BenchResult>& results)
+{
+	const std::vector<unsigned char>& data = corpus.data;
+	uint32_t crc = 0;
+	double mbPerSecond, cyclesPerByte;
+	Measure(options, [&]() { crc = crc32c_append(0, &data[0], data.size()); }, data.size(), mbPerSecond, cyclesPerByte);
+	AddResult(results, corpus.name.c_str(), "crc32c", "checksum", 0, data.size(), 4, mbPerSecond, cyclesPerByte);
+
+	// unaligned data
+	Measure(options, [&]() { crc = crc32c_append(0, &data[1], data.size() - 1); }, data.size() - 1, mbPerSecond, cyclesPerByte);
+	AddResult(results, corpus.name.c_str(), "crc32c", "unaligned", 0, data.size() - 1, 4, mbPerSecond, cyclesPerByte);
+}
+
+static void BenchData(const BenchOptions& options, const Corpus& corpus, std::vector<BenchResult>& results)
+{
+	const std::vector<unsigned char>& data = corpus.data;
+	size_t length = data.size();
+	if (length == 0)
+		return;
+
+	// additional space for algorithms, which write by 4 bytes
+	std::vector<unsigned char> bufferIn(data);
+	bufferIn.resize(length + 8);
+	std::vector<unsigned char> compressed(length + (length >> 8) + 1024 + 8);
+	std::vector<unsigned char> decompressed(length + 8);
+	std::vector<int32_t> blockSizes;
+	std::vector<int32_t> hashArr(65536);
+	std::vector<unsigned char> parallelBuffer;
+	std::vector<int32_t> parallelSizes;
+	std::vector<blazer_block_frame> parallelFrames;
+	blazer_ctx* ctx = blazer_ctx_create(NULL, 0);
+
+	for (int blockSize = options.minBlockSize; blockSize <= options.maxBlockSize; blockSize <<= 1)
+	{
+		// small blocks have large overhead for compressed size, buffer should be large enough
+		compressed.resize(length + (length / blockSize + 1) * ((blockSize >> 8) + 16) + 8);
+		size_t comprSize = 0;
+		double mbPerSecond, cyclesPerByte;
+
+		// other levels of stream encoder, default level is measured below with decompression
+		for (int32_t level = BLAZER_STREAM_LEVEL_MIN; level <= BLAZER_STREAM_LEVEL_MAX; level++)
+		{
+			if (level == BLAZER_STREAM_LEVEL_DEFAULT)
+				continue;
+			char algorithm[16];
+			sprintf(algorithm, "stream-%d", level);
+			Measure(options, [&]() { comprSize = CompressStream(data, blockSize, bufferIn, compressed, blockSizes, hashArr, level); }, length, mbPerSecond, cyclesPerByte);
+			AddResult(results, corpus.name.c_str(), algorithm, "compress", blockSize, length, comprSize, mbPerSecond, cyclesPerByte);
+		}
+
+		// lazy matching against greedy default below
+		Measure(options, [&]() { comprSize = CompressStream(data, blockSize, bufferIn, compressed, blockSizes, hashArr, 0, BLAZER_STREAM_LAZY); }, length, mbPerSecond, cyclesPerByte);
+		AddResult(results, corpus.name.c_str(), "stream-l", "compress", blockSize, length, comprSize, mbPerSecond, cyclesPerByte);
+
+		Measure(options, [&]() { comprSize = CompressStream(data, blockSize, bufferIn, compressed, blockSizes, hashArr); }, length, mbPerSecond, cyclesPerByte);
+		AddResult(results, corpus.name.c_str(), "stream", "compress", blockSize, length, comprSize, mbPerSecond, cyclesPerByte);
+		size_t decomprSize = 0;
+		Measure(options, [&]() { decomprSize = DecompressStream(compressed, blockSizes, decompressed, length); }, length, mbPerSecond, cyclesPerByte);
+		if (decomprSize != length || memcmp(&decompressed[0], &data[0], length) != 0)
+			fprintf(stderr, "Data Integrity failed for stream %s %d\n", corpus.name.c_str(), blockSize);
+		AddResult(results, corpus.name.c_str(), "stream", "decompress", blockSize, length, comprSize, mbPerSecond, cyclesPerByte);
+
+		Measure(options, [&]() { comprSize = CompressBlock(data, blockSize, bufferIn, compressed, blockSizes, hashArr); }, length, mbPerSecond, cyclesPerByte);
+		AddResult(results, corpus.name.c_str(), "block", "compress", blockSize, length, comprSize, mbPerSecond, cyclesPerByte);
+		Measure(options, [&]() { decomprSize = DecompressBlock(compressed, blockSizes, decompressed, length, blockSize, hashArr); }, length, mbPerSecond, cyclesPerByte);
+		if (decomprSize != length || memcmp(&decompressed[0], &data[0], length) != 0)
+			fprintf(stderr, "Data Integrity failed for block %s %d\n", corpus.name.c_str(), blockSize);
+		AddResult(results, corpus.name.c_str(), "block", "decompress", blockSize, length, comprSize, mbPerSecond, cyclesPerByte);
+
+		Measure(options, [&]() { comprSize = CompressBlockCtx(data, blockSize, bufferIn, compressed, blockSizes, ctx); }, length, mbPerSecond, cyclesPerByte);
+		AddResult(results, corpus.name.c_str(), "block-ctx", "compress", blockSize, length, comprSize, mbPerSecond, cyclesPerByte);
+		Measure(options, [&]() { decomprSize = DecompressBlockCtx(compressed, blockSizes, decompressed, length, blockSize, ctx); }, length, mbPerSecond, cyclesPerByte);
+		if (decomprSize != length || memcmp(&decompressed[0], &data[0], length) != 0)
+			fprintf(stderr, "Data Integrity failed for block-ctx %s %d\n", corpus.name.c_str(), blockSize);
+		AddResult(results, corpus.name.c_str(), "block-ctx", "decompress", blockSize, length, comprSize, mbPerSecond, cyclesPerByte);
+
+		parallelBuffer.resize((size_t)blazer_block_compress_bound(length, blockSize));
+		parallelSizes.resize(length / blockSize + 1);
+		Measure(options, [&]() { comprSize = (size_t)blazer_block_compress_parallel(&bufferIn[0], length, blockSize, &parallelBuffer[0], &parallelSizes[0], options.threads); }, length, mbPerSecond, cyclesPerByte);
+		AddResult(results, corpus.name.c_str(), "block-mt", "compress", blockSize, length, comprSize, mbPerSecond, cyclesPerByte);
+
+		size_t blockCount = (length + blockSize - 1) / blockSize;
+		parallelFrames.resize(blockCount);
+		int64_t inOffset = 0;
+		for (size_t i = 0; i < blockCount; i++)
+		{
+			blazer_block_frame& frame = parallelFrames[i];
+			frame.inOffset = inOffset;
+			frame.inLength = parallelSizes[i];
+			frame.outOffset = (int64_t)i * blockSize;
+			frame.outLength = blockSize;
+			frame.crc = 0;
+			frame.isCompressed = 1;
+			inOffset += parallelSizes[i];
+		}
+
+		// decompressor writes results into frames, so they are restored before every run
+		std::vector<blazer_block_frame> frames(parallelFrames);
+		decompressed.resize(blockCount * blockSize);
+		Measure(options, [&]() {
+			memcpy(&frames[0], &parallelFrames[0], sizeof(blazer_block_frame) * blockCount);
+			decomprSize = (size_t)blazer_block_decompress_parallel(&parallelBuffer[0], comprSize, &decompressed[0], decompressed.size(), &frames[0], (int32_t)blockCount, 0, options.threads);
+		}, length, mbPerSecond, cyclesPerByte);
+		if (decomprSize != length || memcmp(&decompressed[0], &data[0], length) != 0)
+			fprintf(stderr, "Data Integrity failed for block-mt %s %d\n", corpus.name.c_str(), blockSize);
+		AddResult(results, corpus.name.c_str(), "block-mt", "decompress", blockSize, length, comprSize, mbPerSecond, cyclesPerByte);
+	}
+
+	blazer_ctx_destroy(ctx);
+	BenchCrc32C(options, corpus, results);
+}
+
+static void WriteJsonString(FILE* f, const std::string& s)
+{
+	fputc('"', f);
+	for (size_t i = 0; i < s.size(); i++)
+	{
+		unsigned char c = (unsigned char)s[i];
+		if (c == '"' || c == '\\') fprintf(f, "\\%c", c);
+		else if (c < 0x20) fprintf(f, "\\u%04x", c);
+		else fputc(c, f);
+	}
+
+	fputc('"', f);
+}
+
+static void WriteJson(FILE* f, const BenchOptions& options, const std::vector<BenchResult>& results)
+{
+	fprintf(f, "{\n  \"min_time_ms\": %.0f,\n  \"threads\": %d,\n", options.minTime * 1000, options.threads);
+#ifdef BENCH_HAS_TSC
+	fprintf(f, "  \"cycles_source\": \"tsc\",\n");
+#else
+	fprintf(f, "  \"cycles_source\": null,\n");
+#endif
+	fprintf(f, "  \"results\": [\n");
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchResult& r = results[i];
+		fprintf(f, "    { \"corpus\": ");
+		WriteJsonString(f, r.corpus);
+		fprintf(f, ", \"algorithm\": \"%s\", \"operation\": \"%s\", \"block_size\": %d, \"input_bytes\": %llu, \"output_bytes\": %llu, \"ratio\": %.5f, \"mb_per_s\": %.2f, ",
+			r.algorithm.c_str(), r.operation.c_str(), r.blockSize, (unsigned long long)r.inputSize, (unsigned long long)r.outputSize,
+			r.inputSize ? (double)r.outputSize / r.inputSize : 0.0, r.mbPerSecond);
+#ifdef BENCH_HAS_TSC
+		fprintf(f, "\"cycles_per_byte\": %.4f }", r.cyclesPerByte);
+#else
+		fprintf(f, "\"cycles_per_byte\": null }");
+#endif
+		fprintf(f, i + 1 < results.size() ? ",\n" : "\n");
+	}
+
+	fprintf(f, "  ]\n}\n");
+}
+
+static long long ParseSize(const char* s)
+{
+	char* end;
+	long long v = strtoll(s, &end, 10);
+	if (*end == 'k' || *end == 'K') v <<= 10;
+	else if (*end == 'm' || *end == 'M') v <<= 20;
+	return v;
+}
+
+static bool ParseOptions(int argc, char** argv, BenchOptions& options)
+{
+	options.minBlockSize = 512;
+	options.maxBlockSize = 16 << 20;
+	options.corpusSize = 16 << 20;
+	options.minTime = 0.3;
+	options.threads = 0;
+	options.synthetic = true;
+	options.jsonFile = NULL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (strcmp(arg, "--min-block") == 0 && hasValue) options.minBlockSize = (int)ParseSize(argv[++i]);
+		else if (strcmp(arg, "--max-block") == 0 && hasValue) options.maxBlockSize = (int)ParseSize(argv[++i]);
+		else if (strcmp(arg, "--corpus-size") == 0 && hasValue) options.corpusSize = (size_t)ParseSize(argv[++i]);
+		else if (strcmp(arg, "--time") == 0 && hasValue) options.minTime = atof(argv[++i]) / 1000;
+		else if (strcmp(arg, "--threads") == 0 && hasValue) options.threads = atoi(argv[++i]);
+		else if (strcmp(arg, "--json") == 0 && hasValue) options.jsonFile = argv[++i];
+		else if (strcmp(arg, "--no-synthetic") == 0) options.synthetic = false;
+		else if (arg[0] == '-' && arg[1] == '-')
+		{
+			fprintf(stderr, "Unknown option: %s\n", arg);
+			return false;
+		}
+		else options.files.push_back(arg);
+	}
+
+	// block sizes are same as InBlockSize* flags: from 512 bytes to 16 megabytes
+	if (options.minBlockSize < 512 || options.maxBlockSize > (16 << 20) || options.minBlockSize > options.maxBlockSize)
+	{
+		fprintf(stderr, "Block size should be between 512 and 16M\n");
+		return false;
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	BenchOptions options;
+	if (!ParseOptions(argc, argv, options))
+		return 2;
+
+	if (options.jsonFile != NULL && strcmp(options.jsonFile, "-") == 0)
+		_log = stderr;
+
+	std::vector<Corpus> corpora;
+	if (options.synthetic)
+	{
+		Corpus c;
+		c.name = "logs"; c.data = GenerateLogs(options.corpusSize); corpora.push_back(c);
+		c.name = "json"; c.data = GenerateJson(options.corpusSize); corpora.push_back(c);
+		c.name = "random"; c.data = GenerateRandom(options.corpusSize); corpora.push_back(c);
+		c.name = "zeros"; c.data.assign(options.corpusSize, 0); corpora.push_back(c);
+	}
+
+	for (size_t i = 0; i < options.files.size(); i++)
+	{
+		Corpus c;
+		c.name = options.files[i];
+		if (!ReadFile(c.name.c_str(), c.data))
+		{
+			fprintf(stderr, "Cannot read file %s\n", c.name.c_str());
+			return 2;
+		}
+
+		corpora.push_back(c);
+	}
+
+	std::vector<BenchResult> results;
+	for (size_t i = 0; i < corpora.size(); i++)
+		BenchData(options, corpora[i], results);
+
+	if (options.jsonFile != NULL)
+	{
+		FILE* f = strcmp(options.jsonFile, "-") == 0 ? stdout : fopen(options.jsonFile, "w");
+		if (f == NULL)
+		{
+			fprintf(stderr, "Cannot write to %s\n", options.jsonFile);
+			return 2;
+		}
+
+		WriteJson(f, options, results);
+		if (f != stdout)
+			fclose(f);
+	}
+
+	return 0;
+}
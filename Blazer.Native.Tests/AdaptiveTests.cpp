@@ -0,0 +1,148 @@
+// Checks adaptive encoding: probe should separate random and compressible data, adaptive frames of mixed data should
+// be decoded by usual decoder, incompressible blocks should be stored without compression and counted in statistics
+
+#include "TestHelper.h"
+#include "Blazer.h"
+
+#include <chrono>
+
+static const size_t ChunkSize = 300000;
+
+// chunks of compressible and random data one after another, high bits of generator are used, because low ones
+// repeat after 64KB
+static std::vector<unsigned char> GenerateMixedData(size_t chunkCount, uint32_t seed)
+{
+	std::vector<unsigned char> data = GenerateTestData(ChunkSize * chunkCount, seed);
+	TestRandom rnd(seed);
+	for (size_t i = 1; i < chunkCount; i += 2)
+	{
+		for (size_t j = i * ChunkSize; j < (i + 1) * ChunkSize; j++)
+			data[j] = (unsigned char)(rnd.Next() >> 16);
+	}
+
+	return data;
+}
+
+static void TestProbe()
+{
+	std::vector<unsigned char> data = GenerateMixedData(2, 1);
+	CHECK(blazer_probe_block(&data[0], (int32_t)ChunkSize) > 500);
+	CHECK(blazer_probe_block(&data[ChunkSize], (int32_t)ChunkSize) < 10);
+	// small blocks are scanned fully
+	CHECK(blazer_probe_block(&data[0], 1000) > 300);
+	CHECK_EQ(blazer_probe_block(&data[0], 3), 0);
+
+	// random data repeated after 100KB is found by sampled segments
+	std::vector<unsigned char> repeated(1 << 20);
+	memcpy(&repeated[0], &data[ChunkSize], 100000);
+	for (size_t i = 100000; i < repeated.size(); i++)
+		repeated[i] = repeated[i - 100000];
+	CHECK(blazer_probe_block(&repeated[0], (int32_t)repeated.size()) > 800);
+}
+
+static std::vector<unsigned char> Encode(const std::vector<unsigned char>& data, uint32_t flags, int32_t algorithm, int32_t highLevel, blazer_adaptive_stats* stats)
+{
+	blazer_frame_encoder* encoder = blazer_frame_encoder_create(flags, algorithm, 0);
+	CHECK_EQ(blazer_frame_encoder_set_adaptive(encoder, highLevel), 0);
+	std::vector<unsigned char> out((size_t)blazer_frame_encoder_bound(encoder, data.size()));
+	int64_t written = blazer_frame_encoder_write(encoder, &data[0], data.size(), &out[0], out.size());
+	CHECK(written > 0);
+	written += blazer_frame_encoder_finish(encoder, &out[0] + written, out.size() - written);
+	out.resize((size_t)written);
+	blazer_frame_encoder_get_adaptive_stats(encoder, stats);
+	blazer_frame_encoder_destroy(encoder);
+	return out;
+}
+
+static void Decode(const std::vector<unsigned char>& framed, const std::vector<unsigned char>& data)
+{
+	blazer_frame_decoder* decoder = blazer_frame_decoder_create(BLAZER_FLAG_INCLUDE_HEADER);
+	std::vector<unsigned char> decoded(data.size() + 1);
+	size_t inLength = framed.size();
+	size_t outLength = decoded.size();
+	CHECK_EQ(blazer_frame_decode(decoder, &framed[0], &inLength, &decoded[0], &outLength), 1);
+	CHECK_EQ(outLength, data.size());
+	CHECK(memcmp(&decoded[0], &data[0], data.size()) == 0);
+	blazer_frame_decoder_destroy(decoder);
+}
+
+static void TestFrame(uint32_t flags, int32_t algorithm, int32_t highLevel)
+{
+	std::vector<unsigned char> data = GenerateMixedData(20, 2);
+	blazer_adaptive_stats stats;
+	std::vector<unsigned char> framed = Encode(data, flags, algorithm, highLevel, &stats);
+	Decode(framed, data);
+
+	CHECK_EQ(stats.rawBytes + stats.compressedBytes + stats.highBytes, data.size());
+	// about half of data is random, blocks with both kinds of data are compressed
+	CHECK(stats.rawBytes > (int64_t)data.size() / 4);
+	CHECK(stats.rawBytes <= (int64_t)data.size() / 2);
+	CHECK(stats.expandedBlocks <= 2);
+	CHECK(stats.probeNanoseconds > 0);
+	if (highLevel != 0)
+		CHECK(stats.highBlocks > 0);
+	else
+		CHECK_EQ(stats.highBlocks, 0);
+}
+
+static void TestErrors()
+{
+	blazer_frame_encoder* encoder = blazer_frame_encoder_create(BLAZER_FLAGS_DEFAULT_BLOCK, BLAZER_ALGORITHM_NO_COMPRESS, 0);
+	CHECK_EQ(blazer_frame_encoder_set_adaptive(encoder, 0), -1);
+	blazer_frame_encoder_destroy(encoder);
+
+	// high level is supported by stream algorithm only
+	encoder = blazer_frame_encoder_create(BLAZER_FLAGS_DEFAULT_BLOCK, BLAZER_ALGORITHM_BLOCK, 0);
+	CHECK_EQ(blazer_frame_encoder_set_adaptive(encoder, BLAZER_STREAM_LEVEL_HIGH), -1);
+	CHECK_EQ(blazer_frame_encoder_set_adaptive(encoder, 0), 0);
+	CHECK_EQ(blazer_frame_encoder_set_adaptive(encoder, 0), -1);
+	blazer_frame_encoder_destroy(encoder);
+
+	encoder = blazer_frame_encoder_create(BLAZER_FLAGS_DEFAULT_STREAM, BLAZER_ALGORITHM_STREAM, 0);
+	CHECK_EQ(blazer_frame_encoder_set_adaptive(encoder, BLAZER_STREAM_LEVEL_MAX + 1), -1);
+	unsigned char data[100] = { 0 };
+	std::vector<unsigned char> out((size_t)blazer_frame_encoder_bound(encoder, sizeof(data)));
+	CHECK(blazer_frame_encoder_write(encoder, data, sizeof(data), &out[0], out.size()) >= 0);
+	CHECK_EQ(blazer_frame_encoder_set_adaptive(encoder, 0), -1);
+	// stats of encoder without probe
+	blazer_adaptive_stats stats;
+	blazer_frame_encoder_get_adaptive_stats(encoder, &stats);
+	CHECK_EQ(stats.rawBlocks + stats.compressedBlocks + stats.highBlocks, 0);
+	blazer_frame_encoder_destroy(encoder);
+}
+
+// prints speed of encoder for incompressible data with and without probe
+static void Benchmark()
+{
+	std::vector<unsigned char> data(16 << 20);
+	TestRandom rnd(3);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = (unsigned char)(rnd.Next() >> 16);
+
+	double times[2];
+	for (int32_t isAdaptive = 0; isAdaptive < 2; isAdaptive++)
+	{
+		blazer_frame_encoder* encoder = blazer_frame_encoder_create(BLAZER_FLAGS_DEFAULT_STREAM, BLAZER_ALGORITHM_STREAM, 0);
+		if (isAdaptive)
+			CHECK_EQ(blazer_frame_encoder_set_adaptive(encoder, 0), 0);
+		std::vector<unsigned char> out((size_t)blazer_frame_encoder_bound(encoder, data.size()));
+		auto start = std::chrono::steady_clock::now();
+		CHECK(blazer_frame_encoder_write(encoder, &data[0], data.size(), &out[0], out.size()) > 0);
+		times[isAdaptive] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		blazer_frame_encoder_destroy(encoder);
+	}
+
+	printf("random data: %.0f MB/s, adaptive %.0f MB/s\n", data.size() / times[0] / 1e6, data.size() / times[1] / 1e6);
+}
+
+int main()
+{
+	TestProbe();
+	TestFrame(BLAZER_FLAGS_DEFAULT_STREAM, BLAZER_ALGORITHM_STREAM, 0);
+	TestFrame(BLAZER_FLAGS_DEFAULT_STREAM, BLAZER_ALGORITHM_STREAM, BLAZER_STREAM_LEVEL_HIGH);
+	// blocks of 128KB
+	TestFrame(BLAZER_FLAGS_DEFAULT | 8, BLAZER_ALGORITHM_BLOCK, 0);
+	TestErrors();
+	Benchmark();
+	return TEST_RESULT();
+}
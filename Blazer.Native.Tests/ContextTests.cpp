@@ -0,0 +1,108 @@
+// Checks that context gives same result as independent block calls while its hash table is reused without clearing,
+// including data of previous calls, which should not be visible for next blocks
+
+#include "TestHelper.h"
+#include "Blazer.h"
+
+static int32_t CompressReference(std::vector<unsigned char>& data, int32_t offset, int32_t length, std::vector<unsigned char>& compressed)
+{
+	std::vector<int32_t> hashArr(65536);
+	return blazer_block_compress_block(&data[0], offset, length, &compressed[0], 0, &hashArr[0]);
+}
+
+static void TestSameAsBlock(blazer_ctx* ctx)
+{
+	static const int32_t sizes[] = { 1, 3, 4, 5, 17, 100, 4096, 65536, 300000, 7, 4096 };
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		for (uint32_t seed = 1; seed <= 3; seed++)
+		{
+			std::vector<unsigned char> data = GenerateTestData(sizes[i], seed + (uint32_t)i);
+			data.resize(sizes[i] + 8);
+			std::vector<unsigned char> expected(sizes[i] + (sizes[i] >> 8) + 16);
+			std::vector<unsigned char> compressed(expected.size());
+			int32_t expectedLength = CompressReference(data, 0, sizes[i], expected);
+			int32_t comprLength = blazer_ctx_block_compress(ctx, &data[0], 0, sizes[i], &compressed[0], 0);
+			CHECK_EQ(comprLength, expectedLength);
+			CHECK(memcmp(&compressed[0], &expected[0], expectedLength) == 0);
+
+			std::vector<unsigned char> decompressed(sizes[i] + BLAZER_DECOMPRESS_MARGIN);
+			CHECK_EQ(blazer_ctx_block_decompress(ctx, &compressed[0], 0, comprLength, &decompressed[0], 0, sizes[i]), sizes[i]);
+			CHECK(memcmp(&decompressed[0], &data[0], sizes[i]) == 0);
+		}
+	}
+}
+
+// references to positions of previous calls should be rejected as for zeroed table
+static void TestStaleReferences(blazer_ctx* ctx)
+{
+	std::vector<unsigned char> data = GenerateTestData(20000, 9);
+	data.resize(data.size() + 8);
+	std::vector<unsigned char> compressed(data.size() + (data.size() >> 8) + 16);
+	std::vector<unsigned char> decompressed(data.size());
+	int32_t comprLength = blazer_ctx_block_compress(ctx, &data[0], 0, 20000, &compressed[0], 0);
+	CHECK_EQ(blazer_ctx_block_decompress(ctx, &compressed[0], 0, comprLength, &decompressed[0], 0, 20000), 20000);
+
+	int failed = 0;
+	for (int32_t key = 0; key < 0xffff; key++)
+	{
+		unsigned char token[3] = { 0x80, (unsigned char)key, (unsigned char)(key >> 8) };
+		if (blazer_ctx_block_decompress(ctx, token, 0, 3, &decompressed[0], 0, 100) != -3)
+			failed++;
+	}
+
+	CHECK_EQ(failed, 0);
+}
+
+// data at the end of large buffer moves base of positions quickly, so table is cleared several times
+static void TestBaseOverflow(blazer_ctx* ctx)
+{
+	const int32_t bufferLength = 64 << 20;
+	const int32_t length = 5000;
+	std::vector<unsigned char> buffer(bufferLength + 8);
+	std::vector<unsigned char> expected(length + 64);
+	std::vector<unsigned char> compressed(length + 64);
+	for (uint32_t iter = 0; iter < 80; iter++)
+	{
+		std::vector<unsigned char> data = GenerateTestData(length, iter % 3);
+		memcpy(&buffer[bufferLength - length], &data[0], length);
+		int32_t expectedLength = CompressReference(buffer, bufferLength - length, bufferLength, expected);
+		int32_t comprLength = blazer_ctx_block_compress(ctx, &buffer[0], bufferLength - length, bufferLength, &compressed[0], 0);
+		CHECK_EQ(comprLength, expectedLength);
+		CHECK(memcmp(&compressed[0], &expected[0], expectedLength) == 0);
+
+		memset(&buffer[bufferLength - length], 0, length);
+		CHECK_EQ(blazer_ctx_block_decompress(ctx, &compressed[0], 0, comprLength, &buffer[0], bufferLength - length, bufferLength), bufferLength);
+		CHECK(memcmp(&buffer[bufferLength - length], &data[0], length) == 0);
+	}
+}
+
+static void TestMemory()
+{
+	size_t size = blazer_ctx_size();
+	CHECK(size >= 65536 * sizeof(int32_t));
+	std::vector<unsigned char> arena(size + 3, 0xcc);
+	CHECK(blazer_ctx_create(&arena[3], size - 1) == NULL);
+
+	// memory of caller can be unaligned and should not be zeroed
+	blazer_ctx* ctx = blazer_ctx_create(&arena[3], size);
+	CHECK(ctx != NULL);
+	TestSameAsBlock(ctx);
+	blazer_ctx_reset(ctx);
+	TestSameAsBlock(ctx);
+	blazer_ctx_destroy(ctx);
+}
+
+int main()
+{
+	blazer_ctx* ctx = blazer_ctx_create(NULL, 0);
+	CHECK(ctx != NULL);
+	TestSameAsBlock(ctx);
+	TestStaleReferences(ctx);
+	TestBaseOverflow(ctx);
+	TestSameAsBlock(ctx);
+	blazer_ctx_destroy(ctx);
+
+	TestMemory();
+	return TEST_RESULT();
+}
@@ -0,0 +1,119 @@
+// Checks kernels of crc32c: every kernel which is supported by processor should give same result as bitwise
+// calculation for all lengths around thresholds of kernels and for unaligned data
+
+#include "TestHelper.h"
+// internal header defines export attributes, so it is included first
+#include "Crc32c.h"
+#include "Blazer.h"
+
+#include <chrono>
+
+static uint32_t CrcBitwise(uint32_t crc, const unsigned char* data, size_t length)
+{
+	crc = ~crc;
+	for (size_t i = 0; i < length; i++)
+	{
+		crc ^= data[i];
+		for (int32_t k = 0; k < 8; k++)
+			crc = (crc & 1) != 0 ? (crc >> 1) ^ 0x82f63b78 : crc >> 1;
+	}
+	return ~crc;
+}
+
+static void TestKernel(blazer_crc32c_func kernel, const std::vector<unsigned char>& data)
+{
+	CHECK_EQ(kernel(0, (const uint8_t*)"123456789", 9), 0xe3069283);
+	CHECK_EQ(kernel(0, NULL, 0), 0);
+
+	TestRandom rnd(1);
+	for (size_t length = 0; length < 4200; length += length < 1100 ? 1 : 13)
+	{
+		size_t offset = rnd.Next() % 64;
+		uint32_t crc = rnd.Next();
+		CHECK_EQ(kernel(crc, &data[offset], length), CrcBitwise(crc, &data[offset], length));
+	}
+
+	// long lengths are compared with table version, which is checked above
+	blazer_crc32c_func table = blazer_crc32c_kernel(BLAZER_CRC32C_TABLE);
+	for (int32_t i = 0; i < 20; i++)
+	{
+		size_t offset = rnd.Next() % 64;
+		size_t length = rnd.Next() % (data.size() - offset);
+		uint32_t crc = rnd.Next();
+		CHECK_EQ(kernel(crc, &data[offset], length), table(crc, &data[offset], length));
+	}
+
+	// appending by parts gives same result
+	uint32_t crc = 0;
+	for (size_t pos = 0; pos < data.size();)
+	{
+		size_t cnt = rnd.Next() % 100000;
+		if (cnt > data.size() - pos)
+			cnt = data.size() - pos;
+		crc = kernel(crc, &data[pos], cnt);
+		pos += cnt;
+	}
+	CHECK_EQ(crc, table(0, &data[0], data.size()));
+}
+
+static void TestCombine(const std::vector<unsigned char>& data)
+{
+	TestRandom rnd(3);
+	for (int32_t i = 0; i < 200; i++)
+	{
+		size_t lengthA = rnd.Next() % 5000;
+		size_t lengthB = i < 100 ? i : rnd.Next() % (data.size() - lengthA);
+		uint32_t crcA = crc32c_append(i, &data[0], lengthA);
+		uint32_t crcB = crc32c_append(0, &data[lengthA], lengthB);
+		CHECK_EQ(crc32c_combine(crcA, crcB, lengthB), crc32c_append(crcA, &data[lengthA], lengthB));
+	}
+
+	// powers of x repeat with period of 2^31 - 1 bits, so long lengths (which use all powers) can be checked without data
+	for (uint64_t length = 1; length < ((uint64_t)1 << 40); length = length * 3 + 1)
+		CHECK_EQ(crc32c_combine(0x12345678, 5, length), crc32c_combine(0x12345678, 5, length + 0x7fffffff));
+	CHECK_EQ(crc32c_combine(0x12345678, 5, 0), 0x12345678 ^ 5);
+}
+
+static void TestParallel(const std::vector<unsigned char>& data)
+{
+	const size_t lengths[] = { 0, 100, 1 << 20, (1 << 20) + 1, 3 << 20, data.size() - 7 };
+	for (size_t length : lengths)
+	{
+		uint32_t expected = crc32c_append(7, &data[0], length);
+		for (int32_t threadCount = 0; threadCount <= 3; threadCount++)
+			CHECK_EQ(crc32c_append_parallel(7, &data[0], length, threadCount), expected);
+	}
+}
+
+int main()
+{
+	std::vector<unsigned char> data(3 << 20);
+	TestRandom rnd(2);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = (unsigned char)rnd.Next();
+
+	static const char* names[] = { "table", "hw", "pclmul", "avx512" };
+	for (int32_t kernel = BLAZER_CRC32C_TABLE; kernel <= BLAZER_CRC32C_AVX512; kernel++)
+	{
+		blazer_crc32c_func func = blazer_crc32c_kernel(kernel);
+		if (func == NULL)
+		{
+			printf("%s: not supported\n", names[kernel]);
+			continue;
+		}
+
+		TestKernel(func, data);
+		auto start = std::chrono::steady_clock::now();
+		uint32_t crc = 0;
+		for (int32_t i = 0; i < 10; i++)
+			crc = func(crc, &data[0], data.size());
+		double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		printf("%s: %.0f MB/s (%08x)\n", names[kernel], 10 * data.size() / time / 1e6, crc);
+	}
+
+	TestCombine(data);
+	TestParallel(data);
+	CHECK_EQ(blazer_crc32c_kernel(100), NULL);
+	CHECK_EQ(crc32c_append(0, &data[0], data.size()), blazer_crc32c_kernel(BLAZER_CRC32C_TABLE)(0, &data[0], data.size()));
+	return TEST_RESULT();
+}
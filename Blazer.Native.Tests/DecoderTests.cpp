@@ -0,0 +1,243 @@
+// Checks wide-copy paths of decoders: short overlapping back references, long copies and buffer ends,
+// and that malformed data is rejected without reading or writing out of buffers (run under address sanitizer)
+
+#include "TestHelper.h"
+#include "Blazer.h"
+
+static const int HistoryLength = 300;
+
+static void WriteLen(std::vector<unsigned char>& out, int len)
+{
+	if (len < 253)
+	{
+		out.push_back((unsigned char)len);
+	}
+	else if (len < 253 + 256)
+	{
+		out.push_back(253);
+		out.push_back((unsigned char)(len - 253));
+	}
+	else if (len < 253 + 256 + 65536)
+	{
+		out.push_back(254);
+		len -= 253 + 256;
+		out.push_back((unsigned char)len);
+		out.push_back((unsigned char)(len >> 8));
+	}
+	else
+	{
+		out.push_back(255);
+		len -= 253 + 256 * 256;
+		for (int i = 0; i < 4; i++)
+			out.push_back((unsigned char)(len >> (i * 8)));
+	}
+}
+
+// appends token of stream format: literals followed by back reference
+static void AppendToken(std::vector<unsigned char>& out, const unsigned char* lit, int litCnt, int seqCnt, int backRef)
+{
+	int litFirst = litCnt < 7 ? litCnt : 7;
+	int seqFirst = seqCnt - 4 < 15 ? seqCnt - 4 : 15;
+	if (backRef <= 256)
+	{
+		out.push_back((unsigned char)((litFirst << 4) | seqFirst));
+		out.push_back((unsigned char)(backRef - 1));
+	}
+	else
+	{
+		out.push_back((unsigned char)(0x80 | (litFirst << 4) | seqFirst));
+		out.push_back((unsigned char)(backRef - 257));
+		out.push_back((unsigned char)((backRef - 257) >> 8));
+	}
+
+	if (litFirst == 7)
+		WriteLen(out, litCnt - 7);
+	if (seqFirst == 15)
+		WriteLen(out, seqCnt - 4 - 15);
+	out.insert(out.end(), lit, lit + litCnt);
+}
+
+// byte by byte decoding of tokens, which were written by AppendToken
+static void AppendReference(std::vector<unsigned char>& expected, const unsigned char* lit, int litCnt, int seqCnt, int backRef)
+{
+	expected.insert(expected.end(), lit, lit + litCnt);
+	for (int i = 0; i < seqCnt; i++)
+		expected.push_back(expected[expected.size() - backRef]);
+}
+
+// decodes data into buffer of exact size and into buffer with margin, result should be same
+static void CheckDecode(const std::vector<unsigned char>& compressed, const std::vector<unsigned char>& expected)
+{
+	std::vector<unsigned char> in(compressed);
+	for (int margin = 0; margin <= BLAZER_DECOMPRESS_MARGIN; margin += BLAZER_DECOMPRESS_MARGIN)
+	{
+		std::vector<unsigned char> out(expected.size() + margin);
+		memcpy(&out[0], &expected[0], HistoryLength);
+		int32_t res = blazer_stream_decompress_block(&in[0], 0, (int32_t)in.size(), &out[0], HistoryLength, (int32_t)expected.size());
+		CHECK_EQ(res, (int32_t)expected.size());
+		out.resize(expected.size());
+		CHECK(out == expected);
+	}
+}
+
+static void TestBackRefs()
+{
+	static const int seqLengths[] = { 4, 5, 15, 16, 17, 19, 31, 32, 33, 63, 64, 65, 100, 300, 1000 };
+	static const int litLengths[] = { 0, 1, 7, 16, 17, 40, 65, 300 };
+	std::vector<unsigned char> lit = GenerateTestData(1000, 5);
+
+	for (int backRef = 1; backRef <= HistoryLength; backRef += backRef < 70 ? 1 : 37)
+	{
+		std::vector<unsigned char> expected = GenerateTestData(HistoryLength, backRef);
+		std::vector<unsigned char> compressed;
+		for (size_t s = 0; s < sizeof(seqLengths) / sizeof(seqLengths[0]); s++)
+		{
+			for (size_t l = 0; l < sizeof(litLengths) / sizeof(litLengths[0]); l++)
+			{
+				AppendToken(compressed, &lit[l], litLengths[l], seqLengths[s], backRef);
+				AppendReference(expected, &lit[l], litLengths[l], seqLengths[s], backRef);
+			}
+		}
+
+		CheckDecode(compressed, expected);
+
+		// short streams are decoded only near end of buffers
+		for (size_t s = 0; s < sizeof(seqLengths) / sizeof(seqLengths[0]); s++)
+		{
+			expected.resize(HistoryLength);
+			compressed.clear();
+			AppendToken(compressed, &lit[0], 3, seqLengths[s], backRef);
+			AppendReference(expected, &lit[0], 3, seqLengths[s], backRef);
+			CheckDecode(compressed, expected);
+		}
+	}
+}
+
+static void TestErrors()
+{
+	std::vector<unsigned char> lit = GenerateTestData(100, 7);
+	std::vector<unsigned char> compressed;
+	AppendToken(compressed, &lit[0], 50, 100, 10);
+	std::vector<unsigned char> out(HistoryLength + 150 + BLAZER_DECOMPRESS_MARGIN);
+
+	CHECK_EQ(blazer_stream_decompress_block(&compressed[0], 0, (int32_t)compressed.size(), &out[0], HistoryLength, HistoryLength + 150), HistoryLength + 150);
+	CHECK_EQ(blazer_stream_decompress_block(&compressed[0], 0, (int32_t)compressed.size(), &out[0], HistoryLength, HistoryLength + 149), -1);
+	CHECK_EQ(blazer_stream_decompress_block(&compressed[0], 0, (int32_t)compressed.size() - 1, &out[0], HistoryLength, (int32_t)out.size()), -2);
+
+	compressed.clear();
+	AppendToken(compressed, &lit[0], 5, 10, HistoryLength + 6);
+	CHECK_EQ(blazer_stream_decompress_block(&compressed[0], 0, (int32_t)compressed.size(), &out[0], HistoryLength, (int32_t)out.size()), -3);
+}
+
+// out buffers smaller than margin of wide copies should be filled by precise loop only, even if input is long:
+// empty tokens of last literals do not write data, but wide copy of them would write after end
+static void TestTinyOut()
+{
+	std::vector<unsigned char> lit = GenerateTestData(BLAZER_DECOMPRESS_MARGIN * 2, 8);
+	for (int32_t outLength = 0; outLength <= BLAZER_DECOMPRESS_MARGIN * 2; outLength++)
+	{
+		std::vector<unsigned char> compressed;
+		compressed.push_back((unsigned char)(0x80 | outLength));
+		compressed.push_back(0xff);
+		compressed.push_back(0xff);
+		compressed.insert(compressed.end(), lit.begin(), lit.begin() + outLength);
+		for (int i = 0; i < 22; i++)
+		{
+			compressed.push_back(0x80);
+			compressed.push_back(0xff);
+			compressed.push_back(0xff);
+		}
+
+		for (int isStream = 0; isStream < 2; isStream++)
+		{
+			unsigned char* outExact = (unsigned char*)malloc(outLength > 0 ? outLength : 1);
+			int32_t res = isStream
+				? blazer_stream_decompress_block(&compressed[0], 0, (int32_t)compressed.size(), outExact, 0, outLength)
+				: blazer_block_decompress_block(&compressed[0], 0, (int32_t)compressed.size(), outExact, 0, outLength, NULL);
+			CHECK_EQ(res, outLength);
+			CHECK(outLength == 0 || memcmp(outExact, &lit[0], outLength) == 0);
+			free(outExact);
+		}
+	}
+}
+
+static bool IsValidResult(int32_t res, int32_t outOffset, int32_t outLength)
+{
+	return (res >= outOffset && res <= outLength) || res == -1 || res == -2 || res == -3;
+}
+
+// decodes mutated data from exactly sized heap buffers, so any access out of them is caught by sanitizer
+static void FuzzDecode(const std::vector<unsigned char>& data, bool isStream, uint32_t seed)
+{
+	std::vector<unsigned char> in(data);
+	in.resize(data.size() + 8);
+	std::vector<unsigned char> compressed(data.size() + (data.size() >> 8) + 16);
+	std::vector<int32_t> hashArr(65536);
+	int32_t comprLength = isStream
+		? blazer_stream_compress_block(&in[0], 0, (int32_t)data.size(), 0, &compressed[0], 0, &hashArr[0])
+		: blazer_block_compress_block(&in[0], 0, (int32_t)data.size(), &compressed[0], 0, &hashArr[0]);
+	compressed.resize(comprLength);
+
+	TestRandom rnd(seed);
+	for (int iter = 0; iter < 3000; iter++)
+	{
+		std::vector<unsigned char> mutated(compressed);
+		int mutations = 1 + rnd.Next() % 4;
+		for (int i = 0; i < mutations; i++)
+		{
+			uint32_t kind = rnd.Next() % 4;
+			size_t pos = rnd.Next() % mutated.size();
+			if (kind == 0) mutated[pos] = (unsigned char)rnd.Next();
+			else if (kind == 1) mutated[pos] ^= (unsigned char)(1 << (rnd.Next() % 8));
+			else if (kind == 2) mutated[pos] = (unsigned char)(253 + rnd.Next() % 3);
+			else if (pos > 0) mutated.resize(pos);
+		}
+
+		// out buffer can be exact, smaller or larger than original data
+		int32_t outLength = (int32_t)data.size();
+		if (iter % 3 == 1) outLength = (int32_t)(rnd.Next() % (data.size() + 1));
+		else if (iter % 3 == 2) outLength += rnd.Next() % 100;
+		// copy has no spare capacity after truncation
+		std::vector<unsigned char> inExact(mutated);
+		unsigned char* outExact = (unsigned char*)malloc(outLength > 0 ? outLength : 1);
+		int32_t res = isStream
+			? blazer_stream_decompress_block(&inExact[0], 0, (int32_t)inExact.size(), outExact, 0, outLength)
+			: blazer_block_decompress_block(&inExact[0], 0, (int32_t)inExact.size(), outExact, 0, outLength, NULL);
+		CHECK(IsValidResult(res, 0, outLength));
+		free(outExact);
+	}
+
+	// random garbage
+	for (int iter = 0; iter < 3000; iter++)
+	{
+		std::vector<unsigned char> garbage(1 + rnd.Next() % 200);
+		for (size_t i = 0; i < garbage.size(); i++)
+			garbage[i] = (unsigned char)rnd.Next();
+		int32_t outLength = (int32_t)(rnd.Next() % 1000);
+		unsigned char* outExact = (unsigned char*)malloc(outLength > 0 ? outLength : 1);
+		int32_t res = isStream
+			? blazer_stream_decompress_block(&garbage[0], 0, (int32_t)garbage.size(), outExact, 0, outLength)
+			: blazer_block_decompress_block(&garbage[0], 0, (int32_t)garbage.size(), outExact, 0, outLength, NULL);
+		CHECK(IsValidResult(res, 0, outLength));
+		free(outExact);
+	}
+}
+
+static void TestFuzz()
+{
+	for (uint32_t seed = 1; seed <= 4; seed++)
+	{
+		std::vector<unsigned char> data = GenerateTestData(5000 * seed, seed);
+		FuzzDecode(data, true, seed);
+		FuzzDecode(data, false, seed);
+	}
+}
+
+int main()
+{
+	TestBackRefs();
+	TestErrors();
+	TestTinyOut();
+	TestFuzz();
+	return TEST_RESULT();
+}
@@ -0,0 +1,163 @@
+// Checks compression of small messages with dictionary: result should not depend on previous messages of context
+// (hash table is restored after every message), dictionary should improve ratio and wrong dictionary should be detected
+
+#include "TestHelper.h"
+#include "Blazer.h"
+
+// JSON message of service log, about 300 bytes
+static std::vector<unsigned char> GenerateMessage(TestRandom& rnd)
+{
+	static const char* levels[] = { "INFO", "DEBUG", "WARN", "ERROR" };
+	static const char* services[] = { "orders", "payments", "users", "inventory", "shipping" };
+	static const char* messages[] = { "request completed", "request failed", "connection timeout", "user session started", "cache miss" };
+	char buf[1024];
+	int len = sprintf(buf, "{\"timestamp\":\"2026-10-%02uT%02u:%02u:%02u.%03uZ\",\"level\":\"%s\",\"service\":\"%s\",\"host\":\"node-%u.cluster.local\","
+		"\"userId\":%u,\"requestId\":\"%08x-%04x-%04x\",\"path\":\"/api/v1/%s/%u\",\"durationMs\":%u,\"status\":%u,\"message\":\"%s\"}",
+		rnd.Next() % 28 + 1, rnd.Next() % 24, rnd.Next() % 60, rnd.Next() % 60, rnd.Next() % 1000,
+		levels[rnd.Next() % 4], services[rnd.Next() % 5], rnd.Next() % 16, rnd.Next() % 1000000,
+		rnd.Next(), rnd.Next() & 0xffff, rnd.Next() & 0xffff, services[rnd.Next() % 5], rnd.Next() % 100000,
+		rnd.Next() % 5000, rnd.Next() % 2 == 0 ? 200 : 500, messages[rnd.Next() % 5]);
+	return std::vector<unsigned char>(buf, buf + len);
+}
+
+static std::vector<unsigned char> TrainDictionary(int32_t capacity)
+{
+	TestRandom rnd(1);
+	std::vector<unsigned char> samples;
+	std::vector<int32_t> lengths;
+	for (int32_t i = 0; i < 2000; i++)
+	{
+		std::vector<unsigned char> message = GenerateMessage(rnd);
+		samples.insert(samples.end(), message.begin(), message.end());
+		lengths.push_back((int32_t)message.size());
+	}
+
+	std::vector<unsigned char> dict(capacity);
+	int32_t length = blazer_dict_train(&samples[0], &lengths[0], (int32_t)lengths.size(), &dict[0], capacity);
+	CHECK(length > 0 && length <= capacity);
+	dict.resize(length > 0 ? length : 0);
+	return dict;
+}
+
+// compresses messages by one context, returns total compressed size
+static int64_t TestMessages(const std::vector<unsigned char>& dictData, int32_t level)
+{
+	blazer_dict* dict = blazer_dict_create(dictData.empty() ? NULL : &dictData[0], (int32_t)dictData.size(), 0, level);
+	CHECK(dict != NULL);
+	blazer_dict_ctx* encoder = blazer_dict_ctx_create(NULL, 0, dict, 4096);
+	blazer_dict_ctx* decoder = blazer_dict_ctx_create(NULL, 0, dict, 4096);
+	CHECK(encoder != NULL && decoder != NULL);
+
+	TestRandom rnd(2);
+	int64_t total = 0;
+	std::vector<unsigned char> compressed(blazer_dict_compress_bound(4096));
+	std::vector<unsigned char> reference(compressed.size());
+	std::vector<unsigned char> decompressed(4096);
+	for (int32_t i = 0; i < 300; i++)
+	{
+		std::vector<unsigned char> message = GenerateMessage(rnd);
+		int32_t comprLength = blazer_dict_compress(encoder, &message[0], (int32_t)message.size(), &compressed[0], (int32_t)compressed.size());
+		CHECK(comprLength > BLAZER_DICT_HEADER_SIZE);
+		CHECK_EQ(blazer_dict_message_id(&compressed[0], comprLength), blazer_dict_get_id(dict));
+		total += comprLength;
+
+		// fresh context gives same result
+		if (i % 20 == 0)
+		{
+			blazer_dict_ctx* fresh = blazer_dict_ctx_create(NULL, 0, dict, 4096);
+			CHECK_EQ(blazer_dict_compress(fresh, &message[0], (int32_t)message.size(), &reference[0], (int32_t)reference.size()), comprLength);
+			CHECK(memcmp(&reference[0], &compressed[0], comprLength) == 0);
+			blazer_dict_ctx_destroy(fresh);
+		}
+
+		CHECK_EQ(blazer_dict_decompress(decoder, &compressed[0], comprLength, &decompressed[0], (int32_t)decompressed.size()), message.size());
+		CHECK(memcmp(&decompressed[0], &message[0], message.size()) == 0);
+	}
+
+	blazer_dict_ctx_destroy(encoder);
+	blazer_dict_ctx_destroy(decoder);
+	blazer_dict_destroy(dict);
+	return total;
+}
+
+static void TestErrors(const std::vector<unsigned char>& dictData)
+{
+	blazer_dict* dict = blazer_dict_create(&dictData[0], (int32_t)dictData.size(), 12345, 0);
+	blazer_dict* other = blazer_dict_create(&dictData[0], (int32_t)dictData.size() - 1, 0, 0);
+	CHECK_EQ(blazer_dict_get_id(dict), 12345);
+	CHECK(blazer_dict_get_id(other) != 0 && blazer_dict_get_id(other) != 12345);
+	CHECK(blazer_dict_create(&dictData[0], (int32_t)dictData.size(), 0, 100) == NULL);
+	CHECK(blazer_dict_create(&dictData[0], -1, 0, 0) == NULL);
+	CHECK(blazer_dict_ctx_create(NULL, 0, dict, 0) == NULL);
+	CHECK(blazer_dict_ctx_create(NULL, 0, dict, (16 << 20) + 1) == NULL);
+	unsigned char small[64];
+	CHECK(blazer_dict_ctx_create(small, sizeof(small), dict, 1000) == NULL);
+
+	std::vector<unsigned char> memory(blazer_dict_ctx_size(dict, 1000));
+	blazer_dict_ctx* ctx = blazer_dict_ctx_create(&memory[0], memory.size(), dict, 1000);
+	blazer_dict_ctx* otherCtx = blazer_dict_ctx_create(NULL, 0, other, 1000);
+	CHECK(ctx != NULL && otherCtx != NULL);
+
+	TestRandom rnd(3);
+	std::vector<unsigned char> message = GenerateMessage(rnd);
+	std::vector<unsigned char> compressed(blazer_dict_compress_bound(2000));
+	std::vector<unsigned char> out(2000);
+	CHECK_EQ(blazer_dict_compress(ctx, &out[0], 1001, &compressed[0], (int32_t)compressed.size()), -1);
+	CHECK_EQ(blazer_dict_compress(ctx, &message[0], (int32_t)message.size(), &compressed[0], blazer_dict_compress_bound((int32_t)message.size()) - 1), -1);
+	int32_t comprLength = blazer_dict_compress(ctx, &message[0], (int32_t)message.size(), &compressed[0], (int32_t)compressed.size());
+	CHECK(comprLength > 0);
+	CHECK_EQ(blazer_dict_message_id(&compressed[0], comprLength), 12345);
+	CHECK_EQ(blazer_dict_message_id(&compressed[0], 3), 0);
+
+	CHECK_EQ(blazer_dict_decompress(otherCtx, &compressed[0], comprLength, &out[0], (int32_t)out.size()), -5);
+	CHECK_EQ(blazer_dict_decompress(ctx, &compressed[0], 4, &out[0], (int32_t)out.size()), -4);
+	CHECK(blazer_dict_decompress(ctx, &compressed[0], comprLength, &out[0], (int32_t)message.size() - 1) < 0);
+	CHECK(blazer_dict_decompress(ctx, &compressed[0], comprLength - 1, &out[0], (int32_t)out.size()) != (int32_t)message.size());
+	CHECK_EQ(blazer_dict_decompress(ctx, &compressed[0], comprLength, &out[0], (int32_t)out.size()), message.size());
+
+	// empty message
+	comprLength = blazer_dict_compress(ctx, &message[0], 0, &compressed[0], (int32_t)compressed.size());
+	CHECK_EQ(blazer_dict_decompress(ctx, &compressed[0], comprLength, &out[0], (int32_t)out.size()), 0);
+
+	blazer_dict_ctx_destroy(ctx);
+	blazer_dict_ctx_destroy(otherCtx);
+	blazer_dict_destroy(dict);
+	blazer_dict_destroy(other);
+}
+
+static void TestTrainer()
+{
+	unsigned char samples[] = { 'a', 'b', 'c', 'd', 'e' };
+	int32_t lengths[] = { 2, 3 };
+	unsigned char dict[16];
+	CHECK_EQ(blazer_dict_train(samples, lengths, 2, dict, sizeof(dict)), 5);
+	CHECK(memcmp(dict, samples, 5) == 0);
+	CHECK_EQ(blazer_dict_train(samples, lengths, 0, dict, sizeof(dict)), 0);
+	lengths[0] = -1;
+	CHECK_EQ(blazer_dict_train(samples, lengths, 2, dict, sizeof(dict)), -1);
+
+	// long dictionary is cut to referenced part
+	std::vector<unsigned char> data = GenerateTestData(200000, 4);
+	blazer_dict* full = blazer_dict_create(&data[0], (int32_t)data.size(), 0, 0);
+	blazer_dict* tail = blazer_dict_create(&data[data.size() - BLAZER_DICT_MAX_SIZE], BLAZER_DICT_MAX_SIZE, 0, 0);
+	CHECK_EQ(blazer_dict_get_id(full), blazer_dict_get_id(tail));
+	blazer_dict_destroy(full);
+	blazer_dict_destroy(tail);
+}
+
+int main()
+{
+	std::vector<unsigned char> dictData = TrainDictionary(16384);
+	int64_t withoutDict = TestMessages(std::vector<unsigned char>(), 0);
+	int64_t withDict = TestMessages(dictData, 0);
+	printf("without dictionary: %lld, with dictionary: %lld\n", (long long)withoutDict, (long long)withDict);
+	CHECK(withDict * 2 < withoutDict);
+	for (int32_t level = BLAZER_STREAM_LEVEL_MIN; level <= BLAZER_STREAM_LEVEL_MAX; level++)
+		CHECK(TestMessages(dictData, level) < withoutDict);
+	// messages of high levels reach dictionary, which is longer than chains
+	CHECK(TestMessages(TrainDictionary(BLAZER_DICT_MAX_SIZE), BLAZER_STREAM_LEVEL_MAX) < withDict);
+
+	TestErrors(dictData);
+	TestTrainer();
+	return TEST_RESULT();
+}
@@ -0,0 +1,103 @@
+// Checks file functions: result should be same as for framed encoder, decompressed file same as source,
+// damaged and truncated files should be rejected
+
+#include "TestHelper.h"
+#include "Blazer.h"
+
+static const char* SourcePath = "FileTests.src.tmp";
+static const char* CompressedPath = "FileTests.blz.tmp";
+static const char* DecompressedPath = "FileTests.out.tmp";
+
+static void WriteFile(const char* path, const std::vector<unsigned char>& data)
+{
+	FILE* f = fopen(path, "wb");
+	CHECK(f != NULL);
+	if (!data.empty())
+		CHECK_EQ(fwrite(&data[0], 1, data.size(), f), data.size());
+	fclose(f);
+}
+
+static std::vector<unsigned char> ReadFile(const char* path)
+{
+	std::vector<unsigned char> data;
+	FILE* f = fopen(path, "rb");
+	CHECK(f != NULL);
+	unsigned char buf[1 << 16];
+	size_t cnt;
+	while (f != NULL && (cnt = fread(buf, 1, sizeof(buf), f)) > 0)
+		data.insert(data.end(), buf, buf + cnt);
+	if (f != NULL)
+		fclose(f);
+	return data;
+}
+
+static std::vector<unsigned char> Encode(const std::vector<unsigned char>& data, uint32_t flags, int32_t algorithm)
+{
+	blazer_frame_encoder* encoder = blazer_frame_encoder_create(flags, algorithm, 0);
+	// finish requires space for last block even after write
+	std::vector<unsigned char> out((size_t)(blazer_frame_encoder_bound(encoder, data.size()) + blazer_frame_encoder_bound(encoder, 0)));
+	int64_t written = blazer_frame_encoder_write(encoder, data.empty() ? NULL : &data[0], data.size(), &out[0], out.size());
+	written += blazer_frame_encoder_finish(encoder, &out[0] + written, out.size() - written);
+	blazer_frame_encoder_destroy(encoder);
+	out.resize((size_t)written);
+	return out;
+}
+
+static void TestRoundTrip(size_t length, uint32_t flags, int32_t algorithm)
+{
+	std::vector<unsigned char> data = GenerateTestData(length, (uint32_t)length);
+	WriteFile(SourcePath, data);
+
+	std::vector<unsigned char> expected = Encode(data, flags, algorithm);
+	CHECK_EQ(blazer_file_compress(SourcePath, CompressedPath, flags, algorithm, 0), expected.size());
+	CHECK(ReadFile(CompressedPath) == expected);
+
+	CHECK_EQ(blazer_file_decompress(CompressedPath, DecompressedPath), data.size());
+	CHECK(ReadFile(DecompressedPath) == data);
+}
+
+static void TestErrors()
+{
+	CHECK_EQ(blazer_file_compress("FileTests.missing.tmp", CompressedPath, BLAZER_FLAGS_DEFAULT_BLOCK, BLAZER_ALGORITHM_BLOCK, 0), BLAZER_FILE_ERROR_INPUT);
+	CHECK_EQ(blazer_file_decompress("FileTests.missing.tmp", DecompressedPath), BLAZER_FILE_ERROR_INPUT);
+	CHECK_EQ(blazer_file_compress(SourcePath, CompressedPath, BLAZER_FLAGS_DEFAULT_BLOCK, 3, 0), BLAZER_FILE_ERROR_ARGUMENT);
+
+	std::vector<unsigned char> data = GenerateTestData(300000, 5);
+	std::vector<unsigned char> compressed = Encode(data, BLAZER_FLAGS_DEFAULT_STREAM, BLAZER_ALGORITHM_STREAM);
+	WriteFile(SourcePath, data);
+	CHECK_EQ(blazer_file_compress(SourcePath, "FileTests.missing.dir/out.tmp", BLAZER_FLAGS_DEFAULT_BLOCK, BLAZER_ALGORITHM_BLOCK, 0), BLAZER_FILE_ERROR_OUTPUT);
+
+	std::vector<unsigned char> damaged(compressed);
+	damaged[1000] ^= 0x10;
+	WriteFile(CompressedPath, damaged);
+	CHECK_EQ(blazer_file_decompress(CompressedPath, DecompressedPath), BLAZER_FRAME_ERROR_CRC);
+
+	// stream with footer flag should have footer, other streams should end after block
+	damaged.assign(compressed.begin(), compressed.end() - 4);
+	WriteFile(CompressedPath, damaged);
+	CHECK_EQ(blazer_file_decompress(CompressedPath, DecompressedPath), BLAZER_FRAME_ERROR_TRUNCATED);
+	damaged = Encode(data, BLAZER_FLAGS_DEFAULT_STREAM & ~BLAZER_FLAG_INCLUDE_FOOTER, BLAZER_ALGORITHM_STREAM);
+	WriteFile(CompressedPath, damaged);
+	CHECK_EQ(blazer_file_decompress(CompressedPath, DecompressedPath), data.size());
+	damaged.resize(damaged.size() - 1);
+	WriteFile(CompressedPath, damaged);
+	CHECK_EQ(blazer_file_decompress(CompressedPath, DecompressedPath), BLAZER_FRAME_ERROR_TRUNCATED);
+	WriteFile(CompressedPath, std::vector<unsigned char>());
+	CHECK_EQ(blazer_file_decompress(CompressedPath, DecompressedPath), BLAZER_FRAME_ERROR_TRUNCATED);
+}
+
+int main()
+{
+	TestRoundTrip(0, BLAZER_FLAGS_DEFAULT_BLOCK, BLAZER_ALGORITHM_BLOCK);
+	TestRoundTrip(1, BLAZER_FLAGS_DEFAULT_STREAM, BLAZER_ALGORITHM_STREAM);
+	TestRoundTrip(5000000, BLAZER_FLAGS_DEFAULT_BLOCK, BLAZER_ALGORITHM_BLOCK);
+	TestRoundTrip(3000000, BLAZER_FLAGS_DEFAULT_STREAM, BLAZER_ALGORITHM_STREAM);
+	TestRoundTrip(2000000, BLAZER_FLAGS_DEFAULT | 2, BLAZER_ALGORITHM_NO_COMPRESS);
+	TestRoundTrip(1000000, BLAZER_FLAGS_DEFAULT | 15, BLAZER_ALGORITHM_BLOCK);
+	TestErrors();
+
+	remove(SourcePath);
+	remove(CompressedPath);
+	remove(DecompressedPath);
+	return TEST_RESULT();
+}
@@ -0,0 +1,288 @@
+// Checks that native library produces exactly same data as Windows version of Blazer.Native
+// Reference values were generated by original msvc-compatible implementation, any change of them means format break.
+// Stream encoder gives same data only with BLAZER_STREAM_DENSE_HASH flag (or level 4)
+
+#include "TestHelper.h"
+#include "Blazer.h"
+
+static const size_t DataLength = 3 << 20;
+
+static uint32_t CompressStream(const std::vector<unsigned char>& data, int blockSize, std::vector<unsigned char>& compressed, int32_t flags = BLAZER_STREAM_DENSE_HASH, int32_t level = 0, uint32_t shift = 0)
+{
+	std::vector<unsigned char> in(data);
+	in.resize(data.size() + 8);
+	std::vector<unsigned char> out(blockSize + (blockSize >> 8) + 16);
+	// level 0 means blazer_stream_compress_block_ex with flags
+	std::vector<int32_t> hashArr(level == 0 ? 65536 : blazer_stream_hash_size(level));
+	compressed.clear();
+
+	uint32_t crc = 0;
+	for (size_t pos = 0; pos < data.size(); pos += blockSize)
+	{
+		int32_t end = (int32_t)(pos + blockSize < data.size() ? pos + blockSize : data.size());
+		int32_t cnt = level == 0
+			? blazer_stream_compress_block_ex(&in[0], (int32_t)pos, end, (int32_t)shift, &out[0], 0, &hashArr[0], flags)
+			: blazer_stream_compress_block_level(&in[0], (int32_t)pos, end, (int32_t)shift, &out[0], 0, &hashArr[0], level);
+		crc = crc32c_append(crc, &out[0], cnt);
+		// every block is prefixed with its length for decoding
+		compressed.insert(compressed.end(), (unsigned char*)&cnt, (unsigned char*)&cnt + 4);
+		compressed.insert(compressed.end(), out.begin(), out.begin() + cnt);
+	}
+
+	return crc;
+}
+
+static uint32_t CompressBlock(const std::vector<unsigned char>& data, int blockSize, std::vector<unsigned char>& compressed)
+{
+	std::vector<unsigned char> in(data);
+	in.resize(data.size() + 8);
+	std::vector<unsigned char> out(blockSize + (blockSize >> 8) + 16);
+	std::vector<int32_t> hashArr(65536);
+	compressed.clear();
+
+	uint32_t crc = 0;
+	for (size_t pos = 0; pos < data.size(); pos += blockSize)
+	{
+		int32_t cnt = (int32_t)(pos + blockSize < data.size() ? blockSize : data.size() - pos);
+		std::fill(hashArr.begin(), hashArr.end(), 0);
+		cnt = blazer_block_compress_block(&in[pos], 0, cnt, &out[0], 0, &hashArr[0]);
+		crc = crc32c_append(crc, &out[0], cnt);
+		compressed.insert(compressed.end(), (unsigned char*)&cnt, (unsigned char*)&cnt + 4);
+		compressed.insert(compressed.end(), out.begin(), out.begin() + cnt);
+	}
+
+	return crc;
+}
+
+static std::vector<unsigned char> DecompressStream(const std::vector<unsigned char>& compressed, size_t length)
+{
+	std::vector<unsigned char> in(compressed);
+	in.resize(compressed.size() + 8);
+	std::vector<unsigned char> out(length + 8);
+	int32_t outPos = 0;
+	for (size_t pos = 0; pos < compressed.size();)
+	{
+		int32_t cnt;
+		memcpy(&cnt, &in[pos], 4);
+		pos += 4;
+		int32_t res = blazer_stream_decompress_block(&in[0], (int32_t)pos, (int32_t)(pos + cnt), &out[0], outPos, (int32_t)length);
+		CHECK(res > outPos);
+		if (res < 0) break;
+		outPos = res;
+		pos += cnt;
+	}
+
+	out.resize(outPos);
+	return out;
+}
+
+static std::vector<unsigned char> DecompressBlock(const std::vector<unsigned char>& compressed, size_t length)
+{
+	std::vector<unsigned char> in(compressed);
+	in.resize(compressed.size() + 8);
+	std::vector<unsigned char> out(length + 8);
+	int32_t outPos = 0;
+	for (size_t pos = 0; pos < compressed.size();)
+	{
+		int32_t cnt;
+		memcpy(&cnt, &in[pos], 4);
+		pos += 4;
+		int32_t res = blazer_block_decompress_block(&in[0], (int32_t)pos, (int32_t)(pos + cnt), &out[outPos], 0, (int32_t)(length - outPos), NULL);
+		CHECK(res > 0);
+		if (res < 0) break;
+		outPos += res;
+		pos += cnt;
+	}
+
+	out.resize(outPos);
+	return out;
+}
+
+static void TestCrc32C()
+{
+	const char* check = "123456789";
+	CHECK_EQ(crc32c_append(0, (const uint8_t*)check, 9), 0xe3069283u);
+	CHECK_EQ(crc32c_append(0, NULL, 0), 0u);
+
+	std::vector<unsigned char> data = GenerateTestData(DataLength, 42);
+	CHECK_EQ(crc32c_append(0, &data[0], data.size()), 0xfdfe2b2eu);
+
+	// appending by parts should give same result, also checks unaligned heads and tails
+	uint32_t crc = 0;
+	size_t pos = 0;
+	for (size_t part = 1; pos < data.size(); part = part * 3 + 1)
+	{
+		size_t len = part < data.size() - pos ? part : data.size() - pos;
+		crc = crc32c_append(crc, &data[pos], len);
+		pos += len;
+	}
+
+	CHECK_EQ(crc, 0xfdfe2b2eu);
+}
+
+static void TestStream(int blockSize, uint32_t expectedCrc, size_t expectedSize)
+{
+	std::vector<unsigned char> data = GenerateTestData(DataLength, 42);
+	std::vector<unsigned char> compressed;
+	CHECK_EQ(CompressStream(data, blockSize, compressed), expectedCrc);
+	CHECK_EQ(compressed.size() - 4 * ((data.size() + blockSize - 1) / blockSize), expectedSize);
+	CHECK(DecompressStream(compressed, data.size()) == data);
+
+	// sparse hashing of long matches changes compressed data, but it should be near same size
+	CompressStream(data, blockSize, compressed, 0);
+	size_t sparseSize = compressed.size();
+	CHECK(sparseSize - 4 * ((data.size() + blockSize - 1) / blockSize) < expectedSize + expectedSize / 100);
+	CHECK(DecompressStream(compressed, data.size()) == data);
+
+	// lazy matching should not be worse than greedy
+	CompressStream(data, blockSize, compressed, BLAZER_STREAM_LAZY);
+	CHECK(compressed.size() <= sparseSize);
+	CHECK(DecompressStream(compressed, data.size()) == data);
+	CompressStream(data, blockSize, compressed, BLAZER_STREAM_LAZY | BLAZER_STREAM_DENSE_HASH);
+	CHECK(compressed.size() - 4 * ((data.size() + blockSize - 1) / blockSize) <= expectedSize);
+	CHECK(DecompressStream(compressed, data.size()) == data);
+}
+
+static void TestStreamLevels(int blockSize)
+{
+	std::vector<unsigned char> data = GenerateTestData(DataLength, 42);
+	std::vector<unsigned char> compressed;
+	// default level is same as blazer_stream_compress_block, level with dense hashing is same as managed encoder
+	CHECK_EQ(CompressStream(data, blockSize, compressed, 0, BLAZER_STREAM_LEVEL_DEFAULT), CompressStream(data, blockSize, compressed, 0));
+	CHECK_EQ(CompressStream(data, blockSize, compressed, 0, 4), CompressStream(data, blockSize, compressed, BLAZER_STREAM_DENSE_HASH));
+
+	size_t prevSize = 0;
+	for (int32_t level = BLAZER_STREAM_LEVEL_MIN; level <= BLAZER_STREAM_LEVEL_MAX; level++)
+	{
+		CompressStream(data, blockSize, compressed, 0, level);
+		CHECK(DecompressStream(compressed, data.size()) == data);
+		// larger hash table and deeper search should not give worse compression
+		if (level > BLAZER_STREAM_LEVEL_MIN)
+			CHECK(compressed.size() <= prevSize);
+		prevSize = compressed.size();
+	}
+
+	unsigned char out[16];
+	CHECK_EQ(blazer_stream_hash_size(BLAZER_STREAM_LEVEL_MIN - 1), 0);
+	CHECK_EQ(blazer_stream_hash_size(BLAZER_STREAM_LEVEL_MAX + 1), 0);
+	CHECK_EQ(blazer_stream_compress_block_level(&data[0], 0, 4, 0, out, 0, NULL, BLAZER_STREAM_LEVEL_MAX + 1), -1);
+}
+
+// repeated data with period near maximum back reference
+static void TestStreamLongPeriods()
+{
+	static const int periods[] = { 65535, 65536, 65537, 65791, 65792, 65793 };
+	for (size_t p = 0; p < sizeof(periods) / sizeof(periods[0]); p++)
+	{
+		TestRandom rnd((uint32_t)p);
+		std::vector<unsigned char> data(periods[p] * 2);
+		for (int i = 0; i < periods[p]; i++)
+			data[i] = data[i + periods[p]] = (unsigned char)rnd.Next();
+		std::vector<unsigned char> compressed;
+		for (int32_t level = BLAZER_STREAM_LEVEL_MIN; level <= BLAZER_STREAM_LEVEL_MAX; level++)
+		{
+			CompressStream(data, 65536, compressed, 0, level);
+			CHECK(DecompressStream(compressed, data.size()) == data);
+		}
+	}
+}
+
+// global positions overflow int32 and uint32 during stream, hash table is never rebased
+static void TestStreamShiftOverflow()
+{
+	static const int32_t levels[] = { 0, BLAZER_STREAM_LEVEL_MIN, BLAZER_STREAM_LEVEL_DEFAULT, 5, BLAZER_STREAM_LEVEL_HIGH, BLAZER_STREAM_LEVEL_MAX };
+	std::vector<unsigned char> data = GenerateTestData(DataLength, 42);
+	std::vector<unsigned char> compressed;
+	for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++)
+	{
+		uint32_t expectedCrc = CompressStream(data, 65536, compressed, BLAZER_STREAM_DENSE_HASH, levels[l]);
+		// positions are only compared by distance, so result is same
+		CHECK_EQ(CompressStream(data, 65536, compressed, BLAZER_STREAM_DENSE_HASH, levels[l], 0x7fff0000u), expectedCrc);
+		CHECK(DecompressStream(compressed, data.size()) == data);
+		// after overflow to zero empty entries look like near positions and should be checked as any other
+		CompressStream(data, 65536, compressed, BLAZER_STREAM_DENSE_HASH, levels[l], 0xfff00000u);
+		CHECK(DecompressStream(compressed, data.size()) == data);
+	}
+}
+
+// high encoder adds last positions of block to chains with next block and uses position 0 as any other
+static void TestStreamHighPositions()
+{
+	TestRandom rnd(7);
+	std::vector<unsigned char> data(1100);
+	for (int i = 0; i < 1000; i++)
+		data[i] = (unsigned char)(rnd.Next() >> 16);
+	// period of 3 bytes starts in last bytes of first block
+	for (int i = 1000; i < 1100; i++)
+		data[i] = data[i - 3];
+
+	std::vector<unsigned char> compressed;
+	std::vector<unsigned char> unique(data.begin(), data.begin() + 16);
+	std::vector<unsigned char> shifted(1, 0);
+	for (int32_t level = BLAZER_STREAM_LEVEL_HIGH; level <= BLAZER_STREAM_LEVEL_MAX; level++)
+	{
+		CompressStream(data, 1000, compressed, 0, level);
+		CHECK(DecompressStream(compressed, data.size()) == data);
+		int32_t firstLength;
+		memcpy(&firstLength, &compressed[0], 4);
+		// second block is one sequence without literals: token, back reference and length
+		CHECK_EQ(compressed.size() - firstLength - 8, 3);
+
+		// first bytes are repeated at end of data, match from position 0 saves one more literal than match from 1
+		std::vector<unsigned char> repeated(data.begin() + 16, data.begin() + 1000);
+		repeated.insert(repeated.begin(), unique.begin(), unique.end());
+		repeated.insert(repeated.end(), unique.begin(), unique.end());
+		CompressStream(repeated, 65536, compressed, 0, level);
+		size_t size = compressed.size();
+		shifted.resize(1);
+		shifted.insert(shifted.end(), repeated.begin(), repeated.end());
+		CompressStream(shifted, 65536, compressed, 0, level);
+		CHECK_EQ(compressed.size(), size + 1);
+	}
+}
+
+static void TestBlock(int blockSize, uint32_t expectedCrc, size_t expectedSize)
+{
+	std::vector<unsigned char> data = GenerateTestData(DataLength, 42);
+	std::vector<unsigned char> compressed;
+	CHECK_EQ(CompressBlock(data, blockSize, compressed), expectedCrc);
+	CHECK_EQ(compressed.size() - 4 * ((data.size() + blockSize - 1) / blockSize), expectedSize);
+	CHECK(DecompressBlock(compressed, data.size()) == data);
+}
+
+static void TestSmallData()
+{
+	for (int len = 0; len < 64; len++)
+	{
+		std::vector<unsigned char> data = GenerateTestData(len, len);
+		std::vector<unsigned char> compressed;
+		CompressStream(data, 65536, compressed);
+		CHECK(DecompressStream(compressed, data.size()) == data);
+		CompressStream(data, 65536, compressed, 0);
+		CHECK(DecompressStream(compressed, data.size()) == data);
+		CompressStream(data, 65536, compressed, BLAZER_STREAM_LAZY);
+		CHECK(DecompressStream(compressed, data.size()) == data);
+		CompressStream(data, 65536, compressed, 0, BLAZER_STREAM_LEVEL_MIN);
+		CHECK(DecompressStream(compressed, data.size()) == data);
+		CompressStream(data, 65536, compressed, 0, BLAZER_STREAM_LEVEL_MAX);
+		CHECK(DecompressStream(compressed, data.size()) == data);
+		CompressBlock(data, 65536, compressed);
+		CHECK(DecompressBlock(compressed, data.size()) == data);
+	}
+}
+
+int main()
+{
+	TestCrc32C();
+	TestStream(512, 0xc62f06c1u, 754907);
+	TestStream(65536, 0x2960f59au, 738252);
+	TestStreamLevels(512);
+	TestStreamLevels(65536);
+	TestStreamLongPeriods();
+	TestStreamShiftOverflow();
+	TestStreamHighPositions();
+	TestBlock(65536, 0xad0ce1e9u, 751636);
+	TestBlock(2 << 20, 0xbcfb5b90u, 607542);
+	TestSmallData();
+	return TEST_RESULT();
+}
@@ -0,0 +1,265 @@
+// Checks framed encoder and decoder: round trip for any split of input and output, exact layout of blocks,
+// flush handling, fallback to uncompressed blocks and errors on damaged data
+
+#include "TestHelper.h"
+#include "Blazer.h"
+
+// writes data by random pieces with random flushes, returns framed data
+static std::vector<unsigned char> Encode(const std::vector<unsigned char>& data, uint32_t flags, int32_t algorithm, TestRandom& rnd)
+{
+	blazer_frame_encoder* encoder = blazer_frame_encoder_create(flags, algorithm, 0);
+	CHECK(encoder != NULL);
+	std::vector<unsigned char> result;
+	std::vector<unsigned char> out;
+	size_t pos = 0;
+	while (pos < data.size())
+	{
+		size_t cnt = rnd.Next() % 4 == 0 ? rnd.Next() % 8 : rnd.Next() % 100000;
+		if (cnt > data.size() - pos)
+			cnt = data.size() - pos;
+		out.resize((size_t)blazer_frame_encoder_bound(encoder, cnt));
+		int64_t written = blazer_frame_encoder_write(encoder, cnt > 0 ? &data[pos] : NULL, cnt, &out[0], out.size());
+		CHECK(written >= 0);
+		result.insert(result.end(), out.begin(), out.begin() + written);
+		pos += cnt;
+
+		if (rnd.Next() % 8 == 0)
+		{
+			written = blazer_frame_encoder_flush(encoder, &out[0], out.size());
+			CHECK(written >= 0);
+			result.insert(result.end(), out.begin(), out.begin() + written);
+		}
+	}
+
+	out.resize((size_t)blazer_frame_encoder_bound(encoder, 0));
+	int64_t written = blazer_frame_encoder_finish(encoder, &out[0], out.size());
+	CHECK(written >= 0);
+	result.insert(result.end(), out.begin(), out.begin() + written);
+	blazer_frame_encoder_destroy(encoder);
+	return result;
+}
+
+// reads framed data by random pieces into random sized output, returns result code of last call
+static int32_t Decode(const std::vector<unsigned char>& framed, uint32_t flags, std::vector<unsigned char>& decoded, TestRandom& rnd)
+{
+	blazer_frame_decoder* decoder = blazer_frame_decoder_create(flags);
+	CHECK(decoder != NULL);
+	decoded.clear();
+	unsigned char out[70000];
+	size_t pos = 0;
+	int32_t res = 0;
+	while (res == 0)
+	{
+		size_t inLength = rnd.Next() % 4 == 0 ? rnd.Next() % 4 : rnd.Next() % 50000;
+		if (inLength > framed.size() - pos)
+			inLength = framed.size() - pos;
+		size_t outLength = rnd.Next() % 4 == 0 ? rnd.Next() % 4 : rnd.Next() % sizeof(out);
+		size_t available = inLength;
+		res = blazer_frame_decode(decoder, framed.empty() ? NULL : &framed[0] + pos, &inLength, out, &outLength);
+		CHECK(inLength <= available);
+		decoded.insert(decoded.end(), out, out + outLength);
+		pos += inLength;
+		// no progress is possible without more input
+		if (res == 0 && pos == framed.size() && outLength == 0 && inLength == 0 && available == 0)
+		{
+			size_t bigOut = sizeof(out);
+			size_t noIn = 0;
+			res = blazer_frame_decode(decoder, NULL, &noIn, out, &bigOut);
+			decoded.insert(decoded.end(), out, out + bigOut);
+			if (res == 0 && bigOut == 0)
+				break;
+		}
+	}
+
+	blazer_frame_decoder_destroy(decoder);
+	return res;
+}
+
+static void TestRoundTrip(uint32_t flags, int32_t algorithm, uint32_t seed)
+{
+	TestRandom rnd(seed);
+	std::vector<unsigned char> data = GenerateTestData(600000 + rnd.Next() % 1000, seed);
+	std::vector<unsigned char> framed = Encode(data, flags, algorithm, rnd);
+	uint32_t decoderFlags = (flags & BLAZER_FLAG_INCLUDE_HEADER) != 0 ? BLAZER_FLAG_INCLUDE_HEADER : flags | (algorithm << 4);
+	std::vector<unsigned char> decoded;
+	int32_t res = Decode(framed, decoderFlags, decoded, rnd);
+	CHECK_EQ(res, (flags & BLAZER_FLAG_INCLUDE_FOOTER) != 0 ? 1 : 0);
+	CHECK(decoded == data);
+	if (algorithm != BLAZER_ALGORITHM_NO_COMPRESS)
+		CHECK(framed.size() < data.size() / 2);
+}
+
+static void TestLayout()
+{
+	static const unsigned char data[] = { 'a', 'b', 'c' };
+	blazer_frame_encoder* encoder = blazer_frame_encoder_create(BLAZER_FLAGS_DEFAULT, BLAZER_ALGORITHM_NO_COMPRESS, 0);
+	unsigned char out[1 << 12];
+	int64_t written = blazer_frame_encoder_write(encoder, data, 3, out, sizeof(out));
+	written += blazer_frame_encoder_finish(encoder, out + written, sizeof(out) - written);
+	blazer_frame_encoder_destroy(encoder);
+
+	uint32_t crc = crc32c_append(0, data, 3);
+	const unsigned char expected[] = { 'b', 'L', 'z', 0x01, 0x00, 0x0f, 0x00, 0x00,
+		0x00, 0x02, 0x00, 0x00, (unsigned char)crc, (unsigned char)(crc >> 8), (unsigned char)(crc >> 16), (unsigned char)(crc >> 24),
+		'a', 'b', 'c', 0xff, 'Z', 'l', 'B' };
+	CHECK_EQ(written, sizeof(expected));
+	CHECK(memcmp(out, expected, sizeof(expected)) == 0);
+}
+
+static void TestSameAsLevelApi()
+{
+	// stream blocks should be same as blocks of contiguous stream
+	const int32_t blockSize = 512 << 7;
+	std::vector<unsigned char> data = GenerateTestData(blockSize * 3, 5);
+	std::vector<unsigned char> in(data);
+	in.resize(data.size() + 8);
+	std::vector<int32_t> hashArr(blazer_stream_hash_size(BLAZER_STREAM_LEVEL_DEFAULT));
+	std::vector<unsigned char> expected(blockSize * 2);
+
+	blazer_frame_encoder* encoder = blazer_frame_encoder_create(BLAZER_FLAGS_DEFAULT_STREAM & ~BLAZER_FLAG_INCLUDE_CRC & ~BLAZER_FLAG_INCLUDE_HEADER, BLAZER_ALGORITHM_STREAM, 0);
+	std::vector<unsigned char> out((size_t)blazer_frame_encoder_bound(encoder, data.size()));
+	int64_t written = blazer_frame_encoder_write(encoder, &data[0], data.size(), &out[0], out.size());
+	blazer_frame_encoder_destroy(encoder);
+
+	int64_t pos = 0;
+	for (int32_t i = 0; i < 3; i++)
+	{
+		int32_t expectedLength = blazer_stream_compress_block_level(&in[0], i * blockSize, (i + 1) * blockSize, 0, &expected[0], 0, &hashArr[0], BLAZER_STREAM_LEVEL_DEFAULT);
+		CHECK_EQ(out[pos], BLAZER_ALGORITHM_STREAM);
+		CHECK_EQ(out[pos + 1] | (out[pos + 2] << 8) | (out[pos + 3] << 16), expectedLength - 1);
+		CHECK(memcmp(&out[pos + 4], &expected[0], expectedLength) == 0);
+		pos += 4 + expectedLength;
+	}
+
+	CHECK_EQ(pos, written);
+}
+
+static void TestFlush()
+{
+	static const unsigned char data[] = { 'a', 'b', 'c' };
+	unsigned char out[1 << 12];
+	blazer_frame_encoder* encoder = blazer_frame_encoder_create(BLAZER_FLAGS_DEFAULT, BLAZER_ALGORITHM_BLOCK, 0);
+	int64_t written = blazer_frame_encoder_write(encoder, data, 3, out, sizeof(out));
+	CHECK_EQ(written, 8);
+	CHECK_EQ(blazer_frame_encoder_flush(encoder, out, sizeof(out)), 8 + 3);
+	CHECK_EQ(blazer_frame_encoder_flush(encoder, out, sizeof(out)), 0);
+	CHECK_EQ(blazer_frame_encoder_flush(encoder, out, 10), -1);
+	CHECK_EQ(blazer_frame_encoder_write(encoder, data, 3, out, 10), -1);
+	blazer_frame_encoder_destroy(encoder);
+
+	// without RespectFlush flag data is collected up to full block
+	encoder = blazer_frame_encoder_create(BLAZER_FLAGS_DEFAULT & ~BLAZER_FLAG_RESPECT_FLUSH, BLAZER_ALGORITHM_BLOCK, 0);
+	CHECK_EQ(blazer_frame_encoder_flush(encoder, out, sizeof(out)), 8);
+	CHECK_EQ(blazer_frame_encoder_write(encoder, data, 3, out, sizeof(out)), 0);
+	CHECK_EQ(blazer_frame_encoder_flush(encoder, out, sizeof(out)), 0);
+	CHECK_EQ(blazer_frame_encoder_finish(encoder, out, sizeof(out)), 8 + 3 + 4);
+	blazer_frame_encoder_destroy(encoder);
+}
+
+static void TestNoCompressionFallback()
+{
+	// random data cannot be compressed, so blocks are stored as is
+	TestRandom rnd(7);
+	std::vector<unsigned char> data(512 << 4);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = (unsigned char)rnd.Next();
+
+	for (int32_t algorithm = BLAZER_ALGORITHM_STREAM; algorithm <= BLAZER_ALGORITHM_BLOCK; algorithm++)
+	{
+		blazer_frame_encoder* encoder = blazer_frame_encoder_create(BLAZER_FLAGS_DEFAULT | 3, algorithm, 0);
+		std::vector<unsigned char> out((size_t)blazer_frame_encoder_bound(encoder, data.size()));
+		int64_t written = blazer_frame_encoder_write(encoder, &data[0], data.size(), &out[0], out.size());
+		blazer_frame_encoder_destroy(encoder);
+		CHECK_EQ(written, 8 + 2 * (8 + (512 << 4) / 2));
+		CHECK_EQ(out[8], BLAZER_ALGORITHM_NO_COMPRESS);
+		CHECK(memcmp(&out[16], &data[0], data.size() / 2) == 0);
+	}
+}
+
+static void TestErrors()
+{
+	CHECK(blazer_frame_encoder_create(BLAZER_FLAGS_DEFAULT | 0x1000, BLAZER_ALGORITHM_STREAM, 0) == NULL);
+	CHECK(blazer_frame_encoder_create(BLAZER_FLAGS_DEFAULT, 3, 0) == NULL);
+	CHECK(blazer_frame_encoder_create(BLAZER_FLAGS_DEFAULT, BLAZER_ALGORITHM_STREAM, BLAZER_STREAM_LEVEL_MAX + 1) == NULL);
+	CHECK(blazer_frame_decoder_create(BLAZER_FLAG_INCLUDE_CRC | (3 << 4)) == NULL);
+
+	TestRandom rnd(11);
+	std::vector<unsigned char> data = GenerateTestData(100000, 11);
+	std::vector<unsigned char> framed = Encode(data, BLAZER_FLAGS_DEFAULT_STREAM, BLAZER_ALGORITHM_STREAM, rnd);
+	std::vector<unsigned char> decoded;
+
+	std::vector<unsigned char> damaged(framed);
+	damaged[1] = 'l';
+	CHECK_EQ(Decode(damaged, BLAZER_FLAG_INCLUDE_HEADER, decoded, rnd), BLAZER_FRAME_ERROR_HEADER);
+	damaged = framed;
+	damaged[6] |= 0x10;
+	CHECK_EQ(Decode(damaged, BLAZER_FLAG_INCLUDE_HEADER, decoded, rnd), BLAZER_FRAME_ERROR_FLAGS);
+	damaged = framed;
+	damaged[8] = 0x20;
+	CHECK_EQ(Decode(damaged, BLAZER_FLAG_INCLUDE_HEADER, decoded, rnd), BLAZER_FRAME_ERROR_BLOCK);
+	damaged = framed;
+	damaged[11] = 0x7f;
+	CHECK_EQ(Decode(damaged, BLAZER_FLAG_INCLUDE_HEADER, decoded, rnd), BLAZER_FRAME_ERROR_BLOCK);
+	damaged = framed;
+	damaged[100] ^= 1;
+	CHECK_EQ(Decode(damaged, BLAZER_FLAG_INCLUDE_HEADER, decoded, rnd), BLAZER_FRAME_ERROR_CRC);
+	damaged = framed;
+	damaged[framed.size() - 1] = 'b';
+	CHECK_EQ(Decode(damaged, BLAZER_FLAG_INCLUDE_HEADER, decoded, rnd), BLAZER_FRAME_ERROR_BLOCK);
+
+	// without crc damaged data is detected by decompressor (reference before start of stream)
+	std::vector<unsigned char> broken(8);
+	broken[0] = BLAZER_ALGORITHM_STREAM;
+	broken[1] = 3;
+	broken[4] = 0x00;
+	broken[5] = 0xff;
+	broken[6] = 0xff;
+	broken[7] = 0x00;
+	CHECK_EQ(Decode(broken, BLAZER_FLAG_INCLUDE_FOOTER | (BLAZER_ALGORITHM_STREAM << 4) | 7, decoded, rnd), BLAZER_FRAME_ERROR_DATA);
+
+	// error is sticky
+	blazer_frame_decoder* decoder = blazer_frame_decoder_create(BLAZER_FLAG_INCLUDE_HEADER);
+	size_t inLength = 4;
+	size_t outLength = 0;
+	CHECK_EQ(blazer_frame_decode(decoder, (const unsigned char*)"xLz\x01", &inLength, NULL, &outLength), 0);
+	inLength = 4;
+	CHECK_EQ(blazer_frame_decode(decoder, (const unsigned char*)"\x07\x0f\x00\x00", &inLength, NULL, &outLength), BLAZER_FRAME_ERROR_HEADER);
+	inLength = framed.size();
+	CHECK_EQ(blazer_frame_decode(decoder, &framed[0], &inLength, NULL, &outLength), BLAZER_FRAME_ERROR_HEADER);
+	CHECK_EQ(inLength, 0);
+	blazer_frame_decoder_destroy(decoder);
+}
+
+static void TestSkippedBlocks()
+{
+	// empty control block, control data and comment are skipped
+	static const unsigned char framed[] = { 0xf0, 0x00, 0x00, 0x00, 0xf1, 0x01, 0x00, 0x00, 'x', 'y',
+		0xf9, 0x00, 0x00, 0x00, 'c', 0x00, 0x00, 0x00, 0x00, 'd', 0xff, 'Z', 'l', 'B' };
+	std::vector<unsigned char> in(framed, framed + sizeof(framed));
+	std::vector<unsigned char> decoded;
+	TestRandom rnd(13);
+	CHECK_EQ(Decode(in, BLAZER_FLAG_INCLUDE_FOOTER, decoded, rnd), 1);
+	CHECK_EQ(decoded.size(), 1);
+	CHECK(decoded.size() == 1 && decoded[0] == 'd');
+}
+
+int main()
+{
+	uint32_t seed = 1;
+	for (int32_t algorithm = BLAZER_ALGORITHM_NO_COMPRESS; algorithm <= BLAZER_ALGORITHM_BLOCK; algorithm++)
+	{
+		TestRoundTrip(BLAZER_FLAGS_DEFAULT | 7, algorithm, seed++);
+		TestRoundTrip(BLAZER_FLAGS_DEFAULT | 1, algorithm, seed++);
+		TestRoundTrip(BLAZER_FLAGS_DEFAULT | 12, algorithm, seed++);
+		TestRoundTrip(BLAZER_FLAG_INCLUDE_CRC | 5, algorithm, seed++);
+		TestRoundTrip(BLAZER_FLAG_INCLUDE_HEADER | BLAZER_FLAG_INCLUDE_FOOTER | 8, algorithm, seed++);
+	}
+
+	TestLayout();
+	TestSameAsLevelApi();
+	TestFlush();
+	TestNoCompressionFallback();
+	TestErrors();
+	TestSkippedBlocks();
+	return TEST_RESULT();
+}
@@ -0,0 +1,112 @@
+// Checks checksums calculated during compression and decompression: they should be same as separate crc32c of input
+// and output for all levels and block sizes, including blocks larger than chunk of checksum
+
+#include "TestHelper.h"
+#include "Blazer.h"
+
+#include <chrono>
+
+static uint32_t Crc(const std::vector<unsigned char>& data, size_t offset, size_t length)
+{
+	return crc32c_append(0, length > 0 ? &data[offset] : NULL, length);
+}
+
+// compressed data is placed after other data, which should not be included into checksum
+static void TestStream(size_t length, int32_t level, uint32_t seed)
+{
+	// encoder reads some bytes after data
+	std::vector<unsigned char> data = GenerateTestData(length + 1000, seed);
+	data.resize(length + 1000 + 64);
+	std::vector<int32_t> hashArr(blazer_stream_hash_size(level));
+	std::vector<unsigned char> compressed(length + (length >> 8) + 100);
+	uint32_t inCrc = 0, outCrc = 0;
+	// first 1000 bytes are history of block
+	int32_t res = blazer_stream_compress_block_crc(&data[0], 1000, (int32_t)length + 1000, 0, &compressed[0], 50, &hashArr[0], level, &inCrc, &outCrc);
+	CHECK(res >= 50);
+	CHECK_EQ(inCrc, Crc(data, 1000, length));
+	CHECK_EQ(outCrc, Crc(compressed, 50, res - 50));
+
+	std::vector<int32_t> refHashArr(hashArr.size());
+	std::vector<unsigned char> reference(compressed.size());
+	CHECK_EQ(blazer_stream_compress_block_level(&data[0], 1000, (int32_t)length + 1000, 0, &reference[0], 50, &refHashArr[0], level), res);
+	CHECK(reference == compressed);
+
+	std::vector<unsigned char> out(length + 1000);
+	memcpy(&out[0], &data[0], 1000);
+	uint32_t compressedCrc = 0, decompressedCrc = 0;
+	CHECK_EQ(blazer_stream_decompress_block_crc(&compressed[0], 50, res, &out[0], 1000, (int32_t)out.size(), &compressedCrc, &decompressedCrc), out.size());
+	CHECK(memcmp(&out[0], &data[0], out.size()) == 0);
+	CHECK_EQ(compressedCrc, outCrc);
+	CHECK_EQ(decompressedCrc, inCrc);
+	// checksums are optional
+	CHECK_EQ(blazer_stream_decompress_block_crc(&compressed[0], 50, res, &out[0], 1000, (int32_t)out.size(), NULL, &decompressedCrc), out.size());
+	CHECK_EQ(decompressedCrc, inCrc);
+	if (length > 0)
+		CHECK(blazer_stream_decompress_block_crc(&compressed[0], 50, res, &out[0], 1000, (int32_t)out.size() - 1, &compressedCrc, &decompressedCrc) < 0);
+}
+
+static void TestBlock(size_t length, uint32_t seed)
+{
+	std::vector<unsigned char> data = GenerateTestData(length, seed);
+	data.resize(length);
+	std::vector<unsigned char> compressed(length + (length >> 8) + 100);
+	uint32_t inCrc = 0, outCrc = 0;
+	int32_t res = blazer_block_compress_block_crc(data.empty() ? NULL : &data[0], 0, (int32_t)length, &compressed[0], 10, NULL, &inCrc, &outCrc);
+	CHECK(res >= 10);
+	CHECK_EQ(inCrc, Crc(data, 0, length));
+	CHECK_EQ(outCrc, Crc(compressed, 10, res - 10));
+
+	std::vector<unsigned char> out(length + 1);
+	std::vector<int32_t> hashArr(65536);
+	uint32_t compressedCrc = 0, decompressedCrc = 0;
+	CHECK_EQ(blazer_block_decompress_block_crc(&compressed[0], 10, res, &out[0], 1, (int32_t)out.size(), &hashArr[0], &compressedCrc, &decompressedCrc), out.size());
+	CHECK(length == 0 || memcmp(&out[1], &data[0], length) == 0);
+	CHECK_EQ(compressedCrc, outCrc);
+	CHECK_EQ(decompressedCrc, inCrc);
+	CHECK_EQ(blazer_block_decompress_block_crc(&compressed[0], 10, res, &out[0], 1, (int32_t)out.size(), NULL, NULL, NULL), out.size());
+	if (length > 0)
+		CHECK(blazer_block_decompress_block_crc(&compressed[0], 10, res - 1, &out[0], 1, (int32_t)out.size(), NULL, &compressedCrc, &decompressedCrc) != (int32_t)out.size());
+}
+
+// prints speed of decompression with checksum of output and with separate checksum, stream algorithm is used
+// as fastest decoder, block is larger than caches
+static void Benchmark()
+{
+	const int32_t blockSize = 32 << 20;
+	std::vector<unsigned char> data = GenerateTestData(blockSize + 64, 9);
+	std::vector<unsigned char> compressed(blockSize + (blockSize >> 8) + 16);
+	std::vector<int32_t> hashArr(65536);
+	int32_t res = blazer_stream_compress_block(&data[0], 0, blockSize, 0, &compressed[0], 0, &hashArr[0]);
+	std::vector<unsigned char> out(blockSize);
+	double timeFused = 0, timeSeparate = 0;
+	uint32_t crcFused = 0, crcSeparate = 0;
+	for (int32_t i = 0; i < 5; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		CHECK_EQ(blazer_stream_decompress_block_crc(&compressed[0], 0, res, &out[0], 0, blockSize, NULL, &crcFused), blockSize);
+		auto middle = std::chrono::steady_clock::now();
+		CHECK_EQ(blazer_stream_decompress_block(&compressed[0], 0, res, &out[0], 0, blockSize), blockSize);
+		crcSeparate = crc32c_append(0, &out[0], blockSize);
+		auto end = std::chrono::steady_clock::now();
+		timeFused += std::chrono::duration<double>(middle - start).count();
+		timeSeparate += std::chrono::duration<double>(end - middle).count();
+	}
+
+	CHECK_EQ(crcFused, crcSeparate);
+	printf("decompression with crc: fused %.0f MB/s, separate %.0f MB/s\n", 5.0 * blockSize / timeFused / 1e6, 5.0 * blockSize / timeSeparate / 1e6);
+}
+
+int main()
+{
+	const size_t lengths[] = { 0, 1, 100, 20000, 70000, 3000000 };
+	uint32_t seed = 1;
+	for (size_t length : lengths)
+	{
+		for (int32_t level = BLAZER_STREAM_LEVEL_MIN; level <= BLAZER_STREAM_LEVEL_MAX; level++)
+			TestStream(length, level, seed++);
+		TestBlock(length, seed++);
+	}
+
+	Benchmark();
+	return TEST_RESULT();
+}
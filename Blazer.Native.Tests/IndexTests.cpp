@@ -0,0 +1,177 @@
+// Checks index of blocks and restart points: random reads should return same data as whole file, index should be skipped
+// by sequential decoder and damaged data should be detected
+
+#include "TestHelper.h"
+#include "Blazer.h"
+
+static const char* SourcePath = "IndexTests.src.tmp";
+static const char* CompressedPath = "IndexTests.blz.tmp";
+static const char* DecompressedPath = "IndexTests.out.tmp";
+
+static void WriteFile(const char* path, const std::vector<unsigned char>& data)
+{
+	FILE* f = fopen(path, "wb");
+	CHECK(f != NULL);
+	if (!data.empty())
+		CHECK_EQ(fwrite(&data[0], 1, data.size(), f), data.size());
+	fclose(f);
+}
+
+static std::vector<unsigned char> ReadFile(const char* path)
+{
+	std::vector<unsigned char> data;
+	FILE* f = fopen(path, "rb");
+	CHECK(f != NULL);
+	unsigned char buf[1 << 16];
+	size_t cnt;
+	while (f != NULL && (cnt = fread(buf, 1, sizeof(buf), f)) > 0)
+		data.insert(data.end(), buf, buf + cnt);
+	if (f != NULL)
+		fclose(f);
+	return data;
+}
+
+// restartInterval is -1 for index of every block
+static void TestRandomReads(size_t length, uint32_t flags, int32_t algorithm, int64_t restartInterval = -1)
+{
+	std::vector<unsigned char> data = GenerateTestData(length, (uint32_t)length + 7);
+	WriteFile(SourcePath, data);
+	if (restartInterval < 0)
+		CHECK(blazer_file_compress_indexed(SourcePath, CompressedPath, flags, algorithm, 0) > 0);
+	else
+		CHECK(blazer_file_compress_restartable(SourcePath, CompressedPath, flags, algorithm, 0, restartInterval) > 0);
+
+	// sequential decoder skips index
+	CHECK_EQ(blazer_file_decompress(CompressedPath, DecompressedPath), length);
+	CHECK(ReadFile(DecompressedPath) == data);
+
+	int32_t error = 1;
+	blazer_indexed_file* file = blazer_indexed_file_open(CompressedPath, &error);
+	CHECK_EQ(error, 0);
+	if (file == NULL)
+		return;
+	CHECK_EQ(blazer_indexed_file_length(file), length);
+
+	TestRandom rnd((uint32_t)length);
+	std::vector<unsigned char> out(300000);
+	for (int32_t i = 0; i < 200; i++)
+	{
+		int64_t offset = length > 0 ? rnd.Next() % length : 0;
+		int64_t cnt = rnd.Next() % 2 == 0 ? rnd.Next() % 100 : rnd.Next() % out.size();
+		int64_t expected = cnt < (int64_t)length - offset ? cnt : (int64_t)length - offset;
+		CHECK_EQ(blazer_indexed_file_read(file, offset, &out[0], cnt), expected);
+		CHECK(expected == 0 || memcmp(&out[0], &data[(size_t)offset], (size_t)expected) == 0);
+	}
+
+	CHECK_EQ(blazer_indexed_file_read(file, length, &out[0], 10), 0);
+	CHECK_EQ(blazer_indexed_file_read(file, -1, &out[0], 10), BLAZER_FILE_ERROR_ARGUMENT);
+	if (length > 0)
+	{
+		CHECK_EQ(blazer_indexed_file_read(file, length - 1, &out[0], 10), 1);
+		CHECK_EQ(out[0], data[length - 1]);
+	}
+
+	blazer_indexed_file_close(file);
+}
+
+static void TestErrors()
+{
+	blazer_frame_encoder* encoder = blazer_frame_encoder_create(BLAZER_FLAGS_DEFAULT_STREAM, BLAZER_ALGORITHM_STREAM, 0);
+	CHECK_EQ(blazer_frame_encoder_enable_index(encoder), -1);
+	blazer_frame_encoder_destroy(encoder);
+	encoder = blazer_frame_encoder_create(BLAZER_FLAGS_DEFAULT_BLOCK, BLAZER_ALGORITHM_BLOCK, 0);
+	unsigned char buf[1 << 12];
+	std::vector<unsigned char> out((size_t)blazer_frame_encoder_bound(encoder, sizeof(buf)));
+	blazer_frame_encoder_write(encoder, buf, sizeof(buf), &out[0], out.size());
+	CHECK_EQ(blazer_frame_encoder_enable_index(encoder), -1);
+	blazer_frame_encoder_destroy(encoder);
+
+	std::vector<unsigned char> data = GenerateTestData(200000, 3);
+	WriteFile(SourcePath, data);
+	CHECK_EQ(blazer_file_compress_indexed(SourcePath, CompressedPath, BLAZER_FLAGS_DEFAULT_STREAM, BLAZER_ALGORITHM_STREAM, 0), BLAZER_FILE_ERROR_ARGUMENT);
+
+	// file without index
+	int32_t error = 0;
+	CHECK(blazer_file_compress(SourcePath, CompressedPath, BLAZER_FLAGS_DEFAULT_BLOCK, BLAZER_ALGORITHM_BLOCK, 0) > 0);
+	CHECK(blazer_indexed_file_open(CompressedPath, &error) == NULL);
+	CHECK_EQ(error, BLAZER_FILE_ERROR_INDEX);
+	CHECK(blazer_indexed_file_open("IndexTests.missing.tmp", &error) == NULL);
+	CHECK_EQ(error, BLAZER_FILE_ERROR_INPUT);
+
+	// without crc of blocks damaged data is found by crc of entry
+	CHECK(blazer_file_compress_indexed(SourcePath, CompressedPath, (BLAZER_FLAGS_DEFAULT & ~BLAZER_FLAG_INCLUDE_CRC) | 4, BLAZER_ALGORITHM_NO_COMPRESS, 0) > 0);
+	std::vector<unsigned char> compressed = ReadFile(CompressedPath);
+	compressed[20000] ^= 1;
+	WriteFile(CompressedPath, compressed);
+	blazer_indexed_file* file = blazer_indexed_file_open(CompressedPath, &error);
+	CHECK(file != NULL);
+	std::vector<unsigned char> read(data.size());
+	CHECK_EQ(blazer_indexed_file_read(file, 0, &read[0], read.size()), BLAZER_FRAME_ERROR_CRC);
+	// other blocks are still readable
+	CHECK_EQ(blazer_indexed_file_read(file, 100000, &read[0], 1000), 1000);
+	blazer_indexed_file_close(file);
+
+	// damaged index
+	CHECK(blazer_file_compress_indexed(SourcePath, CompressedPath, BLAZER_FLAGS_DEFAULT_BLOCK, BLAZER_ALGORITHM_BLOCK, 0) > 0);
+	compressed = ReadFile(CompressedPath);
+	compressed[compressed.size() - 20] ^= 1;
+	WriteFile(CompressedPath, compressed);
+	CHECK(blazer_indexed_file_open(CompressedPath, &error) == NULL);
+	CHECK_EQ(error, BLAZER_FRAME_ERROR_CRC);
+}
+
+static void TestRestartErrors()
+{
+	blazer_frame_encoder* encoder = blazer_frame_encoder_create(BLAZER_FLAGS_DEFAULT_STREAM, BLAZER_ALGORITHM_STREAM, 0);
+	CHECK_EQ(blazer_frame_encoder_set_restart_interval(encoder, -1), -1);
+	unsigned char buf[1 << 12] = { 0 };
+	std::vector<unsigned char> out((size_t)blazer_frame_encoder_bound(encoder, sizeof(buf)));
+	blazer_frame_encoder_write(encoder, buf, sizeof(buf), &out[0], out.size());
+	CHECK_EQ(blazer_frame_encoder_set_restart_interval(encoder, 1 << 20), -1);
+	blazer_frame_encoder_destroy(encoder);
+
+	// damaged block of stream breaks only data up to next restart point
+	std::vector<unsigned char> data = GenerateTestData(1000000, 5);
+	WriteFile(SourcePath, data);
+	CHECK(blazer_file_compress_restartable(SourcePath, CompressedPath, BLAZER_FLAGS_DEFAULT_STREAM, BLAZER_ALGORITHM_STREAM, 0, 200000) > 0);
+	std::vector<unsigned char> compressed = ReadFile(CompressedPath);
+	compressed[1000] ^= 1;
+	WriteFile(CompressedPath, compressed);
+	CHECK(blazer_file_decompress(CompressedPath, DecompressedPath) < 0);
+
+	int32_t error = 0;
+	blazer_indexed_file* file = blazer_indexed_file_open(CompressedPath, &error);
+	CHECK(file != NULL);
+	if (file == NULL)
+		return;
+	std::vector<unsigned char> read(data.size());
+	CHECK_EQ(blazer_indexed_file_read(file, 0, &read[0], 1000), BLAZER_FRAME_ERROR_CRC);
+	CHECK_EQ(blazer_indexed_file_read(file, 300000, &read[0], 700000), 700000);
+	CHECK(memcmp(&read[0], &data[300000], 700000) == 0);
+	blazer_indexed_file_close(file);
+}
+
+int main()
+{
+	TestRandomReads(0, BLAZER_FLAGS_DEFAULT_BLOCK, BLAZER_ALGORITHM_BLOCK);
+	TestRandomReads(1, BLAZER_FLAGS_DEFAULT_BLOCK, BLAZER_ALGORITHM_BLOCK);
+	TestRandomReads(5000000, BLAZER_FLAGS_DEFAULT_BLOCK, BLAZER_ALGORITHM_BLOCK);
+	TestRandomReads(3000000, BLAZER_FLAGS_DEFAULT | 7, BLAZER_ALGORITHM_BLOCK);
+	// index of many small blocks is split into several control blocks
+	TestRandomReads(2000000, BLAZER_FLAGS_DEFAULT, BLAZER_ALGORITHM_BLOCK);
+	TestRandomReads(1000000, (BLAZER_FLAGS_DEFAULT & ~BLAZER_FLAG_INCLUDE_FOOTER & ~BLAZER_FLAG_INCLUDE_CRC) | 3, BLAZER_ALGORITHM_NO_COMPRESS);
+	// restart points of stream: every block, every 3 blocks and interval which is not multiple of block
+	TestRandomReads(2000000, BLAZER_FLAGS_DEFAULT_STREAM, BLAZER_ALGORITHM_STREAM, 0);
+	TestRandomReads(3000000, BLAZER_FLAGS_DEFAULT_STREAM, BLAZER_ALGORITHM_STREAM, 3 << 16);
+	TestRandomReads(5000000, BLAZER_FLAGS_DEFAULT | 4, BLAZER_ALGORITHM_STREAM, 1000000);
+	TestRandomReads(1000, BLAZER_FLAGS_DEFAULT_STREAM, BLAZER_ALGORITHM_STREAM, 1000000);
+	// index of block algorithm with several blocks per entry
+	TestRandomReads(5000000, BLAZER_FLAGS_DEFAULT | 10, BLAZER_ALGORITHM_BLOCK, 1 << 20);
+	TestErrors();
+	TestRestartErrors();
+
+	remove(SourcePath);
+	remove(CompressedPath);
+	remove(DecompressedPath);
+	return TEST_RESULT();
+}
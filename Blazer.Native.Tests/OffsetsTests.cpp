@@ -0,0 +1,188 @@
+// Checks block algorithm with explicit offsets: blocks should be decoded without hash table, ratio should be close to
+// format with hash keys, framed data with both formats should be readable and invalid offsets should be rejected
+
+#include "TestHelper.h"
+#include "Blazer.h"
+
+#include <chrono>
+
+static std::vector<unsigned char> Compress(std::vector<unsigned char>& data, bool isOffsets)
+{
+	std::vector<unsigned char> out(data.size() + (data.size() >> 8) + 16);
+	int32_t length = (int32_t)data.size();
+	int32_t res = isOffsets
+		? blazer_block_compress_offsets(data.empty() ? NULL : &data[0], 0, length, &out[0], 0, NULL)
+		: blazer_block_compress_block(data.empty() ? NULL : &data[0], 0, length, &out[0], 0, NULL);
+	CHECK(res >= 0);
+	out.resize(res > 0 ? res : 0);
+	return out;
+}
+
+static void TestRoundTrip(size_t length, uint32_t seed)
+{
+	std::vector<unsigned char> data = GenerateTestData(length, seed);
+	data.resize(length);
+	std::vector<unsigned char> compressed = Compress(data, true);
+	std::vector<unsigned char> reference = Compress(data, false);
+	// offsets further than 32KB are one byte longer than hash keys, test data has many of them
+	CHECK(compressed.size() <= reference.size() + reference.size() / 12 + 4);
+
+	// output is placed after other data, which should not be referenced
+	std::vector<unsigned char> out(length + 100);
+	int32_t res = blazer_block_decompress_offsets(compressed.empty() ? NULL : &compressed[0], 0, (int32_t)compressed.size(), &out[0], 100, (int32_t)out.size());
+	CHECK_EQ(res, length + 100);
+	CHECK(length == 0 || memcmp(&out[100], &data[0], length) == 0);
+
+	// context gives same result
+	if (length > 0)
+	{
+		blazer_ctx* ctx = blazer_ctx_create(NULL, 0);
+		std::vector<unsigned char> ctxOut(compressed.size() + 16);
+		for (int32_t i = 0; i < 2; i++)
+		{
+			int32_t ctxRes = blazer_ctx_block_compress_offsets(ctx, &data[0], 0, (int32_t)length, &ctxOut[0], 0);
+			CHECK_EQ(ctxRes, compressed.size());
+			CHECK(memcmp(&ctxOut[0], &compressed[0], compressed.size()) == 0);
+		}
+		blazer_ctx_destroy(ctx);
+	}
+
+	if (length > 1)
+	{
+		CHECK(blazer_block_decompress_offsets(&compressed[0], 0, (int32_t)compressed.size(), &out[0], 100, (int32_t)out.size() - 1) < 0);
+		CHECK(blazer_block_decompress_offsets(&compressed[0], 0, (int32_t)compressed.size() - 1, &out[0], 100, (int32_t)out.size()) != (int32_t)out.size());
+	}
+}
+
+static void TestInvalidOffsets()
+{
+	// far match to position before block: tail loop and fast loop
+	unsigned char in[64] = { 0x80, 0x00, 0x00, 0x00 };
+	unsigned char out[1024];
+	CHECK_EQ(blazer_block_decompress_offsets(in, 0, 4, out, 0, sizeof(out)), -3);
+	CHECK_EQ(blazer_block_decompress_offsets(in, 0, sizeof(in), out, 0, sizeof(out)), -3);
+	// near match with one literal references one byte back, two bytes are before block
+	unsigned char near[] = { 0x10, 0x01, 'a' };
+	CHECK_EQ(blazer_block_decompress_offsets(near, 0, sizeof(near), out, 10, sizeof(out)), -3);
+	near[1] = 0;
+	CHECK_EQ(blazer_block_decompress_offsets(near, 0, sizeof(near), out, 10, sizeof(out)), 15);
+	CHECK_EQ(blazer_block_decompress_offsets(in, 0, 2, out, 0, sizeof(out)), -2);
+}
+
+// long input of empty tokens should not let wide copies write after end of tiny exact out buffer
+static void TestTinyOut()
+{
+	std::vector<unsigned char> data = GenerateTestData(BLAZER_DECOMPRESS_MARGIN * 2, 9);
+	for (int32_t outLength = 0; outLength <= BLAZER_DECOMPRESS_MARGIN * 2; outLength++)
+	{
+		std::vector<unsigned char> part(data.begin(), data.begin() + outLength);
+		std::vector<unsigned char> compressed = Compress(part, true);
+		// marker of last literals has 3 bytes in offsets format
+		for (int i = 0; i < 17; i++)
+		{
+			compressed.push_back(0x80);
+			compressed.push_back(0xff);
+			compressed.push_back(0xff);
+			compressed.push_back(0xff);
+		}
+
+		unsigned char* outExact = (unsigned char*)malloc(outLength > 0 ? outLength : 1);
+		CHECK_EQ(blazer_block_decompress_offsets(&compressed[0], 0, (int32_t)compressed.size(), outExact, 0, outLength), outLength);
+		CHECK(outLength == 0 || memcmp(outExact, &part[0], outLength) == 0);
+		free(outExact);
+	}
+}
+
+static std::vector<unsigned char> Frame(std::vector<unsigned char>& data, bool isOffsets)
+{
+	blazer_frame_encoder* encoder = blazer_frame_encoder_create(BLAZER_FLAGS_DEFAULT | 10, BLAZER_ALGORITHM_BLOCK, 0);
+	if (isOffsets)
+		CHECK_EQ(blazer_frame_encoder_use_offsets(encoder), 0);
+	std::vector<unsigned char> out((size_t)blazer_frame_encoder_bound(encoder, data.size()));
+	int64_t written = blazer_frame_encoder_write(encoder, &data[0], data.size(), &out[0], out.size());
+	CHECK(written > 0);
+	written += blazer_frame_encoder_finish(encoder, &out[0] + written, out.size() - written);
+	out.resize((size_t)written);
+	blazer_frame_encoder_destroy(encoder);
+	return out;
+}
+
+static void Unframe(std::vector<unsigned char>& framed, std::vector<unsigned char>& data)
+{
+	blazer_frame_decoder* decoder = blazer_frame_decoder_create(BLAZER_FLAG_INCLUDE_HEADER);
+	std::vector<unsigned char> decoded(data.size() + 1);
+	size_t inPos = 0, outPos = 0;
+	int32_t res = 0;
+	while (res == 0 && outPos < decoded.size())
+	{
+		size_t inLength = framed.size() - inPos;
+		size_t outLength = decoded.size() - outPos;
+		res = blazer_frame_decode(decoder, framed.data() + inPos, &inLength, decoded.data() + outPos, &outLength);
+		inPos += inLength;
+		outPos += outLength;
+		if (inLength == 0 && outLength == 0)
+			break;
+	}
+
+	CHECK(res >= 0);
+	CHECK_EQ(blazer_frame_decoder_end(decoder), 1);
+	CHECK_EQ(outPos, data.size());
+	CHECK(memcmp(&decoded[0], &data[0], data.size()) == 0);
+	blazer_frame_decoder_destroy(decoder);
+}
+
+static void TestFrame()
+{
+	std::vector<unsigned char> data = GenerateTestData(3000000, 7);
+	std::vector<unsigned char> framed = Frame(data, true);
+	std::vector<unsigned char> reference = Frame(data, false);
+	CHECK(framed != reference);
+	Unframe(framed, data);
+	Unframe(reference, data);
+
+	blazer_frame_encoder* encoder = blazer_frame_encoder_create(BLAZER_FLAGS_DEFAULT_STREAM, BLAZER_ALGORITHM_STREAM, 0);
+	CHECK_EQ(blazer_frame_encoder_use_offsets(encoder), -1);
+	blazer_frame_encoder_destroy(encoder);
+}
+
+// prints speed of decoders, blocks of 2MB as in default block settings
+static void Benchmark()
+{
+	const int32_t blockSize = 2 << 20;
+	std::vector<unsigned char> data = GenerateTestData(blockSize, 8);
+	data.resize(blockSize);
+	std::vector<unsigned char> compressed = Compress(data, true);
+	std::vector<unsigned char> reference = Compress(data, false);
+	std::vector<unsigned char> out(blockSize);
+	std::vector<int32_t> hashArr(65536);
+	double timeOffsets = 0, timeHash = 0;
+	for (int32_t i = 0; i < 10; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		CHECK_EQ(blazer_block_decompress_offsets(&compressed[0], 0, (int32_t)compressed.size(), &out[0], 0, blockSize), blockSize);
+		auto middle = std::chrono::steady_clock::now();
+		CHECK_EQ(blazer_block_decompress_block(&reference[0], 0, (int32_t)reference.size(), &out[0], 0, blockSize, &hashArr[0]), blockSize);
+		auto end = std::chrono::steady_clock::now();
+		timeOffsets += std::chrono::duration<double>(middle - start).count();
+		timeHash += std::chrono::duration<double>(end - middle).count();
+	}
+
+	printf("offsets: %d bytes, %.0f MB/s; hash keys: %d bytes, %.0f MB/s\n", (int)compressed.size(), 10 * blockSize / timeOffsets / 1e6,
+		(int)reference.size(), 10 * blockSize / timeHash / 1e6);
+}
+
+int main()
+{
+	TestRoundTrip(0, 1);
+	TestRoundTrip(1, 2);
+	TestRoundTrip(100, 3);
+	TestRoundTrip(70000, 4);
+	TestRoundTrip(1 << 20, 5);
+	// offsets which do not fit into 3 bytes are not used
+	TestRoundTrip(16 << 20, 6);
+	TestInvalidOffsets();
+	TestTinyOut();
+	TestFrame();
+	Benchmark();
+	return TEST_RESULT();
+}
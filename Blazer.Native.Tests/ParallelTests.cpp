@@ -0,0 +1,105 @@
+// Parallel codecs should give exactly same result as sequential ones
+
+#include "TestHelper.h"
+#include "Blazer.h"
+
+static void TestCompress(size_t length, int32_t blockSize, int32_t threadCount, bool isRandom = false)
+{
+	std::vector<unsigned char> data = GenerateTestData(length, (uint32_t)length);
+	data.resize(length + 8);
+	// incompressible data takes whole slot of block, so bound of out buffer is checked
+	TestRandom rnd((uint32_t)blockSize);
+	for (size_t i = 0; isRandom && i < length; i++)
+		data[i] = (unsigned char)(rnd.Next() >> 16);
+
+	// sequential variant
+	std::vector<unsigned char> expected;
+	std::vector<int32_t> expectedSizes;
+	std::vector<unsigned char> out(blockSize + (blockSize >> 8) + 16);
+	std::vector<int32_t> hashArr(65536);
+	for (size_t pos = 0; pos < length; pos += blockSize)
+	{
+		int32_t cnt = (int32_t)(length - pos < (size_t)blockSize ? length - pos : blockSize);
+		std::fill(hashArr.begin(), hashArr.end(), 0);
+		cnt = blazer_block_compress_block(&data[pos], 0, cnt, &out[0], 0, &hashArr[0]);
+		expected.insert(expected.end(), out.begin(), out.begin() + cnt);
+		expectedSizes.push_back(cnt);
+	}
+
+	// exact size of bound, so any write after it is detected by sanitizers
+	std::vector<unsigned char> compressed((size_t)blazer_block_compress_bound(length, blockSize) + (length == 0 ? 1 : 0));
+	std::vector<int32_t> blockSizes(expectedSizes.size() + 1, -1);
+	int64_t res = blazer_block_compress_parallel(&data[0], length, blockSize, &compressed[0], &blockSizes[0], threadCount);
+	CHECK_EQ(res, (int64_t)expected.size());
+	CHECK(expected.empty() || memcmp(&compressed[0], &expected[0], expected.size()) == 0);
+	blockSizes.resize(expectedSizes.size());
+	CHECK(blockSizes == expectedSizes);
+}
+
+static void TestDecompress(size_t length, int32_t blockSize, int32_t threadCount)
+{
+	std::vector<unsigned char> data = GenerateTestData(length, (uint32_t)length + 1);
+	std::vector<unsigned char> compressed((size_t)blazer_block_compress_bound(length, blockSize));
+	int32_t blockCount = (int32_t)((length + blockSize - 1) / blockSize);
+	std::vector<int32_t> blockSizes(blockCount);
+	int64_t comprLength = blazer_block_compress_parallel(&data[0], length, blockSize, &compressed[0], &blockSizes[0], threadCount);
+
+	// first block is stored without compression as BlazerInputStream does for incompressible data
+	std::vector<unsigned char> framed(data.begin(), data.begin() + blockSize);
+	framed.insert(framed.end(), compressed.begin() + blockSizes[0], compressed.begin() + comprLength);
+
+	std::vector<blazer_block_frame> frames(blockCount);
+	int64_t inPos = 0;
+	for (int32_t i = 0; i < blockCount; i++)
+	{
+		frames[i].inOffset = inPos;
+		frames[i].inLength = i == 0 ? blockSize : blockSizes[i];
+		frames[i].outOffset = (int64_t)i * blockSize;
+		frames[i].outLength = blockSize;
+		frames[i].isCompressed = i != 0;
+		frames[i].crc = crc32c_append(0, &framed[inPos], frames[i].inLength);
+		inPos += frames[i].inLength;
+	}
+
+	std::vector<blazer_block_frame> framesCopy(frames);
+	std::vector<unsigned char> out((size_t)blockCount * blockSize);
+	CHECK_EQ(blazer_block_decompress_parallel(&framed[0], framed.size(), &out[0], out.size(), &frames[0], blockCount, 1, threadCount), (int64_t)length);
+	CHECK(memcmp(&out[0], &data[0], length) == 0);
+	CHECK_EQ(frames[blockCount - 1].outLength, (int32_t)(length - (size_t)(blockCount - 1) * blockSize));
+
+	// broken data in last block should be detected by crc
+	frames = framesCopy;
+	framed[framed.size() - 2] ^= 0x55;
+	CHECK_EQ(blazer_block_decompress_parallel(&framed[0], framed.size(), &out[0], out.size(), &frames[0], blockCount, 1, threadCount), -4);
+
+	// frame outside of buffer
+	frames = framesCopy;
+	frames[blockCount - 1].outOffset = out.size() - blockSize + 1;
+	CHECK_EQ(blazer_block_decompress_parallel(&framed[0], framed.size(), &out[0], out.size(), &frames[0], blockCount, 0, threadCount), -5);
+}
+
+int main()
+{
+	TestCompress(0, 65536, 4);
+	TestCompress(1, 65536, 4);
+	TestCompress(3 << 20, 512, 3);
+	TestCompress(3 << 20, 65536, 0);
+	TestCompress((5 << 20) + 12345, 1 << 20, 8);
+	TestCompress((5 << 20) + 12345, 2 << 20, 1);
+	TestCompress(1 << 20, 16 << 20, 4);
+	// sizes of blocks which are not power of two
+	TestCompress(100000, 200, 4, true);
+	TestCompress(100000, 767, 2, true);
+	TestCompress((1 << 20) + 1, 300, 0, true);
+
+	TestDecompress(3 << 20, 65536, 3);
+	TestDecompress((5 << 20) + 12345, 1 << 20, 0);
+	TestDecompress(100000, 65536, 1);
+
+	std::vector<unsigned char> data(100);
+	std::vector<unsigned char> out(1000);
+	int32_t sizes[4];
+	CHECK_EQ(blazer_block_compress_parallel(&data[0], 100, 0, &out[0], sizes, 1), -1);
+	CHECK_EQ(blazer_block_compress_parallel(&data[0], 100, 32 << 20, &out[0], sizes, 1), -1);
+	return TEST_RESULT();
+}
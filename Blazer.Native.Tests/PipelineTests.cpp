@@ -0,0 +1,90 @@
+// Checks file pipeline: output should be same as of blazer_file_compress with block algorithm
+// for any count of threads, queue depth and mode of reads and writes
+
+#include "TestHelper.h"
+#include "Blazer.h"
+
+static const char* SourcePath = "PipelineTests.src.tmp";
+static const char* ExpectedPath = "PipelineTests.exp.tmp";
+static const char* CompressedPath = "PipelineTests.blz.tmp";
+static const char* DecompressedPath = "PipelineTests.out.tmp";
+
+static void WriteFile(const char* path, const std::vector<unsigned char>& data)
+{
+	FILE* f = fopen(path, "wb");
+	CHECK(f != NULL);
+	if (!data.empty())
+		CHECK_EQ(fwrite(&data[0], 1, data.size(), f), data.size());
+	fclose(f);
+}
+
+static std::vector<unsigned char> ReadFile(const char* path)
+{
+	std::vector<unsigned char> data;
+	FILE* f = fopen(path, "rb");
+	CHECK(f != NULL);
+	unsigned char buf[1 << 16];
+	size_t cnt;
+	while (f != NULL && (cnt = fread(buf, 1, sizeof(buf), f)) > 0)
+		data.insert(data.end(), buf, buf + cnt);
+	if (f != NULL)
+		fclose(f);
+	return data;
+}
+
+static void TestSameAsFile(size_t length, uint32_t flags)
+{
+	std::vector<unsigned char> data = GenerateTestData(length, (uint32_t)length + 1);
+	WriteFile(SourcePath, data);
+	int64_t expectedLength = blazer_file_compress(SourcePath, ExpectedPath, flags, BLAZER_ALGORITHM_BLOCK, 0);
+	CHECK(expectedLength > 0);
+	std::vector<unsigned char> expected = ReadFile(ExpectedPath);
+
+	static const int32_t threadCounts[] = { 1, 3, 0 };
+	static const int32_t queueDepths[] = { 1, 2, 0 };
+	for (int32_t ioMode = BLAZER_PIPELINE_IO_AUTO; ioMode <= BLAZER_PIPELINE_IO_THREADS; ioMode++)
+	{
+		for (int32_t i = 0; i < 3; i++)
+		{
+			blazer_pipeline_stats stats;
+			memset(&stats, 0xcc, sizeof(stats));
+			CHECK_EQ(blazer_file_compress_pipelined(SourcePath, CompressedPath, flags, threadCounts[i], queueDepths[i], ioMode, &stats), expectedLength);
+			CHECK(ReadFile(CompressedPath) == expected);
+			CHECK_EQ(stats.read.bytes, length);
+			CHECK_EQ(stats.compress.bytes, length);
+			CHECK(stats.write.bytes < expectedLength && stats.write.bytes >= expectedLength - 12);
+			CHECK(stats.read.stalls >= 0 && stats.compress.stalls >= 0 && stats.write.stalls >= 0);
+			CHECK(stats.read.stallNanoseconds >= 0 && stats.compress.busyNanoseconds >= 0);
+			CHECK(stats.elapsedNanoseconds > 0);
+			if (ioMode == BLAZER_PIPELINE_IO_THREADS)
+				CHECK_EQ(stats.ioRing, 0);
+		}
+	}
+
+	CHECK_EQ(blazer_file_decompress(CompressedPath, DecompressedPath), length);
+	CHECK(ReadFile(DecompressedPath) == data);
+}
+
+static void TestErrors()
+{
+	CHECK_EQ(blazer_file_compress_pipelined("PipelineTests.missing.tmp", CompressedPath, BLAZER_FLAGS_DEFAULT_BLOCK, 0, 0, BLAZER_PIPELINE_IO_AUTO, NULL), BLAZER_FILE_ERROR_INPUT);
+	CHECK_EQ(blazer_file_compress_pipelined(SourcePath, "PipelineTests.missing.dir/out.tmp", BLAZER_FLAGS_DEFAULT_BLOCK, 0, 0, BLAZER_PIPELINE_IO_AUTO, NULL), BLAZER_FILE_ERROR_OUTPUT);
+	CHECK_EQ(blazer_file_compress_pipelined(SourcePath, CompressedPath, BLAZER_FLAGS_DEFAULT_BLOCK | 0x1000, 0, 0, BLAZER_PIPELINE_IO_AUTO, NULL), BLAZER_FILE_ERROR_ARGUMENT);
+}
+
+int main()
+{
+	TestSameAsFile(0, BLAZER_FLAGS_DEFAULT_BLOCK);
+	TestSameAsFile(1, BLAZER_FLAGS_DEFAULT_BLOCK);
+	TestSameAsFile(5000000, BLAZER_FLAGS_DEFAULT_BLOCK);
+	TestSameAsFile(4 << 20, BLAZER_FLAGS_DEFAULT_BLOCK);
+	TestSameAsFile(3000001, BLAZER_FLAGS_DEFAULT | 7);
+	TestSameAsFile(100000, (BLAZER_FLAGS_DEFAULT & ~BLAZER_FLAG_INCLUDE_CRC) | 1);
+	TestErrors();
+
+	remove(SourcePath);
+	remove(ExpectedPath);
+	remove(CompressedPath);
+	remove(DecompressedPath);
+	return TEST_RESULT();
+}
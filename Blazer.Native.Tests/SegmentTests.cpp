@@ -0,0 +1,120 @@
+// Checks scatter/gather functions of stream context: result should be same as for contiguous stream
+// for any split of data into segments, history should span segments and blocks
+
+#include "TestHelper.h"
+#include "Blazer.h"
+
+static const int32_t MaxBlockSize = 20000;
+
+// splits buffer into random segments (including empty ones)
+static std::vector<blazer_segment> Split(unsigned char* data, int32_t length, TestRandom& rnd)
+{
+	std::vector<blazer_segment> segments;
+	int32_t pos = 0;
+	do
+	{
+		int32_t cnt = (int32_t)(rnd.Next() % 3 == 0 ? rnd.Next() % 8 : rnd.Next() % 3000);
+		if (cnt > length - pos)
+			cnt = length - pos;
+		blazer_segment segment = { data + pos, cnt };
+		segments.push_back(segment);
+		pos += cnt;
+	}
+	while (pos < length);
+
+	return segments;
+}
+
+static void TestSameAsContiguous(int32_t level, uint32_t seed)
+{
+	std::vector<unsigned char> data = GenerateTestData(1 << 20, seed);
+	std::vector<unsigned char> in(data);
+	in.resize(data.size() + 8);
+	std::vector<int32_t> hashArr(blazer_stream_hash_size(level));
+	std::vector<unsigned char> expected(MaxBlockSize * 2);
+	std::vector<unsigned char> compressed(MaxBlockSize * 2);
+	std::vector<unsigned char> decompressed(data.size());
+
+	blazer_stream_ctx* encoder = blazer_stream_ctx_create(NULL, 0, MaxBlockSize, level);
+	blazer_stream_ctx* decoder = blazer_stream_ctx_create(NULL, 0, MaxBlockSize, 0);
+	CHECK(encoder != NULL && decoder != NULL);
+
+	TestRandom rnd(seed);
+	int32_t pos = 0;
+	while (pos < (int32_t)data.size())
+	{
+		int32_t cnt = (int32_t)(rnd.Next() % MaxBlockSize) + 1;
+		if (cnt > (int32_t)data.size() - pos)
+			cnt = (int32_t)data.size() - pos;
+
+		int32_t expectedLength = blazer_stream_compress_block_level(&in[0], pos, pos + cnt, 0, &expected[0], 0, &hashArr[0], level);
+		std::vector<blazer_segment> segmentsIn = Split(&data[pos], cnt, rnd);
+		// large out segment is used directly, small ones through scratch buffer
+		std::vector<blazer_segment> segmentsOut = rnd.Next() % 2 == 0
+			? Split(&compressed[0], (int32_t)compressed.size(), rnd)
+			: std::vector<blazer_segment>(1, blazer_segment { &compressed[0], (int32_t)compressed.size() });
+		int32_t comprLength = blazer_stream_compress_segments(encoder, &segmentsIn[0], (int32_t)segmentsIn.size(), &segmentsOut[0], (int32_t)segmentsOut.size());
+		CHECK_EQ(comprLength, expectedLength);
+		CHECK(memcmp(&compressed[0], &expected[0], expectedLength) == 0);
+
+		segmentsIn = Split(&compressed[0], comprLength, rnd);
+		segmentsOut = Split(&decompressed[pos], cnt, rnd);
+		CHECK_EQ(blazer_stream_decompress_segments(decoder, &segmentsIn[0], (int32_t)segmentsIn.size(), &segmentsOut[0], (int32_t)segmentsOut.size()), cnt);
+		pos += cnt;
+	}
+
+	CHECK(decompressed == data);
+	blazer_stream_ctx_destroy(encoder);
+	blazer_stream_ctx_destroy(decoder);
+}
+
+static void TestErrors()
+{
+	CHECK_EQ(blazer_stream_ctx_size(0, BLAZER_STREAM_LEVEL_DEFAULT), 0);
+	CHECK_EQ(blazer_stream_ctx_size(MaxBlockSize, BLAZER_STREAM_LEVEL_MAX + 1), 0);
+	CHECK(blazer_stream_ctx_size(MaxBlockSize, 0) < blazer_stream_ctx_size(MaxBlockSize, BLAZER_STREAM_LEVEL_DEFAULT));
+
+	size_t size = blazer_stream_ctx_size(MaxBlockSize, BLAZER_STREAM_LEVEL_DEFAULT);
+	std::vector<unsigned char> arena(size + 1, 0xcc);
+	CHECK(blazer_stream_ctx_create(&arena[1], size - 1, MaxBlockSize, BLAZER_STREAM_LEVEL_DEFAULT) == NULL);
+	blazer_stream_ctx* encoder = blazer_stream_ctx_create(&arena[1], size, MaxBlockSize, BLAZER_STREAM_LEVEL_DEFAULT);
+	blazer_stream_ctx* decoder = blazer_stream_ctx_create(NULL, 0, MaxBlockSize, 0);
+	CHECK(encoder != NULL && decoder != NULL);
+
+	std::vector<unsigned char> data = GenerateTestData(MaxBlockSize + 1, 3);
+	std::vector<unsigned char> compressed(MaxBlockSize * 2);
+	blazer_segment in = { &data[0], MaxBlockSize + 1 };
+	blazer_segment out = { &compressed[0], (int32_t)compressed.size() };
+	CHECK_EQ(blazer_stream_compress_segments(encoder, &in, 1, &out, 1), -1);
+	CHECK_EQ(blazer_stream_compress_segments(decoder, &in, 1, &out, 1), -1);
+
+	in.length = 1000;
+	out.length = 10;
+	CHECK_EQ(blazer_stream_compress_segments(encoder, &in, 1, &out, 1), -2);
+
+	// after reset stream starts again and does not reference previous data
+	blazer_stream_ctx_reset(encoder);
+	out.length = (int32_t)compressed.size();
+	int32_t comprLength = blazer_stream_compress_segments(encoder, &in, 1, &out, 1);
+	CHECK(comprLength > 0);
+
+	std::vector<unsigned char> decompressed(1000);
+	blazer_segment decIn = { &compressed[0], comprLength };
+	blazer_segment decOut = { &decompressed[0], 999 };
+	CHECK_EQ(blazer_stream_decompress_segments(decoder, &decIn, 1, &decOut, 1), -1);
+	decOut.length = 1000;
+	CHECK_EQ(blazer_stream_decompress_segments(decoder, &decIn, 1, &decOut, 1), 1000);
+	CHECK(memcmp(&decompressed[0], &data[0], 1000) == 0);
+
+	blazer_stream_ctx_destroy(encoder);
+	blazer_stream_ctx_destroy(decoder);
+}
+
+int main()
+{
+	TestSameAsContiguous(BLAZER_STREAM_LEVEL_MIN, 1);
+	TestSameAsContiguous(BLAZER_STREAM_LEVEL_DEFAULT, 2);
+	TestSameAsContiguous(BLAZER_STREAM_LEVEL_HIGH, 3);
+	TestErrors();
+	return TEST_RESULT();
+}
@@ -0,0 +1,184 @@
+// Checks snapshots of stream context: full snapshot should continue stream with same result as original context,
+// compact snapshot should continue stream which is decoded by restored decoder, damaged snapshots should be rejected
+
+#include "TestHelper.h"
+#include "Blazer.h"
+
+static const int32_t MaxBlockSize = 20000;
+static const int32_t BlockCount = 60;
+
+static std::vector<unsigned char> Snapshot(blazer_stream_ctx* ctx, int32_t mode)
+{
+	std::vector<unsigned char> snapshot((size_t)blazer_stream_ctx_snapshot_size(ctx, mode));
+	CHECK_EQ(blazer_stream_ctx_snapshot(ctx, mode, &snapshot[0], (int64_t)snapshot.size()), snapshot.size());
+	return snapshot;
+}
+
+static int32_t Compress(blazer_stream_ctx* ctx, unsigned char* data, int32_t length, std::vector<unsigned char>& out)
+{
+	out.resize(length + (length >> 8) + 16);
+	blazer_segment in = { data, length };
+	blazer_segment seg = { &out[0], (int32_t)out.size() };
+	int32_t res = blazer_stream_compress_segments(ctx, &in, 1, &seg, 1);
+	CHECK(res > 0);
+	out.resize(res > 0 ? res : 0);
+	return res;
+}
+
+static void Decompress(blazer_stream_ctx* ctx, std::vector<unsigned char>& compressed, const unsigned char* expected, int32_t length)
+{
+	std::vector<unsigned char> out(length);
+	blazer_segment in = { &compressed[0], (int32_t)compressed.size() };
+	blazer_segment seg = { &out[0], length };
+	CHECK_EQ(blazer_stream_decompress_segments(ctx, &in, 1, &seg, 1), length);
+	CHECK(memcmp(&out[0], expected, length) == 0);
+}
+
+static void TestFull(int32_t level)
+{
+	std::vector<unsigned char> data = GenerateTestData(MaxBlockSize * BlockCount, (uint32_t)level);
+	blazer_stream_ctx* encoder = blazer_stream_ctx_create(NULL, 0, MaxBlockSize, level);
+	blazer_stream_ctx* decoder = blazer_stream_ctx_create(NULL, 0, MaxBlockSize, 0);
+	blazer_stream_ctx* restoredEncoder = blazer_stream_ctx_create(NULL, 0, MaxBlockSize, level);
+	blazer_stream_ctx* restoredDecoder = blazer_stream_ctx_create(NULL, 0, MaxBlockSize * 2, 0);
+	std::vector<unsigned char> compressed, restoredCompressed;
+	for (int32_t i = 0; i < BlockCount; i++)
+	{
+		unsigned char* block = &data[(size_t)i * MaxBlockSize];
+		int32_t length = MaxBlockSize - i * 7;
+		Compress(encoder, block, length, compressed);
+		if (i < BlockCount / 2)
+		{
+			Decompress(decoder, compressed, block, length);
+			continue;
+		}
+
+		if (i == BlockCount / 2)
+		{
+			CHECK_EQ(blazer_stream_ctx_restore(restoredEncoder, &Snapshot(encoder, BLAZER_SNAPSHOT_FULL)[0], blazer_stream_ctx_snapshot_size(encoder, BLAZER_SNAPSHOT_FULL)), 0);
+			std::vector<unsigned char> snapshot = Snapshot(decoder, BLAZER_SNAPSHOT_FULL);
+			// decoder has no table
+			CHECK_EQ(snapshot.size(), blazer_stream_ctx_snapshot_size(decoder, BLAZER_SNAPSHOT_COMPACT));
+			CHECK_EQ(blazer_stream_ctx_restore(restoredDecoder, &snapshot[0], (int64_t)snapshot.size()), 0);
+			// block was compressed by original encoder after snapshot
+			Decompress(restoredDecoder, compressed, block, length);
+			continue;
+		}
+
+		Compress(restoredEncoder, block, length, restoredCompressed);
+		CHECK(compressed == restoredCompressed);
+		Decompress(restoredDecoder, restoredCompressed, block, length);
+	}
+
+	blazer_stream_ctx_destroy(encoder);
+	blazer_stream_ctx_destroy(decoder);
+	blazer_stream_ctx_destroy(restoredEncoder);
+	blazer_stream_ctx_destroy(restoredDecoder);
+}
+
+// encoder is restored from compact snapshot into context with other level and block size
+static void TestCompact(int32_t level, int32_t restoredLevel)
+{
+	std::vector<unsigned char> data = GenerateTestData(MaxBlockSize * BlockCount, (uint32_t)level + 100);
+	blazer_stream_ctx* encoder = blazer_stream_ctx_create(NULL, 0, MaxBlockSize, level);
+	blazer_stream_ctx* decoder = blazer_stream_ctx_create(NULL, 0, MaxBlockSize, 0);
+	blazer_stream_ctx* reference = blazer_stream_ctx_create(NULL, 0, MaxBlockSize, restoredLevel);
+	std::vector<unsigned char> compressed;
+	int64_t restoredTotal = 0;
+	int64_t referenceTotal = 0;
+	for (int32_t i = 0; i < BlockCount; i++)
+	{
+		unsigned char* block = &data[(size_t)i * MaxBlockSize];
+		if (i == BlockCount / 2)
+		{
+			std::vector<unsigned char> snapshot = Snapshot(encoder, BLAZER_SNAPSHOT_COMPACT);
+			CHECK(snapshot.size() < 65792 + 64);
+			blazer_stream_ctx_destroy(encoder);
+			encoder = blazer_stream_ctx_create(NULL, 0, MaxBlockSize / 3, restoredLevel);
+			CHECK_EQ(blazer_stream_ctx_restore(encoder, &snapshot[0], (int64_t)snapshot.size()), 0);
+			// table is not built yet, so it is not saved
+			CHECK_EQ(blazer_stream_ctx_snapshot_size(encoder, BLAZER_SNAPSHOT_FULL), snapshot.size());
+
+			snapshot = Snapshot(decoder, BLAZER_SNAPSHOT_COMPACT);
+			blazer_stream_ctx_destroy(decoder);
+			decoder = blazer_stream_ctx_create(NULL, 0, MaxBlockSize, 0);
+			CHECK_EQ(blazer_stream_ctx_restore(decoder, &snapshot[0], (int64_t)snapshot.size()), 0);
+		}
+
+		// restored context has smaller blocks
+		int32_t length = i < BlockCount / 2 ? MaxBlockSize : MaxBlockSize / 3;
+		std::vector<unsigned char> referenceCompressed;
+		int32_t referenceLength = Compress(reference, block, length, referenceCompressed);
+		int32_t comprLength = Compress(encoder, block, length, compressed);
+		Decompress(decoder, compressed, block, length);
+		if (i >= BlockCount / 2)
+		{
+			restoredTotal += comprLength;
+			referenceTotal += referenceLength;
+		}
+	}
+
+	// history is same, so ratio is close to context which was never saved
+	CHECK(restoredTotal < referenceTotal + referenceTotal / 50);
+	blazer_stream_ctx_destroy(encoder);
+	blazer_stream_ctx_destroy(decoder);
+	blazer_stream_ctx_destroy(reference);
+}
+
+// context in memory of caller, which is not zeroed, should start with valid table, so full snapshot saves it
+static void TestCallerMemory()
+{
+	std::vector<unsigned char> data = GenerateTestData(MaxBlockSize, 7);
+	std::vector<unsigned char> memory(blazer_stream_ctx_size(MaxBlockSize, BLAZER_STREAM_LEVEL_DEFAULT), 0xab);
+	blazer_stream_ctx* encoder = blazer_stream_ctx_create(&memory[0], memory.size(), MaxBlockSize, BLAZER_STREAM_LEVEL_DEFAULT);
+	blazer_stream_ctx* reference = blazer_stream_ctx_create(NULL, 0, MaxBlockSize, BLAZER_STREAM_LEVEL_DEFAULT);
+	CHECK(blazer_stream_ctx_snapshot_size(encoder, BLAZER_SNAPSHOT_FULL) > blazer_stream_ctx_snapshot_size(encoder, BLAZER_SNAPSHOT_COMPACT));
+	CHECK_EQ(blazer_stream_ctx_snapshot_size(encoder, BLAZER_SNAPSHOT_FULL), blazer_stream_ctx_snapshot_size(reference, BLAZER_SNAPSHOT_FULL));
+	std::vector<unsigned char> compressed, referenceCompressed;
+	Compress(encoder, &data[0], MaxBlockSize, compressed);
+	Compress(reference, &data[0], MaxBlockSize, referenceCompressed);
+	CHECK(compressed == referenceCompressed);
+	CHECK(Snapshot(encoder, BLAZER_SNAPSHOT_FULL) == Snapshot(reference, BLAZER_SNAPSHOT_FULL));
+	blazer_stream_ctx_destroy(encoder);
+	blazer_stream_ctx_destroy(reference);
+}
+
+static void TestErrors()
+{
+	std::vector<unsigned char> data = GenerateTestData(MaxBlockSize, 5);
+	blazer_stream_ctx* encoder = blazer_stream_ctx_create(NULL, 0, MaxBlockSize, BLAZER_STREAM_LEVEL_DEFAULT);
+	blazer_stream_ctx* other = blazer_stream_ctx_create(NULL, 0, MaxBlockSize, BLAZER_STREAM_LEVEL_HIGH);
+	CHECK_EQ(blazer_stream_ctx_snapshot_size(encoder, 2), -1);
+
+	// empty context
+	std::vector<unsigned char> snapshot = Snapshot(encoder, BLAZER_SNAPSHOT_COMPACT);
+	CHECK_EQ(blazer_stream_ctx_restore(other, &snapshot[0], (int64_t)snapshot.size()), 0);
+
+	std::vector<unsigned char> compressed;
+	Compress(encoder, &data[0], MaxBlockSize, compressed);
+	snapshot = Snapshot(encoder, BLAZER_SNAPSHOT_FULL);
+	CHECK_EQ(blazer_stream_ctx_snapshot(encoder, BLAZER_SNAPSHOT_FULL, &snapshot[0], (int64_t)snapshot.size() - 1), -1);
+	CHECK_EQ(blazer_stream_ctx_restore(other, &snapshot[0], (int64_t)snapshot.size()), -2);
+	CHECK_EQ(blazer_stream_ctx_restore(encoder, &snapshot[0], (int64_t)snapshot.size() - 1), -1);
+	CHECK_EQ(blazer_stream_ctx_restore(encoder, &snapshot[0], 10), -1);
+	snapshot[100] ^= 1;
+	CHECK_EQ(blazer_stream_ctx_restore(encoder, &snapshot[0], (int64_t)snapshot.size()), -1);
+	snapshot[100] ^= 1;
+	snapshot[0] = 'x';
+	CHECK_EQ(blazer_stream_ctx_restore(encoder, &snapshot[0], (int64_t)snapshot.size()), -1);
+
+	blazer_stream_ctx_destroy(encoder);
+	blazer_stream_ctx_destroy(other);
+}
+
+int main()
+{
+	for (int32_t level = BLAZER_STREAM_LEVEL_MIN; level <= BLAZER_STREAM_LEVEL_MAX; level++)
+		TestFull(level);
+	TestCompact(BLAZER_STREAM_LEVEL_DEFAULT, BLAZER_STREAM_LEVEL_DEFAULT);
+	TestCompact(BLAZER_STREAM_LEVEL_MIN, BLAZER_STREAM_LEVEL_MAX);
+	TestCompact(BLAZER_STREAM_LEVEL_HIGH, 4);
+	TestCallerMemory();
+	TestErrors();
+	return TEST_RESULT();
+}
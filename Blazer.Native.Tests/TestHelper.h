@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+
+static int _failedChecks = 0;
+
+#define CHECK(cond) \
+	do { if (!(cond)) { fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); _failedChecks++; } } while (0)
+
+#define CHECK_EQ(a, b) \
+	do { long long _a = (long long)(a), _b = (long long)(b); if (_a != _b) { fprintf(stderr, "%s:%d: check failed: %s == %s (%lld != %lld)\n", __FILE__, __LINE__, #a, #b, _a, _b); _failedChecks++; } } while (0)
+
+#define TEST_RESULT() (_failedChecks == 0 ? 0 : (fprintf(stderr, "%d check(s) failed\n", _failedChecks), 1))
+
+// simple deterministic generator, data should be same on every platform
+struct TestRandom
+{
+	uint32_t state;
+
+	explicit TestRandom(uint32_t seed) : state(seed) {}
+
+	uint32_t Next()
+	{
+		state = state * 1103515245 + 12345;
+		return state >> 8;
+	}
+};
+
+// log-like text with repeated words, numbers and some binary noise
+inline std::vector<unsigned char> GenerateTestData(size_t length, uint32_t seed)
+{
+	static const char* words[] = { "INFO", "DEBUG", "WARN", "ERROR", "request", "response", "user", "session",
+		"completed", "failed", "connection", "timeout", "{\"id\":", "\"name\":", "\"value\":", "blazer", "stream", "block" };
+	const size_t wordsCount = sizeof(words) / sizeof(words[0]);
+
+	TestRandom rnd(seed);
+	std::vector<unsigned char> data;
+	data.reserve(length);
+	while (data.size() < length)
+	{
+		uint32_t kind = rnd.Next() % 16;
+		if (kind < 11)
+		{
+			const char* w = words[rnd.Next() % wordsCount];
+			data.insert(data.end(), w, w + strlen(w));
+			data.push_back(' ');
+		}
+		else if (kind < 14)
+		{
+			char num[16];
+			int len = sprintf(num, "%u", rnd.Next() % 100000);
+			data.insert(data.end(), num, num + len);
+			data.push_back(kind == 13 ? '\n' : ',');
+		}
+		else if (kind == 14)
+		{
+			uint32_t cnt = rnd.Next() % 32;
+			for (uint32_t i = 0; i < cnt; i++)
+				data.push_back((unsigned char)rnd.Next());
+		}
+		else
+		{
+			data.insert(data.end(), rnd.Next() % 300, (unsigned char)0);
+		}
+	}
+
+	data.resize(length);
+	return data;
+}
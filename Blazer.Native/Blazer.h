@@ -0,0 +1,679 @@
+// Blazer.h : exported functions of Blazer native library
+//
+// All offsets and lengths are same as in managed Blazer.Net encoders and decoders:
+// bufferInLength and bufferOutLength are right offsets (offset + count), not counts
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef BLAZER_API
+#if defined(_WIN32) && !defined(BLAZER_STATIC)
+#define BLAZER_API __declspec(dllimport)
+#else
+#define BLAZER_API
+#endif
+#endif
+
+/*
+	Decoders copy data by wide chunks while at least this count of bytes remains after current position
+	in in and out buffers, and switch to precise copying near the end. So, data is never written after bufferOutLength,
+	but for best speed out buffer should have this count of spare bytes after maximum size of decompressed data.
+*/
+#define BLAZER_DECOMPRESS_MARGIN 32
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+	Compresses block of data with stream algorithm.
+	hashArr should contain 65536 elements and should be same for consecutive blocks of one stream.
+	bufferInShift is additional offset of data in hashArr (is used to rotate history in long streams).
+	Positions in hashArr are stored modulo 2^32, so shift can grow with stream and overflow, hashArr never needs rebasing.
+	Returns count of written bytes (including bufferOutOffset).
+*/
+BLAZER_API int32_t blazer_stream_compress_block(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, int32_t bufferInShift, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr);
+
+/*
+	Flag for blazer_stream_compress_block_ex: adds every position of long matches to hash table (as managed encoder does).
+	By default, long matches are added sparsely, which is faster on repeated data but can give slightly worse compression rate.
+*/
+#define BLAZER_STREAM_DENSE_HASH 0x1
+
+/*
+	Flag for blazer_stream_compress_block_ex: before writing short match, checks match of next position
+	and takes it if it is better (lazy matching). Gives better compression rate, but is slower.
+*/
+#define BLAZER_STREAM_LAZY 0x2
+
+/*
+	Same as blazer_stream_compress_block with additional BLAZER_STREAM_* flags.
+*/
+BLAZER_API int32_t blazer_stream_compress_block_ex(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, int32_t bufferInShift, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, int32_t flags);
+
+/*
+	Levels of stream encoder for blazer_stream_compress_block_level. Output of any level is decompressed by blazer_stream_decompress_block.
+	1 - 4096 elements in hash table (fits in L1 cache, for small flushed messages), sparse hashing of long matches
+	2 - 16384 elements in hash table, sparse hashing
+	3 - 65536 elements in hash table, sparse hashing (same as blazer_stream_compress_block)
+	4 - 65536 elements in hash table, dense hashing (same as BLAZER_STREAM_DENSE_HASH and managed encoder)
+	5 - 262144 elements in hash table, dense hashing (fewer collisions, better compression rate)
+	6..9 - high compression (as StreamEncoderHigh): hash chains with lazy matching, every next level checks more positions
+*/
+#define BLAZER_STREAM_LEVEL_MIN 1
+#define BLAZER_STREAM_LEVEL_DEFAULT 3
+#define BLAZER_STREAM_LEVEL_HIGH 6
+#define BLAZER_STREAM_LEVEL_MAX 9
+
+/*
+	Returns count of elements in hashArr for level or 0 if level is invalid.
+*/
+BLAZER_API int32_t blazer_stream_hash_size(int32_t level);
+
+/*
+	Same as blazer_stream_compress_block with level of encoder.
+	hashArr should contain blazer_stream_hash_size(level) elements, level should be same for consecutive blocks of one stream.
+	Returns -1 if level is invalid.
+*/
+BLAZER_API int32_t blazer_stream_compress_block_level(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, int32_t bufferInShift, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, int32_t level);
+
+/*
+	Decompresses block of stream algorithm. Data before bufferOutOffset is used as history.
+	Returns right offset of decompressed data or negative value on invalid data:
+	-1 - out buffer is too small, -2 - in buffer is truncated, -3 - invalid back reference.
+*/
+BLAZER_API int32_t blazer_stream_decompress_block(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength);
+
+/*
+	Same as blazer_stream_compress_block_level, also calculates crc32c of input (bufferIn[bufferInOffset..bufferInLength))
+	into inCrc and of compressed data into outCrc. Checksums are updated by chunks during compression, while data is in cache,
+	so large blocks are not read again. Result is same as crc32c_append(0, ...) for these ranges. inCrc and outCrc can be null.
+*/
+BLAZER_API int32_t blazer_stream_compress_block_crc(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, int32_t bufferInShift, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, int32_t level, uint32_t* inCrc, uint32_t* outCrc);
+
+/*
+	Same as blazer_stream_decompress_block, also calculates crc32c of compressed data into inCrc and of decompressed data
+	(bufferOut[bufferOutOffset..result)) into outCrc during decompression. inCrc and outCrc can be null, they are not set on error.
+*/
+BLAZER_API int32_t blazer_stream_decompress_block_crc(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength, uint32_t* inCrc, uint32_t* outCrc);
+
+/*
+	Part of data for scatter/gather functions
+*/
+typedef struct blazer_segment
+{
+	unsigned char* data;
+	int32_t length;
+} blazer_segment;
+
+/*
+	Context of stream algorithm for data in segments: owns hash table and window of history, so data of blocks
+	can be passed as list of segments and history of stream spans their boundaries. Segments of block are copied once
+	into window (same as managed StreamEncoder does) instead of joining them by caller.
+	Context keeps history of one direction, encoder and decoder of stream should use different contexts.
+*/
+typedef struct blazer_stream_ctx blazer_stream_ctx;
+
+/*
+	Returns size of memory for blazer_stream_ctx_create or 0 if maxBlockSize (up to 16MB) or level is invalid.
+	Level is BLAZER_STREAM_LEVEL_* or 0 for context of decoder (it does not have hash table).
+*/
+BLAZER_API size_t blazer_stream_ctx_size(int32_t maxBlockSize, int32_t level);
+
+/*
+	Creates stream context in memory of memorySize bytes or allocates it if memory is null.
+	maxBlockSize is maximum total length of uncompressed data of one block.
+	Returns null if parameters are invalid, memory is too small or cannot be allocated.
+*/
+BLAZER_API blazer_stream_ctx* blazer_stream_ctx_create(void* memory, size_t memorySize, int32_t maxBlockSize, int32_t level);
+
+/*
+	Starts new stream.
+*/
+BLAZER_API void blazer_stream_ctx_reset(blazer_stream_ctx* ctx);
+
+/*
+	Destroys context, memory is released only if it was allocated by blazer_stream_ctx_create.
+*/
+BLAZER_API void blazer_stream_ctx_destroy(blazer_stream_ctx* ctx);
+
+/*
+	Compresses data of segments as next block of stream and writes result into out segments one after another.
+	Result is same as blazer_stream_compress_block_level for contiguous stream.
+	Returns count of written bytes or negative value on error: -1 if data is larger than maxBlockSize (or context has no level),
+	-2 if out segments are too small (block is already added to history, so stream should be reset).
+*/
+BLAZER_API int32_t blazer_stream_compress_segments(blazer_stream_ctx* ctx, const blazer_segment* segmentsIn, int32_t countIn, const blazer_segment* segmentsOut, int32_t countOut);
+
+/*
+	Decompresses block of stream from segments and writes result into out segments one after another.
+	Returns count of decompressed bytes or negative value on error: -1..-3 as for blazer_stream_decompress_block
+	(-1 also if data is larger than maxBlockSize or out segments), -4 if compressed block is larger than allowed for maxBlockSize.
+*/
+BLAZER_API int32_t blazer_stream_decompress_segments(blazer_stream_ctx* ctx, const blazer_segment* segmentsIn, int32_t countIn, const blazer_segment* segmentsOut, int32_t countOut);
+
+/*
+	Modes of snapshot of stream context. Full snapshot contains history and hash table, so compression continues
+	with same result as original context. Compact snapshot contains only history (up to 65792 bytes),
+	hash table is built from it before next compressed block, so result is slightly different, but ratio is almost same.
+*/
+#define BLAZER_SNAPSHOT_FULL 0
+#define BLAZER_SNAPSHOT_COMPACT 1
+
+/*
+	Returns size of snapshot of context in mode or -1 if mode is invalid.
+*/
+BLAZER_API int64_t blazer_stream_ctx_snapshot_size(const blazer_stream_ctx* ctx, int32_t mode);
+
+/*
+	Saves state of context (e.g. of idle connection or for moving of stream to other thread or process), so context can be
+	destroyed or reused. Snapshot has CRC32C and does not depend on platform. Context of decoder and context with table,
+	which is not built yet after compact restore, are saved in compact mode.
+	Returns size of snapshot or -1 if mode is invalid or outLength is less than blazer_stream_ctx_snapshot_size.
+*/
+BLAZER_API int64_t blazer_stream_ctx_snapshot(const blazer_stream_ctx* ctx, int32_t mode, unsigned char* out, int64_t outLength);
+
+/*
+	Restores state of context from snapshot. Full snapshot of encoder should be restored into context with same level,
+	compact snapshot can be restored into context with any level and maxBlockSize.
+	Returns 0, -1 if snapshot is invalid or damaged, -2 if level of full snapshot differs from level of context.
+*/
+BLAZER_API int32_t blazer_stream_ctx_restore(blazer_stream_ctx* ctx, const unsigned char* data, int64_t length);
+
+/*
+	Dictionary for compression of small independent messages by stream algorithm: data of dictionary is history
+	of every message, so message can reference data which is common for all messages (e.g. keys of JSON).
+	Only last BLAZER_DICT_MAX_SIZE bytes of dictionary are used (back references cannot be longer).
+	Message starts with id of dictionary (4 bytes, little-endian), rest is same as patterned data of Blazer.Net.
+	Dictionary is not changed after creation and can be shared by several threads.
+*/
+typedef struct blazer_dict blazer_dict;
+
+#define BLAZER_DICT_MAX_SIZE ((1 << 16) + 256)
+#define BLAZER_DICT_HEADER_SIZE 5
+
+/*
+	Creates dictionary from data and primes hash table of stream encoder of level (BLAZER_STREAM_LEVEL_*, 0 - default) by it.
+	id is written into messages and checked by decoder, 0 - CRC32C of used data of dictionary.
+	Returns null if parameters are invalid or memory cannot be allocated.
+*/
+BLAZER_API blazer_dict* blazer_dict_create(const unsigned char* data, int32_t length, uint32_t id, int32_t level);
+
+BLAZER_API uint32_t blazer_dict_get_id(const blazer_dict* dict);
+
+BLAZER_API void blazer_dict_destroy(blazer_dict* dict);
+
+/*
+	Context for compression and decompression of messages with dictionary: owns copy of primed hash table and window
+	with dictionary. Table is returned to primed state after every message by restoring of changed entries only,
+	so small message costs as much as its length. Context can be used by one thread at a time, dictionary should live until context is destroyed.
+*/
+typedef struct blazer_dict_ctx blazer_dict_ctx;
+
+/*
+	Returns size of memory for blazer_dict_ctx_create or 0 if maxMessageSize (up to 16MB) is invalid.
+*/
+BLAZER_API size_t blazer_dict_ctx_size(const blazer_dict* dict, int32_t maxMessageSize);
+
+/*
+	Creates context in memory of memorySize bytes or allocates it if memory is null.
+	Returns null if parameters are invalid, memory is too small or cannot be allocated.
+*/
+BLAZER_API blazer_dict_ctx* blazer_dict_ctx_create(void* memory, size_t memorySize, const blazer_dict* dict, int32_t maxMessageSize);
+
+/*
+	Destroys context, memory is released only if it was allocated by blazer_dict_ctx_create.
+*/
+BLAZER_API void blazer_dict_ctx_destroy(blazer_dict_ctx* ctx);
+
+/*
+	Returns required size of out buffer for blazer_dict_compress.
+*/
+BLAZER_API int32_t blazer_dict_compress_bound(int32_t length);
+
+/*
+	Compresses message with dictionary of context. Result does not depend on previous messages.
+	Returns count of written bytes or -1 if message is larger than maxMessageSize or outLength is less than blazer_dict_compress_bound.
+*/
+BLAZER_API int32_t blazer_dict_compress(blazer_dict_ctx* ctx, const unsigned char* in, int32_t length, unsigned char* out, int32_t outLength);
+
+/*
+	Decompresses message with dictionary of context.
+	Returns count of decompressed bytes or negative value on error: -1..-3 as for blazer_stream_decompress_block
+	(-1 also if data is larger than outLength or maxMessageSize), -4 if header is invalid, -5 if message has id of other dictionary.
+*/
+BLAZER_API int32_t blazer_dict_decompress(blazer_dict_ctx* ctx, const unsigned char* in, int32_t length, unsigned char* out, int32_t outLength);
+
+/*
+	Returns id of dictionary of compressed message (to select dictionary for decoding) or 0 if message is too short.
+*/
+BLAZER_API uint32_t blazer_dict_message_id(const unsigned char* in, int32_t length);
+
+/*
+	Builds dictionary from sample messages, which are placed one after another in samples (sampleLengths contains their lengths).
+	Dictionary consists of segments of samples with most frequent sequences, most valuable are placed at its end.
+	Samples which fit into dictCapacity are copied as is. Trainer needs 4 bytes of memory per byte of samples.
+	Returns length of dictionary or -1 if parameters are invalid or memory cannot be allocated.
+*/
+BLAZER_API int32_t blazer_dict_train(const unsigned char* samples, const int32_t* sampleLengths, int32_t sampleCount, unsigned char* dict, int32_t dictCapacity);
+
+/*
+	Compresses independent block of data with block algorithm.
+	hashArr should contain 65536 zeroed elements, can be null (will be allocated internally).
+*/
+BLAZER_API int32_t blazer_block_compress_block(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr);
+
+/*
+	Decompresses independent block of block algorithm.
+	hashArr should contain 65536 zeroed elements, can be null (will be allocated internally).
+	Returns right offset of decompressed data or negative value on invalid data.
+*/
+BLAZER_API int32_t blazer_block_decompress_block(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength, int32_t* hashArr);
+
+/*
+	Same as blazer_block_compress_block, also calculates crc32c of input and of compressed data during compression,
+	as blazer_stream_compress_block_crc does. inCrc and outCrc can be null.
+	Returns -1 if hashArr is null and internal hash table cannot be allocated.
+*/
+BLAZER_API int32_t blazer_block_compress_block_crc(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, uint32_t* inCrc, uint32_t* outCrc);
+
+/*
+	Same as blazer_block_decompress_block, also calculates crc32c of compressed and of decompressed data during decompression,
+	as blazer_stream_decompress_block_crc does. inCrc and outCrc can be null, they are not set on error.
+	Returns -1 if hashArr is null and internal hash table cannot be allocated.
+*/
+BLAZER_API int32_t blazer_block_decompress_block_crc(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength, int32_t* hashArr, uint32_t* inCrc, uint32_t* outCrc);
+
+/*
+	Type of block in framed format for data of block algorithm with explicit offsets (variant 1 of algorithm 2).
+	Blocks of this type are written by blazer_frame_encoder_use_offsets and are not supported by managed decoder.
+*/
+#define BLAZER_BLOCK_TYPE_BLOCK_OFFSETS 0x12
+
+/*
+	Compresses independent block of data with block algorithm, but far matches are written with explicit offsets
+	(2 bytes up to 32KB, 3 bytes up to 8MB) instead of hash keys, so decoder does not rebuild hash table and works
+	as fast as decoder of stream algorithm. Matches are same as blazer_block_compress_block finds (except ones further than 8MB),
+	so result is slightly larger only for data with many matches further than 32KB.
+	hashArr should contain 65536 zeroed elements, can be null (will be allocated internally).
+*/
+BLAZER_API int32_t blazer_block_compress_offsets(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr);
+
+/*
+	Decompresses independent block of blazer_block_compress_offsets, no hash table is needed.
+	Returns right offset of decompressed data or negative value on invalid data.
+*/
+BLAZER_API int32_t blazer_block_decompress_offsets(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength);
+
+/*
+	Context of block algorithm: owns hash table, which is reused by every call without clearing,
+	so small blocks are compressed without allocation and initialization of 256KB table for every block.
+	Context can be used by one thread at a time, for parallel work every thread should have own context.
+*/
+typedef struct blazer_ctx blazer_ctx;
+
+/*
+	Returns size of memory for blazer_ctx_create (including space for alignment of memory).
+*/
+BLAZER_API size_t blazer_ctx_size(void);
+
+/*
+	Creates context in memory of memorySize bytes (e.g. in arena of caller) or allocates it if memory is null.
+	Memory should live until context is destroyed. Returns null if memory is too small or cannot be allocated.
+*/
+BLAZER_API blazer_ctx* blazer_ctx_create(void* memory, size_t memorySize);
+
+/*
+	Forgets data of previous calls. Is cheap: tables are not cleared.
+*/
+BLAZER_API void blazer_ctx_reset(blazer_ctx* ctx);
+
+/*
+	Destroys context, memory is released only if it was allocated by blazer_ctx_create.
+*/
+BLAZER_API void blazer_ctx_destroy(blazer_ctx* ctx);
+
+/*
+	Same as blazer_block_compress_block with hash table of context, result is same.
+*/
+BLAZER_API int32_t blazer_ctx_block_compress(blazer_ctx* ctx, unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset);
+
+/*
+	Same as blazer_block_compress_offsets with hash table of context, result is same.
+*/
+BLAZER_API int32_t blazer_ctx_block_compress_offsets(blazer_ctx* ctx, unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset);
+
+/*
+	Same as blazer_block_decompress_block with hash table of context.
+*/
+BLAZER_API int32_t blazer_ctx_block_decompress(blazer_ctx* ctx, unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength);
+
+/*
+	Returns required size of out buffer for blazer_block_compress_parallel.
+*/
+BLAZER_API int64_t blazer_block_compress_bound(int64_t bufferInLength, int32_t blockSize);
+
+/*
+	Compresses data by independent blocks of blockSize bytes in threadCount threads (0 - count of processors).
+	Result is same as sequential blazer_block_compress_block calls for every block, compressed blocks are written
+	one after another in original order. Can be called for consecutive parts of stream.
+	bufferOut should have blazer_block_compress_bound bytes, blockSizes receives compressed size of every block.
+	Returns total size of compressed data or -1 on error.
+*/
+BLAZER_API int64_t blazer_block_compress_parallel(unsigned char* bufferIn, int64_t bufferInLength, int32_t blockSize, unsigned char* bufferOut, int32_t* blockSizes, int32_t threadCount);
+
+/*
+	Description of one independent block for blazer_block_decompress_parallel
+*/
+typedef struct blazer_block_frame
+{
+	int64_t inOffset;		// offset of block data in in buffer
+	int64_t outOffset;		// offset of decompressed data in out buffer
+	int32_t inLength;		// length of block data
+	int32_t outLength;		// maximum length of decompressed data, receives real length (or error code) after decompression
+	uint32_t crc;			// crc32c of block data (as in Blazer stream), is checked only if checkCrc is set
+	int32_t isCompressed;	// 0 for blocks stored without compression
+} blazer_block_frame;
+
+/*
+	Decompresses independent blocks of block algorithm in threadCount threads (0 - count of processors).
+	Every block is decompressed into own region of out buffer, regions should not overlap.
+	Returns total size of decompressed data or negative value on error (error of first invalid frame):
+	-1..-3 - invalid data, -4 - invalid crc, -5 - frame is out of buffers.
+*/
+BLAZER_API int64_t blazer_block_decompress_parallel(unsigned char* bufferIn, int64_t bufferInLength, unsigned char* bufferOut, int64_t bufferOutLength, blazer_block_frame* frames, int32_t frameCount, int32_t checkCrc, int32_t threadCount);
+
+/*
+	Algorithms of framed format (same as BlazerAlgorithm in Blazer.Net)
+*/
+#define BLAZER_ALGORITHM_NO_COMPRESS 0
+#define BLAZER_ALGORITHM_STREAM 1
+#define BLAZER_ALGORITHM_BLOCK 2
+
+/*
+	Flags of framed format (same as BlazerFlags in Blazer.Net). Low 4 bits are size of block: 512 << value (512 bytes..16MB),
+	in header bits 4..7 contain algorithm. Encryption, file info and comment are not supported by native library.
+*/
+#define BLAZER_FLAG_BLOCK_SIZE_MASK 0x0f
+#define BLAZER_FLAG_INCLUDE_CRC 0x100
+#define BLAZER_FLAG_INCLUDE_HEADER 0x200
+#define BLAZER_FLAG_INCLUDE_FOOTER 0x400
+#define BLAZER_FLAG_RESPECT_FLUSH 0x800
+#define BLAZER_FLAGS_DEFAULT (BLAZER_FLAG_INCLUDE_CRC | BLAZER_FLAG_INCLUDE_HEADER | BLAZER_FLAG_INCLUDE_FOOTER | BLAZER_FLAG_RESPECT_FLUSH)
+#define BLAZER_FLAGS_DEFAULT_STREAM (BLAZER_FLAGS_DEFAULT | 7)
+#define BLAZER_FLAGS_DEFAULT_BLOCK (BLAZER_FLAGS_DEFAULT | 12)
+
+/*
+	Encoder of framed format (.blz data of BlazerInputStream): header, blocks with type, length and CRC32C, footer.
+	Data is collected into one block, which is compressed when it is full or flushed. If compressed block is larger than
+	data, it is written without compression. Encoder can be used by one thread at a time.
+*/
+typedef struct blazer_frame_encoder blazer_frame_encoder;
+
+/*
+	Creates encoder. flags are BLAZER_FLAG_*, algorithm is BLAZER_ALGORITHM_*, level is used by stream algorithm
+	(BLAZER_STREAM_LEVEL_*, 0 - default). Returns null if parameters are invalid or memory cannot be allocated.
+*/
+BLAZER_API blazer_frame_encoder* blazer_frame_encoder_create(uint32_t flags, int32_t algorithm, int32_t level);
+
+BLAZER_API void blazer_frame_encoder_destroy(blazer_frame_encoder* encoder);
+
+/*
+	Returns size of out buffer, which is enough for writing of length bytes with following flush and finish.
+	If index is enabled, size includes index for all blocks written so far, so finish may need more space than
+	earlier calls of write and flush.
+*/
+BLAZER_API int64_t blazer_frame_encoder_bound(const blazer_frame_encoder* encoder, int64_t length);
+
+/*
+	Adds data to stream. Full blocks are compressed and written to out buffer.
+	Returns count of written bytes or -1 if outLength is less than blazer_frame_encoder_bound(length) (nothing is done in this case).
+*/
+BLAZER_API int64_t blazer_frame_encoder_write(blazer_frame_encoder* encoder, const unsigned char* data, int64_t length, unsigned char* out, int64_t outLength);
+
+/*
+	Writes collected data as block if BLAZER_FLAG_RESPECT_FLUSH is set (otherwise only header is written if it was not written yet).
+	Returns count of written bytes or -1 if out buffer is too small.
+*/
+BLAZER_API int64_t blazer_frame_encoder_flush(blazer_frame_encoder* encoder, unsigned char* out, int64_t outLength);
+
+/*
+	Writes collected data and footer. Encoder cannot be used after this call.
+	Returns count of written bytes or -1 if out buffer is too small.
+*/
+BLAZER_API int64_t blazer_frame_encoder_finish(blazer_frame_encoder* encoder, unsigned char* out, int64_t outLength);
+
+/*
+	Enables index of blocks for random access (see blazer_indexed_file_open). Index is written by blazer_frame_encoder_finish
+	before footer into control data blocks, so decoders without index support skip it.
+	Should be called before any data, supported by independent blocks only (BLAZER_ALGORITHM_STREAM needs
+	blazer_frame_encoder_set_restart_interval). Returns 0 or -1 if index cannot be enabled.
+*/
+BLAZER_API int32_t blazer_frame_encoder_enable_index(blazer_frame_encoder* encoder);
+
+/*
+	Enables index with restart points: block, which starts at least interval bytes after previous restart point, is new
+	restart point. History of stream algorithm (hash table and window of back references) is dropped before it,
+	so data can be decoded from any restart point and damaged block does not affect data after next one.
+	With blocks of full size interval of N * block size gives restart point every N blocks, 0 - every block.
+	Index has one entry per restart point. Should be called before any data, returns 0 or -1 if interval is invalid.
+*/
+BLAZER_API int32_t blazer_frame_encoder_set_restart_interval(blazer_frame_encoder* encoder, int64_t interval);
+
+/*
+	Writes blocks of BLAZER_ALGORITHM_BLOCK with explicit offsets (BLAZER_BLOCK_TYPE_BLOCK_OFFSETS, see blazer_block_compress_offsets),
+	which are decoded faster. Such data is read by native decoder only. Should be called before any data,
+	returns 0 or -1 if algorithm of encoder is not BLAZER_ALGORITHM_BLOCK.
+*/
+BLAZER_API int32_t blazer_frame_encoder_use_offsets(blazer_frame_encoder* encoder);
+
+/*
+	Statistics of adaptive encoding, counts are of data blocks and their uncompressed bytes
+*/
+typedef struct blazer_adaptive_stats
+{
+	int64_t rawBlocks;			// blocks which were stored without compression by probe
+	int64_t rawBytes;
+	int64_t compressedBlocks;	// blocks which were compressed by level of encoder
+	int64_t compressedBytes;
+	int64_t highBlocks;			// blocks which were compressed by high level
+	int64_t highBytes;
+	int64_t expandedBlocks;		// compressed blocks, which were stored as is because compressed data was not smaller
+	int64_t probeNanoseconds;	// time of probes
+} blazer_adaptive_stats;
+
+/*
+	Enables adaptive encoding: before compression every block is probed by fast search of repeats in sampled segments
+	(about 8KB of block). Blocks where less than 5% of sampled data repeats (e.g. already compressed data) are stored
+	without compression, so incompressible data is written many times faster. For BLAZER_ALGORITHM_STREAM blocks where
+	more than 80% repeats are compressed by highLevel (0 - level of encoder is used for all blocks), output of all levels
+	is decoded by same decoder. Should be called before any data, returns 0 or -1 if algorithm is BLAZER_ALGORITHM_NO_COMPRESS,
+	highLevel is invalid or memory cannot be allocated.
+*/
+BLAZER_API int32_t blazer_frame_encoder_set_adaptive(blazer_frame_encoder* encoder, int32_t highLevel);
+
+/*
+	Returns statistics of blocks written so far. Decisions of probe are counted only if adaptive encoding is enabled,
+	otherwise blocks of compressing algorithms are counted as compressed.
+*/
+BLAZER_API void blazer_frame_encoder_get_adaptive_stats(const blazer_frame_encoder* encoder, blazer_adaptive_stats* stats);
+
+/*
+	Returns count of bytes per 1000 of data, which are covered by repeats of earlier data in sampled segments of block,
+	same probe is used by adaptive encoding. Returns -1 if memory cannot be allocated.
+*/
+BLAZER_API int32_t blazer_probe_block(const unsigned char* data, int32_t length);
+
+/*
+	Decoder of framed format (.blz data of BlazerOutputStream). Keeps at most one compressed and one decompressed block.
+	Control data, comment and file info blocks are skipped.
+*/
+typedef struct blazer_frame_decoder blazer_frame_decoder;
+
+/*
+	Creates decoder. If flags contain BLAZER_FLAG_INCLUDE_HEADER, flags and algorithm are read from header of data,
+	otherwise flags describe data without header and bits 4..7 contain algorithm (as in header).
+	Returns null if flags are invalid or memory cannot be allocated.
+*/
+BLAZER_API blazer_frame_decoder* blazer_frame_decoder_create(uint32_t flags);
+
+BLAZER_API void blazer_frame_decoder_destroy(blazer_frame_decoder* decoder);
+
+/*
+	Errors of blazer_frame_decode
+*/
+#define BLAZER_FRAME_ERROR_HEADER -1		// data is not Blazer stream or is created by other version
+#define BLAZER_FRAME_ERROR_FLAGS -2			// stream uses unsupported flags (e.g. encryption)
+#define BLAZER_FRAME_ERROR_BLOCK -3			// invalid type or length of block, or invalid footer
+#define BLAZER_FRAME_ERROR_CRC -4			// crc of block is invalid
+#define BLAZER_FRAME_ERROR_DATA -5			// compressed data is invalid
+#define BLAZER_FRAME_ERROR_MEMORY -6		// buffers for block size of stream cannot be allocated
+#define BLAZER_FRAME_ERROR_TRUNCATED -7	// stream ends inside of block or before footer
+
+/*
+	Decodes next part of stream. inLength is count of bytes in in buffer, outLength is size of out buffer,
+	they receive count of consumed and written bytes. Decoding stops when all input is consumed or out buffer is full.
+	Returns 1 if footer is read (end of stream), 0 if more data is required, or BLAZER_FRAME_ERROR_*
+	(decoder cannot be used after error).
+*/
+BLAZER_API int32_t blazer_frame_decode(blazer_frame_decoder* decoder, const unsigned char* in, size_t* inLength, unsigned char* out, size_t* outLength);
+
+/*
+	Checks state of decoder after all input is passed to blazer_frame_decode.
+	Returns 1 if footer is read or stream without footer ends between blocks and all data is returned,
+	BLAZER_FRAME_ERROR_TRUNCATED if stream is incomplete, or error of previous call.
+*/
+BLAZER_API int32_t blazer_frame_decoder_end(blazer_frame_decoder* decoder);
+
+/*
+	Resets decoder to start of block and clears error, e.g. for reading of other part of stream. Flags of stream are kept
+	(file header is expected only if it is not read yet). Next block should not reference previous data.
+*/
+BLAZER_API void blazer_frame_decoder_reset(blazer_frame_decoder* decoder);
+
+/*
+	Errors of file functions, blazer_file_decompress also returns BLAZER_FRAME_ERROR_* on invalid data
+*/
+#define BLAZER_FILE_ERROR_INPUT -8			// input file cannot be opened or mapped into memory
+#define BLAZER_FILE_ERROR_OUTPUT -9			// output file cannot be created or written
+#define BLAZER_FILE_ERROR_ARGUMENT -10		// flags, algorithm or level are not supported by blazer_frame_encoder_create
+#define BLAZER_FILE_ERROR_INDEX -11			// file has no index or index is invalid
+
+/*
+	Compresses file to file of framed format (same as blazer_frame_encoder with given flags, algorithm and level).
+	Input file is mapped into memory with sequential access hint and blocks are compressed directly from mapping,
+	output is collected in large buffer and written by aligned chunks. Paths are in UTF-8.
+	Returns size of output file or BLAZER_FILE_ERROR_* (BLAZER_FRAME_ERROR_MEMORY if block cannot be compressed because of memory).
+*/
+BLAZER_API int64_t blazer_file_compress(const char* inPath, const char* outPath, uint32_t flags, int32_t algorithm, int32_t level);
+
+/*
+	Decompresses file of framed format with header. Input file is mapped into memory and whole blocks are decoded
+	directly from mapping into output buffer.
+	Returns size of output file, BLAZER_FILE_ERROR_* or BLAZER_FRAME_ERROR_* (output file is incomplete in this case).
+*/
+BLAZER_API int64_t blazer_file_decompress(const char* inPath, const char* outPath);
+
+/*
+	Same as blazer_file_compress, but file has index of blocks (see blazer_frame_encoder_enable_index) for random access
+	by blazer_indexed_file_read.
+*/
+BLAZER_API int64_t blazer_file_compress_indexed(const char* inPath, const char* outPath, uint32_t flags, int32_t algorithm, int32_t level);
+
+/*
+	Same as blazer_file_compress, but file has index of restart points every restartInterval bytes
+	(see blazer_frame_encoder_set_restart_interval), so it can be read by blazer_indexed_file_read for any algorithm.
+*/
+BLAZER_API int64_t blazer_file_compress_restartable(const char* inPath, const char* outPath, uint32_t flags, int32_t algorithm, int32_t level, int64_t restartInterval);
+
+/*
+	Compressed file with index, which is opened for random access
+*/
+typedef struct blazer_indexed_file blazer_indexed_file;
+
+/*
+	Maps file with index into memory and reads its index.
+	Returns NULL on error, error receives BLAZER_FILE_ERROR_INPUT, BLAZER_FILE_ERROR_INDEX or BLAZER_FRAME_ERROR_*.
+*/
+BLAZER_API blazer_indexed_file* blazer_indexed_file_open(const char* path, int32_t* error);
+
+/*
+	Returns length of uncompressed data
+*/
+BLAZER_API int64_t blazer_indexed_file_length(const blazer_indexed_file* file);
+
+/*
+	Reads length bytes of uncompressed data from offset. Index is searched for nearest preceding restart point,
+	so only blocks from it up to end of requested data are decompressed. CRC32C of every block is checked (if file has CRC),
+	CRC32C of index entries is checked for entries which are decompressed completely.
+	Returns count of read bytes (less than length at end of data) or BLAZER_FRAME_ERROR_* (BLAZER_FILE_ERROR_ARGUMENT for negative offset).
+	File can be used by one thread at a time.
+*/
+BLAZER_API int64_t blazer_indexed_file_read(blazer_indexed_file* file, int64_t offset, unsigned char* out, int64_t length);
+
+BLAZER_API void blazer_indexed_file_close(blazer_indexed_file* file);
+
+/*
+	Statistics of one stage of file pipeline
+*/
+typedef struct blazer_pipeline_stage_stats
+{
+	int64_t bytes;				// processed bytes: read and compressed bytes of input, written bytes of output
+	int64_t busyNanoseconds;	// time of work (sum of all threads of stage, for io_uring - time of requests in flight)
+	int64_t stalls;				// count of waits for other stages
+	int64_t stallNanoseconds;	// time of these waits
+} blazer_pipeline_stage_stats;
+
+/*
+	Statistics of file pipeline. Read stage waits for free slot when queueDepth blocks are in flight,
+	compress stage waits for read data, write stage waits for compression of next block.
+*/
+typedef struct blazer_pipeline_stats
+{
+	blazer_pipeline_stage_stats read;
+	blazer_pipeline_stage_stats compress;
+	blazer_pipeline_stage_stats write;
+	int64_t elapsedNanoseconds;
+	int32_t ioRing;				// 1 if reads and writes are done through io_uring
+} blazer_pipeline_stats;
+
+/*
+	Modes of reads and writes of file pipeline
+*/
+#define BLAZER_PIPELINE_IO_AUTO 0		// io_uring if supported by system, otherwise dedicated reader and writer threads
+#define BLAZER_PIPELINE_IO_THREADS 1	// dedicated reader and writer threads
+
+/*
+	Compresses file to file of framed format by block algorithm (same data as blazer_file_compress with BLAZER_ALGORITHM_BLOCK).
+	Reads, compression of blocks by threadCount threads (0 - count of processors) and writes are overlapped,
+	at most queueDepth blocks are in flight (0 - twice of thread count plus two), each one takes about two block sizes of memory.
+	flags are flags of framed format (e.g. BLAZER_FLAGS_DEFAULT_BLOCK), stats can be NULL.
+	Returns size of output file or BLAZER_FILE_ERROR_* (BLAZER_FRAME_ERROR_MEMORY if buffers cannot be allocated).
+*/
+BLAZER_API int64_t blazer_file_compress_pipelined(const char* inPath, const char* outPath, uint32_t flags, int32_t threadCount, int32_t queueDepth, int32_t ioMode, blazer_pipeline_stats* stats);
+
+/*
+	Computes CRC-32C using Castagnoli polynomial of 0x82f63b78.
+	crc is initial CRC, typically 0, may be used to accumulate CRC from multiple buffers.
+	Uses hardware instructions if available and falls back to fast software implementation.
+*/
+BLAZER_API uint32_t crc32c_append(uint32_t crc, const uint8_t *input, size_t length);
+
+/*
+	Returns CRC-32C of concatenation of data A and B from CRC of A, CRC of B (calculated with initial CRC of 0)
+	and length of B, without access to data. Takes time proportional to logarithm of lengthB.
+	crc32c_append(crcA, B, lengthB) == crc32c_combine(crcA, crc32c_append(0, B, lengthB), lengthB).
+*/
+BLAZER_API uint32_t crc32c_combine(uint32_t crcA, uint32_t crcB, uint64_t lengthB);
+
+/*
+	Same as crc32c_append, but large input is split into chunks of 1MB, which are processed by threadCount threads
+	(0 - count of processors) and combined by crc32c_combine. Small input is processed by current thread only.
+*/
+BLAZER_API uint32_t crc32c_append_parallel(uint32_t crc, const uint8_t *input, size_t length, int32_t threadCount);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,10 +1,11 @@
 #include "stdafx.h"
-#include <windows.h>
+#include "Blazer.h"
+#include "WideCopy.h"
+#include "Match.h"
+#include "Block.h"
 
 // #define Mul 0x736AE249u
 #define Mul  1527631329
-#define HASH_TABLE_BITS 16
-
 #define HASH_TABLE_BITS 16
 #define HASH_TABLE_LEN ((1 << HASH_TABLE_BITS) - 1)
 
@@ -12,7 +13,7 @@
 
 #define MIN(a, b) ((a) <= (b) ? (a) : (b))
 
-static inline unsigned char* copy_memory(unsigned char* src, unsigned char* dst, __int32 count)
+static inline unsigned char* copy_memory(unsigned char* src, unsigned char* dst, int32_t count)
 {
 	/*while (count > 0 && ((int)src & 7) != 0)
 	{
@@ -20,9 +21,9 @@ static inline unsigned char* copy_memory(unsigned char* src, unsigned char* dst,
 		count--;
 	}*/
 
-	while (count >= sizeof(int))
+	while (count >= (int32_t)sizeof(int))
 	{
-		*(int*)dst = *(int*)src;
+		blazer_copy4(dst, src);
 		dst += sizeof(int);
 		src += sizeof(int);
 		count -= sizeof(int);
@@ -36,7 +37,7 @@ static inline unsigned char* copy_memory(unsigned char* src, unsigned char* dst,
 	return dst;
 }
 
-int __inline write_len(unsigned char* bufferOut, int c)
+static BLAZER_INLINE int write_len(unsigned char* bufferOut, int c)
 {
 	if (c < 253) 
 	{
@@ -53,30 +54,49 @@ int __inline write_len(unsigned char* bufferOut, int c)
 	{
 		*(bufferOut) = 254;
 		c -= 253 + 256;
-		*((unsigned __int16*)(bufferOut + 1)) = c;
+		*((uint16_t*)(bufferOut + 1)) = c;
 		return 3;
 	}
 // 	else
 	{
 		*(bufferOut) = 255;
 		c -= 253 + (256 * 256);
-		*((unsigned __int32*)(bufferOut + 1)) = c;
+		*((uint32_t*)(bufferOut + 1)) = c;
 		return 5;
 	}
 }
 
-extern "C" __declspec(dllexport) __int32 blazer_block_compress_block(unsigned char* bufferIn, __int32 bufferInOffset, __int32 bufferInLength, unsigned char* bufferOut, __int32 bufferOutOffset, __int32* hashArr)
+// far back references of offsets format: up to OFFSET_SHORT_MAX are written by 2 bytes with high bit cleared,
+// longer ones by 3 bytes (15 + 8 bits), all bits set is marker of last literals
+#define OFFSET_SHORT_MAX (256 + (1 << 15))
+#define OFFSET_LONG_MAX (OFFSET_SHORT_MAX + 0x7fffff)
+
+// far back reference: hash key of position for decoder with hash table or explicit offset for offsets format
+static BLAZER_INLINE unsigned char* write_far_ref(unsigned char* bufferOut, uint32_t hashKey, int32_t backRef, bool isOffsets)
 {
-	// int hashArr[HASH_TABLE_LEN + 1];
-	HANDLE hHeap = 0;
-	if (hashArr == 0) 
+	if (!isOffsets)
+	{
+		*((uint16_t*)bufferOut) = (uint16_t)hashKey;
+		return bufferOut + 2;
+	}
+
+	if (backRef <= OFFSET_SHORT_MAX)
 	{
-		HANDLE hHeap = GetProcessHeap();
-		hashArr = (__int32*)HeapAlloc(hHeap, HEAP_ZERO_MEMORY, sizeof(__int32) * (HASH_TABLE_LEN + 1));
+		*((uint16_t*)bufferOut) = (uint16_t)(backRef - 256 - 1);
+		return bufferOut + 2;
 	}
+
+	backRef -= OFFSET_SHORT_MAX + 1;
+	*((uint16_t*)bufferOut) = (uint16_t)(backRef | 0x8000);
+	bufferOut[2] = (unsigned char)(backRef >> 15);
+	return bufferOut + 3;
+}
+
+static BLAZER_INLINE int32_t block_compress(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, int32_t base, bool isOffsets, blazer_crc_track* inTrack, blazer_crc_track* outTrack)
+{
 	int idxIn = bufferInOffset;
 	int lastProcessedIdxIn = idxIn;
-	int idxOut = bufferOutOffset;
+	blazer_long_match_func longMatch = blazer_get_long_match();
 
 	int cntLit;
 
@@ -85,10 +105,10 @@ extern "C" __declspec(dllexport) __int32 blazer_block_compress_block(unsigned ch
 	unsigned char* bufferOutOrig = bufferOut;
 	bufferOut += bufferOutOffset;
 
-	unsigned __int32 mulEl = 0;
+	uint32_t mulEl = 0;
 
 	if (bufferInLength > 3)
-		mulEl = (unsigned __int32)(bufferIn[idxIn] << 16 | bufferIn[idxIn + 1] << 8 | bufferIn[idxIn + 2]);
+		mulEl = (uint32_t)(bufferIn[idxIn] << 16 | bufferIn[idxIn + 1] << 8 | bufferIn[idxIn + 2]);
 
 	while (idxIn < iterMax)
 	{
@@ -97,37 +117,36 @@ extern "C" __declspec(dllexport) __int32 blazer_block_compress_block(unsigned ch
 
 		mulEl = (mulEl << 8) | elemP0;
 		unsigned int hashKey = (mulEl  * Mul) >> (32 - HASH_TABLE_BITS);
-		int hashVal = hashArr[hashKey];
-		hashArr[hashKey] = idxInP3;
+		// positions of previous blocks are not greater than base, so they give non-positive value
+		int hashVal = hashArr[hashKey] - base;
+		hashArr[hashKey] = idxInP3 + base;
 
 		int backRef = idxInP3 - hashVal;
-		if (hashVal > 0 && hashKey != 0xffff && ((backRef < 257 || bufferIn[hashVal + 1] == bufferIn[idxIn + 4])
-				&& mulEl == (unsigned __int32)((bufferIn[hashVal - 3] << 24) | (bufferIn[hashVal - 2] << 16) | (bufferIn[hashVal - 1] << 8) | bufferIn[hashVal])))
+		// hash key 0xffff is marker of last literals, offsets format does not write keys but has limited length of offsets
+		if (hashVal > 0 && (isOffsets ? backRef <= OFFSET_LONG_MAX : hashKey != 0xffff) && ((backRef < 257 || bufferIn[hashVal + 1] == bufferIn[idxIn + 4])
+				&& mulEl == (uint32_t)((bufferIn[hashVal - 3] << 24) | (bufferIn[hashVal - 2] << 16) | (bufferIn[hashVal - 1] << 8) | bufferIn[hashVal])))
 		{
 			int origIdxIn = idxIn;
 			hashVal += 4 - 3;
 			idxIn += 4;
 
-			while (idxIn < bufferInLength)
+			int matchEnd = idxIn + blazer_match_length(bufferIn + hashVal, bufferIn + idxIn, bufferIn + bufferInLength, longMatch);
+			// decoder of hash keys adds every decoded byte to hash, so all positions of match (and first different byte) should be added here too
+			int hashEnd = matchEnd < bufferInLength ? matchEnd + 1 : bufferInLength;
+			for (; idxIn < hashEnd; idxIn++)
 			{
-				elemP0 = bufferIn[idxIn];
-				mulEl = (mulEl << 8) | elemP0;
-				hashArr[(mulEl * Mul) >> (32 - HASH_TABLE_BITS)] = idxIn;
-
-				if (bufferIn[hashVal++] == elemP0)
-				{
-					// hashVal++;
-					idxIn++;
-				}
-				else break;
+				mulEl = (mulEl << 8) | bufferIn[idxIn];
+				hashArr[(mulEl * Mul) >> (32 - HASH_TABLE_BITS)] = idxIn + base;
 			}
 
+			idxIn = matchEnd;
+
 			if (idxIn < iterMax)
 			{
 				mulEl = (mulEl << 8) | bufferIn[idxIn + 1];
-				hashArr[(mulEl * Mul) >> (32 - HASH_TABLE_BITS)] = idxIn + 1;
+				hashArr[(mulEl * Mul) >> (32 - HASH_TABLE_BITS)] = idxIn + 1 + base;
 				mulEl = (mulEl << 8) | bufferIn[idxIn + 2];
-				hashArr[(mulEl * Mul) >> (32 - HASH_TABLE_BITS)] = idxIn + 2;
+				hashArr[(mulEl * Mul) >> (32 - HASH_TABLE_BITS)] = idxIn + 2 + base;
 			}
 
 			cntLit = origIdxIn - lastProcessedIdxIn;
@@ -140,12 +159,12 @@ extern "C" __declspec(dllexport) __int32 blazer_block_compress_block(unsigned ch
 					if (seqLen < 15)
 					{
 						*(bufferOut++) = (unsigned char)((cntLit << 4) | seqLen | 128);
-						*((unsigned __int16*)bufferOut) = hashKey;bufferOut += 2;
+						bufferOut = write_far_ref(bufferOut, hashKey, backRef, isOffsets);
 					}
 					else
 					{
 						*(bufferOut++) = (unsigned char)((cntLit << 4) | 15 | 128);
-						*((unsigned __int16*)bufferOut) = hashKey;bufferOut += 2;
+						bufferOut = write_far_ref(bufferOut, hashKey, backRef, isOffsets);
 						bufferOut += write_len(bufferOut, seqLen - 15);
 					}
 				}
@@ -154,13 +173,13 @@ extern "C" __declspec(dllexport) __int32 blazer_block_compress_block(unsigned ch
 					if (seqLen < 15)
 					{
 						*(bufferOut++) = (unsigned char)((7 << 4) | seqLen | 128);
-						*((unsigned __int16*)bufferOut) = hashKey;bufferOut += 2;
+						bufferOut = write_far_ref(bufferOut, hashKey, backRef, isOffsets);
 						bufferOut += write_len(bufferOut, cntLit - 7);
 					}
 					else
 					{
 						*(bufferOut++) = (unsigned char)((7 << 4) | 15 | 128);
-						*((unsigned __int16*)bufferOut) = hashKey;bufferOut += 2;
+						bufferOut = write_far_ref(bufferOut, hashKey, backRef, isOffsets);
 						bufferOut += write_len(bufferOut, cntLit - 7);
 						bufferOut += write_len(bufferOut, seqLen - 15);
 					}
@@ -205,6 +224,10 @@ extern "C" __declspec(dllexport) __int32 blazer_block_compress_block(unsigned ch
 			bufferOut = copy_memory(bufferIn + origIdxIn - cntLit, bufferOut, cntLit);
 			
 			lastProcessedIdxIn = idxIn;
+			if (inTrack != 0)
+				blazer_crc_track_step(inTrack, bufferIn + lastProcessedIdxIn);
+			if (outTrack != 0)
+				blazer_crc_track_step(outTrack, bufferOut);
 			continue;
 		}
 
@@ -217,8 +240,10 @@ extern "C" __declspec(dllexport) __int32 blazer_block_compress_block(unsigned ch
 	if (cntLit > 0)
 	{
 		*(bufferOut++) = (unsigned char)(MIN(127, cntLit) + 128);
-		*((unsigned __int16*)bufferOut) = 0xffff;
+		*((uint16_t*)bufferOut) = 0xffff;
 		bufferOut += 2;
+		if (isOffsets)
+			*(bufferOut++) = 0xff;
 
 		if (cntLit >= 127)
 			bufferOut += write_len(bufferOut, cntLit - 127);
@@ -230,141 +255,499 @@ extern "C" __declspec(dllexport) __int32 blazer_block_compress_block(unsigned ch
 		}
 	}
 
-	if (hHeap != 0)
-		HeapFree(hHeap, 0, hashArr);
-	return (__int32)(bufferOut - bufferOutOrig);
+	return (int32_t)(bufferOut - bufferOutOrig);
+}
+
+int32_t blazer_block_compress_base(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, int32_t base)
+{
+	return block_compress(bufferIn, bufferInOffset, bufferInLength, bufferOut, bufferOutOffset, hashArr, base, false, 0, 0);
+}
+
+int32_t blazer_block_compress_offsets_base(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, int32_t base)
+{
+	return block_compress(bufferIn, bufferInOffset, bufferInLength, bufferOut, bufferOutOffset, hashArr, base, true, 0, 0);
+}
+
+int32_t blazer_block_compress_track(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, int32_t base, bool isOffsets, blazer_crc_track* inTrack, blazer_crc_track* outTrack)
+{
+	return isOffsets
+		? block_compress(bufferIn, bufferInOffset, bufferInLength, bufferOut, bufferOutOffset, hashArr, base, true, inTrack, outTrack)
+		: block_compress(bufferIn, bufferInOffset, bufferInLength, bufferOut, bufferOutOffset, hashArr, base, false, inTrack, outTrack);
+}
+
+extern "C" BLAZER_API int32_t blazer_block_compress_block(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr)
+{
+	if (hashArr != 0)
+		return blazer_block_compress_base(bufferIn, bufferInOffset, bufferInLength, bufferOut, bufferOutOffset, hashArr, 0);
+
+	int32_t* hashArrOwn = (int32_t*)blazer_alloc_zero(sizeof(int32_t) * (HASH_TABLE_LEN + 1));
+	int32_t res = blazer_block_compress_base(bufferIn, bufferInOffset, bufferInLength, bufferOut, bufferOutOffset, hashArrOwn, 0);
+	blazer_free(hashArrOwn);
+	return res;
+}
+
+// reads extended length of literals or sequence without bounds checks
+static BLAZER_INLINE int64_t read_len_fast(unsigned char** pBufferIn)
+{
+	unsigned char* bufferIn = *pBufferIn;
+	int64_t len = *(bufferIn++);
+	if (len == 253)
+	{
+		len += *(bufferIn++);
+	}
+	else if (len == 254)
+	{
+		len = 253 + 256 + *(uint16_t*)(bufferIn);
+		bufferIn += 2;
+	}
+	else if (len == 255)
+	{
+		len = 253 + (256 * 256) + (int64_t)*(uint32_t*)(bufferIn);
+		bufferIn += 4;
+	}
+
+	*pBufferIn = bufferIn;
+	return len;
+}
+
+// reads extended length of literals or sequence, returns -1 if in buffer is truncated
+static BLAZER_INLINE int64_t read_len_safe(unsigned char** pBufferIn, unsigned char* bufferInEnd)
+{
+	unsigned char* bufferIn = *pBufferIn;
+	if (bufferIn >= bufferInEnd)
+		return -1;
+	unsigned char lenR = *bufferIn;
+	int need = lenR < 253 ? 1 : (lenR == 253 ? 2 : (lenR == 254 ? 3 : 5));
+	if (bufferInEnd - bufferIn < need)
+		return -1;
+	return read_len_fast(pBufferIn);
 }
 
-extern "C" __declspec(dllexport) __int32 blazer_block_decompress_block(unsigned char* bufferIn, __int32 bufferInOffset, __int32 bufferInLength, unsigned char* bufferOut, __int32 bufferOutOffset, __int32 bufferOutLength, __int32* hashArr)
+// adds decoded bytes to hash, same way as encoder does
+static BLAZER_INLINE uint32_t hash_decoded(unsigned char* bufferOut, int32_t idxOut, int32_t idxEnd, uint32_t mulEl, int32_t* hashArr, int32_t base)
 {
-	HANDLE hHeap = 0;
-	// int hashArr[HASH_TABLE_LEN + 1];
-	if (hashArr == 0) 
+	while (idxOut < idxEnd)
 	{
-		hHeap = GetProcessHeap();
-		hashArr = (__int32*)HeapAlloc(hHeap, HEAP_ZERO_MEMORY, sizeof(__int32) * (HASH_TABLE_LEN + 1));
+		mulEl = (mulEl << 8) | bufferOut[idxOut];
+		hashArr[(mulEl * Mul) >> (32 - HASH_TABLE_BITS)] = idxOut + base;
+		idxOut++;
 	}
 
+	return mulEl;
+}
+
+int32_t blazer_block_decompress_track(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength, int32_t* hashArr, int32_t base, blazer_crc_track* inTrack, blazer_crc_track* outTrack)
+{
 	unsigned char* bufferInEnd = bufferIn + bufferInLength;
-	// __int32 idxIn = bufferInOffset;
 	bufferIn += bufferInOffset;
-	int idxOut = bufferOutOffset;
-	unsigned __int32 mulEl = 0;
-
-	while (bufferIn < bufferInEnd)
+	int32_t idxOut = bufferOutOffset;
+	uint32_t mulEl = 0;
+
+	// fast loop works while token header and wide copies cannot cross ends of buffers,
+	// token which does not fit is left for precise tail loop. Loop is skipped when any buffer has no room for margin,
+	// otherwise even empty token would copy wide chunk after end of out buffer
+	bool isFast = bufferInEnd - bufferIn > BLAZER_DECOMPRESS_MARGIN && bufferOutLength - idxOut > BLAZER_DECOMPRESS_MARGIN;
+	unsigned char* bufferInFast = isFast ? bufferInEnd - BLAZER_DECOMPRESS_MARGIN : bufferIn;
+	int32_t idxOutFast = isFast ? bufferOutLength - BLAZER_DECOMPRESS_MARGIN : idxOut;
+	blazer_long_copy_func longCopy = blazer_get_long_copy();
+	// crc of data is updated when out index reaches limit, without tracking it is never reached
+	int32_t crcLimit = inTrack != 0 || outTrack != 0 ? idxOut + BLAZER_CRC_TRACK_CHUNK : 0x7fffffff;
+
+	while (bufferIn < bufferInFast)
 	{
-		unsigned char elem = *(bufferIn++);
+		if (idxOut >= crcLimit)
+		{
+			if (inTrack != 0)
+				blazer_crc_track_step(inTrack, bufferIn);
+			if (outTrack != 0)
+				blazer_crc_track_step(outTrack, bufferOut + idxOut);
+			crcLimit = idxOut + BLAZER_CRC_TRACK_CHUNK;
+		}
 
-		int seqCntFirst = elem & 0xf;
-		int litCntFirst = (elem >> 4) & 7;
+		unsigned char* token = bufferIn;
+		unsigned char elem = *(bufferIn++);
 
-		int litCnt = litCntFirst;
-		int seqCnt;
-		int backRef;
-		int hashIdx = -1;
+		int64_t litCnt = (elem >> 4) & 7;
+		int64_t seqCnt = (elem & 0xf) + 4;
+		int32_t hashIdx = -1;
+		int32_t backRef = 0;
 
 		if (elem >= 128)
 		{
-			hashIdx = *(unsigned __int16*)(bufferIn);
-			seqCnt = seqCntFirst + /*5*/4;
+			hashIdx = *(uint16_t*)(bufferIn);
 			bufferIn += 2;
 			if (hashIdx == 0xffff)
 			{
-				seqCnt = 0;
-				seqCntFirst = 0;
+				// last literals
 				litCnt = elem - 128;
-				litCntFirst = litCnt == 127 ? 7 : 0;
+				seqCnt = 0;
+				if (litCnt == 127)
+					litCnt += read_len_fast(&bufferIn);
 			}
 		}
 		else
 		{
 			backRef = *(bufferIn++) + 1;
-			seqCnt = seqCntFirst + 4;
 		}
 
-		if (litCntFirst == 7)
+		if (litCnt == 7 && seqCnt > 0)
+			litCnt += read_len_fast(&bufferIn);
+		if (seqCnt == 15 + 4)
+			seqCnt += read_len_fast(&bufferIn);
+
+		if (litCnt > bufferInFast - bufferIn || litCnt + seqCnt > idxOutFast - idxOut)
 		{
-			unsigned char litCntR = *(bufferIn++);
-			
-			if (litCntR < 253) litCnt += litCntR;
-			else if (litCntR == 253)
-				litCnt += 253 + *(bufferIn++);
-			else if (litCntR == 254)
-			{
-				litCnt += 253 + 256 + *(unsigned __int16*)(bufferIn);
-				bufferIn += 2;
-			}
-			else
-			{
-				litCnt += 253 + (256 * 256) + *(unsigned __int32*)(bufferIn);
-				bufferIn += 4;
-			}
+			bufferIn = token;
+			break;
 		}
 
-		if (seqCntFirst == 15)
+		blazer_literal_copy(bufferOut + idxOut, bufferIn, (size_t)litCnt, longCopy);
+		bufferIn += litCnt;
+		mulEl = hash_decoded(bufferOut, idxOut, idxOut + (int32_t)litCnt, mulEl, hashArr, base);
+		idxOut += (int32_t)litCnt;
+
+		if (seqCnt == 0)
+			continue;
+
+		// position of previous block gives negative index
+		int32_t inRepIdx = hashIdx >= 0 ? hashArr[hashIdx] - base - 3 : idxOut - backRef;
+		if (inRepIdx < 0 || inRepIdx >= idxOut)
+			return -3;
+
+		blazer_match_copy(bufferOut + idxOut, (size_t)(idxOut - inRepIdx), (size_t)seqCnt, longCopy);
+		mulEl = hash_decoded(bufferOut, idxOut, idxOut + (int32_t)seqCnt, mulEl, hashArr, base);
+		idxOut += (int32_t)seqCnt;
+	}
+
+	// tail loop checks every read and copies data precisely near buffer ends
+	while (bufferIn < bufferInEnd)
+	{
+		unsigned char elem = *(bufferIn++);
+
+		int64_t litCnt = (elem >> 4) & 7;
+		int64_t seqCnt = (elem & 0xf) + 4;
+		int32_t hashIdx = -1;
+		int32_t backRef = 0;
+
+		if (elem >= 128)
 		{
-			unsigned char seqCntR = *(bufferIn++);
-			if (seqCntR < 253) seqCnt += seqCntR;
-			else if (seqCntR == 253)
-				seqCnt += 253 + *(bufferIn++);
-			else if (seqCntR == 254)
-			{
-				seqCnt += 253 + 256 + *(unsigned __int16*)(bufferIn);
-				bufferIn += 2;
-			}
-			else
+			if (bufferInEnd - bufferIn < 2)
+				return -2;
+			hashIdx = *(uint16_t*)(bufferIn);
+			bufferIn += 2;
+			if (hashIdx == 0xffff)
 			{
-				seqCnt += 253 + (256 * 256) + *(unsigned __int32*)(bufferIn);
-				bufferIn += 4;
+				litCnt = elem - 128;
+				seqCnt = 0;
+				if (litCnt == 127)
+				{
+					int64_t len = read_len_safe(&bufferIn, bufferInEnd);
+					if (len < 0)
+						return -2;
+					litCnt += len;
+				}
 			}
 		}
+		else
+		{
+			if (bufferIn >= bufferInEnd)
+				return -2;
+			backRef = *(bufferIn++) + 1;
+		}
+
+		if (litCnt == 7 && seqCnt > 0)
+		{
+			int64_t len = read_len_safe(&bufferIn, bufferInEnd);
+			if (len < 0)
+				return -2;
+			litCnt += len;
+		}
 
-		if (idxOut + litCnt + seqCnt > bufferOutLength)
+		if (seqCnt == 15 + 4)
+		{
+			int64_t len = read_len_safe(&bufferIn, bufferInEnd);
+			if (len < 0)
+				return -2;
+			seqCnt += len;
+		}
+
+		if (litCnt + seqCnt > bufferOutLength - idxOut)
 			return -1;
 
-		if (bufferIn + litCnt > bufferInEnd)
+		if (litCnt > bufferInEnd - bufferIn)
 			return -2;
 
-		copy_memory(bufferIn, bufferOut + idxOut, litCnt);
+		memcpy(bufferOut + idxOut, bufferIn, (size_t)litCnt);
+		bufferIn += litCnt;
+		mulEl = hash_decoded(bufferOut, idxOut, idxOut + (int32_t)litCnt, mulEl, hashArr, base);
+		idxOut += (int32_t)litCnt;
+
+		if (seqCnt == 0)
+			continue;
+
+		// position of previous block gives negative index
+		int32_t inRepIdx = hashIdx >= 0 ? hashArr[hashIdx] - base - 3 : idxOut - backRef;
+		if (inRepIdx < 0 || inRepIdx >= idxOut)
+			return -3;
 
-		while (--litCnt >= 0)
+		// matches do not read in buffer, so they can be copied by wide chunks till end of out buffer
+		if (bufferOutLength - idxOut - seqCnt >= BLAZER_DECOMPRESS_MARGIN)
+			blazer_match_copy(bufferOut + idxOut, (size_t)(idxOut - inRepIdx), (size_t)seqCnt, longCopy);
+		else
+		{
+			for (int32_t i = 0; i < seqCnt; i++)
+				bufferOut[idxOut + i] = bufferOut[inRepIdx + i];
+		}
+		mulEl = hash_decoded(bufferOut, idxOut, idxOut + (int32_t)seqCnt, mulEl, hashArr, base);
+		idxOut += (int32_t)seqCnt;
+	}
+
+	return idxOut;
+}
+
+int32_t blazer_block_decompress_base(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength, int32_t* hashArr, int32_t base)
+{
+	return blazer_block_decompress_track(bufferIn, bufferInOffset, bufferInLength, bufferOut, bufferOutOffset, bufferOutLength, hashArr, base, 0, 0);
+}
+
+extern "C" BLAZER_API int32_t blazer_block_decompress_block(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength, int32_t* hashArr)
+{
+	if (hashArr != 0)
+		return blazer_block_decompress_base(bufferIn, bufferInOffset, bufferInLength, bufferOut, bufferOutOffset, bufferOutLength, hashArr, 0);
+
+	int32_t* hashArrOwn = (int32_t*)blazer_alloc_zero(sizeof(int32_t) * (HASH_TABLE_LEN + 1));
+	int32_t res = blazer_block_decompress_base(bufferIn, bufferInOffset, bufferInLength, bufferOut, bufferOutOffset, bufferOutLength, hashArrOwn, 0);
+	blazer_free(hashArrOwn);
+	return res;
+}
+
+extern "C" BLAZER_API int32_t blazer_block_compress_offsets(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr)
+{
+	if (hashArr != 0)
+		return blazer_block_compress_offsets_base(bufferIn, bufferInOffset, bufferInLength, bufferOut, bufferOutOffset, hashArr, 0);
+
+	int32_t* hashArrOwn = (int32_t*)blazer_alloc_zero(sizeof(int32_t) * (HASH_TABLE_LEN + 1));
+	int32_t res = blazer_block_compress_offsets_base(bufferIn, bufferInOffset, bufferInLength, bufferOut, bufferOutOffset, hashArrOwn, 0);
+	blazer_free(hashArrOwn);
+	return res;
+}
+
+// returns far back reference of offsets format (OFFSET_LONG_MAX + 1 for marker of last literals) and moves pointer after it,
+// available is count of bytes in buffer, -1 is returned if reference does not fit
+static BLAZER_INLINE int32_t read_far_ref(unsigned char** pBufferIn, int64_t available)
+{
+	unsigned char* bufferIn = *pBufferIn;
+	if (available < 2)
+		return -1;
+	int32_t v = *(uint16_t*)bufferIn;
+	if (v < 0x8000)
+	{
+		*pBufferIn = bufferIn + 2;
+		return v + 256 + 1;
+	}
+
+	if (available < 3)
+		return -1;
+	*pBufferIn = bufferIn + 3;
+	return ((v & 0x7fff) | (bufferIn[2] << 15)) + OFFSET_SHORT_MAX + 1;
+}
+
+// same tokens as blazer_block_decompress_base, but far matches have explicit offsets,
+// so no hash is maintained and matches can reference only current block
+int32_t blazer_block_decompress_offsets_track(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength, blazer_crc_track* inTrack, blazer_crc_track* outTrack)
+{
+	unsigned char* bufferInEnd = bufferIn + bufferInLength;
+	bufferIn += bufferInOffset;
+	int32_t idxOut = bufferOutOffset;
+
+	// same as in blazer_block_decompress_track, fast loop is skipped without room for margin in any buffer
+	bool isFast = bufferInEnd - bufferIn > BLAZER_DECOMPRESS_MARGIN && bufferOutLength - idxOut > BLAZER_DECOMPRESS_MARGIN;
+	unsigned char* bufferInFast = isFast ? bufferInEnd - BLAZER_DECOMPRESS_MARGIN : bufferIn;
+	int32_t idxOutFast = isFast ? bufferOutLength - BLAZER_DECOMPRESS_MARGIN : idxOut;
+	blazer_long_copy_func longCopy = blazer_get_long_copy();
+	// crc of data is updated when out index reaches limit, without tracking it is never reached
+	int32_t crcLimit = inTrack != 0 || outTrack != 0 ? idxOut + BLAZER_CRC_TRACK_CHUNK : 0x7fffffff;
+
+	while (bufferIn < bufferInFast)
+	{
+		if (idxOut >= crcLimit)
 		{
-			unsigned char v = *(bufferIn++);
-			mulEl = (mulEl << 8) | v;
-			hashArr[(mulEl * Mul) >> (32 - HASH_TABLE_BITS)] = idxOut;
-			idxOut++;
-			// bufferOut[idxOut++] = v;
+			if (inTrack != 0)
+				blazer_crc_track_step(inTrack, bufferIn);
+			if (outTrack != 0)
+				blazer_crc_track_step(outTrack, bufferOut + idxOut);
+			crcLimit = idxOut + BLAZER_CRC_TRACK_CHUNK;
 		}
 
-		int inRepIdx = hashIdx >= 0 ? hashArr[hashIdx] - 3 : idxOut - backRef;
+		unsigned char* token = bufferIn;
+		unsigned char elem = *(bufferIn++);
 
-		if (inRepIdx < 0 && seqCnt > 0)
-			return inRepIdx;
+		int64_t litCnt = (elem >> 4) & 7;
+		int64_t seqCnt = (elem & 0xf) + 4;
+		int32_t backRef;
 
-		if (seqCnt >= sizeof(int) && inRepIdx + seqCnt < idxOut)
+		if (elem >= 128)
 		{
-			copy_memory(bufferOut + inRepIdx, bufferOut + idxOut, seqCnt);
-			while (--seqCnt >= 0)
+			// fast loop has margin for any reference
+			backRef = read_far_ref(&bufferIn, 3);
+			if (backRef > OFFSET_LONG_MAX)
 			{
-				unsigned char v = bufferOut[inRepIdx++];
-				mulEl = (mulEl << 8) | v;
-				hashArr[(mulEl * Mul) >> (32 - HASH_TABLE_BITS)] = idxOut;
-				idxOut++;
+				// last literals
+				litCnt = elem - 128;
+				seqCnt = 0;
+				if (litCnt == 127)
+					litCnt += read_len_fast(&bufferIn);
 			}
 		}
-		else 
+		else
+		{
+			backRef = *(bufferIn++) + 1;
+		}
+
+		if (litCnt == 7 && seqCnt > 0)
+			litCnt += read_len_fast(&bufferIn);
+		if (seqCnt == 15 + 4)
+			seqCnt += read_len_fast(&bufferIn);
+
+		if (litCnt > bufferInFast - bufferIn || litCnt + seqCnt > idxOutFast - idxOut)
 		{
-			while (--seqCnt >= 0)
+			bufferIn = token;
+			break;
+		}
+
+		blazer_literal_copy(bufferOut + idxOut, bufferIn, (size_t)litCnt, longCopy);
+		bufferIn += litCnt;
+		idxOut += (int32_t)litCnt;
+
+		if (seqCnt == 0)
+			continue;
+
+		if (backRef > idxOut - bufferOutOffset)
+			return -3;
+
+		blazer_match_copy(bufferOut + idxOut, (size_t)backRef, (size_t)seqCnt, longCopy);
+		idxOut += (int32_t)seqCnt;
+	}
+
+	while (bufferIn < bufferInEnd)
+	{
+		unsigned char elem = *(bufferIn++);
+
+		int64_t litCnt = (elem >> 4) & 7;
+		int64_t seqCnt = (elem & 0xf) + 4;
+		int32_t backRef;
+
+		if (elem >= 128)
+		{
+			backRef = read_far_ref(&bufferIn, bufferInEnd - bufferIn);
+			if (backRef < 0)
+				return -2;
+			if (backRef > OFFSET_LONG_MAX)
 			{
-				unsigned char v = bufferOut[inRepIdx++];
-				mulEl = (mulEl << 8) | v;
-				hashArr[(mulEl * Mul) >> (32 - HASH_TABLE_BITS)] = idxOut;
-				bufferOut[idxOut++] = v;
+				litCnt = elem - 128;
+				seqCnt = 0;
+				if (litCnt == 127)
+				{
+					int64_t len = read_len_safe(&bufferIn, bufferInEnd);
+					if (len < 0)
+						return -2;
+					litCnt += len;
+				}
 			}
 		}
+		else
+		{
+			if (bufferIn >= bufferInEnd)
+				return -2;
+			backRef = *(bufferIn++) + 1;
+		}
+
+		if (litCnt == 7 && seqCnt > 0)
+		{
+			int64_t len = read_len_safe(&bufferIn, bufferInEnd);
+			if (len < 0)
+				return -2;
+			litCnt += len;
+		}
+
+		if (seqCnt == 15 + 4)
+		{
+			int64_t len = read_len_safe(&bufferIn, bufferInEnd);
+			if (len < 0)
+				return -2;
+			seqCnt += len;
+		}
+
+		if (litCnt + seqCnt > bufferOutLength - idxOut)
+			return -1;
+
+		if (litCnt > bufferInEnd - bufferIn)
+			return -2;
+
+		memcpy(bufferOut + idxOut, bufferIn, (size_t)litCnt);
+		bufferIn += litCnt;
+		idxOut += (int32_t)litCnt;
+
+		if (seqCnt == 0)
+			continue;
+
+		if (backRef > idxOut - bufferOutOffset)
+			return -3;
+
+		if (bufferOutLength - idxOut - seqCnt >= BLAZER_DECOMPRESS_MARGIN)
+			blazer_match_copy(bufferOut + idxOut, (size_t)backRef, (size_t)seqCnt, longCopy);
+		else
+		{
+			for (int32_t i = 0; i < seqCnt; i++)
+				bufferOut[idxOut + i] = bufferOut[idxOut - backRef + i];
+		}
+		idxOut += (int32_t)seqCnt;
 	}
 
-	if (hHeap != 0)
-		HeapFree(hHeap, 0, hashArr);
 	return idxOut;
 }
+
+extern "C" BLAZER_API int32_t blazer_block_decompress_offsets(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength)
+{
+	return blazer_block_decompress_offsets_track(bufferIn, bufferInOffset, bufferInLength, bufferOut, bufferOutOffset, bufferOutLength, 0, 0);
+}
+
+extern "C" BLAZER_API int32_t blazer_block_compress_block_crc(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, uint32_t* inCrc, uint32_t* outCrc)
+{
+	int32_t* hashArrOwn = hashArr != 0 ? 0 : (int32_t*)blazer_alloc_zero(sizeof(int32_t) * (HASH_TABLE_LEN + 1));
+	if (hashArr == 0 && hashArrOwn == 0)
+		return -1;
+	blazer_crc_track inTrack, outTrack;
+	blazer_crc_track_init(&inTrack, bufferIn + bufferInOffset);
+	blazer_crc_track_init(&outTrack, bufferOut + bufferOutOffset);
+	int32_t res = blazer_block_compress_track(bufferIn, bufferInOffset, bufferInLength, bufferOut, bufferOutOffset, hashArr != 0 ? hashArr : hashArrOwn, 0, false,
+		inCrc != 0 ? &inTrack : 0, outCrc != 0 ? &outTrack : 0);
+	if (hashArrOwn != 0)
+		blazer_free(hashArrOwn);
+	if (inCrc != 0)
+		*inCrc = blazer_crc_track_finish(&inTrack, bufferIn + bufferInLength);
+	if (outCrc != 0)
+		*outCrc = blazer_crc_track_finish(&outTrack, bufferOut + res);
+	return res;
+}
+
+extern "C" BLAZER_API int32_t blazer_block_decompress_block_crc(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength, int32_t* hashArr, uint32_t* inCrc, uint32_t* outCrc)
+{
+	int32_t* hashArrOwn = hashArr != 0 ? 0 : (int32_t*)blazer_alloc_zero(sizeof(int32_t) * (HASH_TABLE_LEN + 1));
+	if (hashArr == 0 && hashArrOwn == 0)
+		return -1;
+	blazer_crc_track inTrack, outTrack;
+	blazer_crc_track_init(&inTrack, bufferIn + bufferInOffset);
+	blazer_crc_track_init(&outTrack, bufferOut + bufferOutOffset);
+	int32_t res = blazer_block_decompress_track(bufferIn, bufferInOffset, bufferInLength, bufferOut, bufferOutOffset, bufferOutLength, hashArr != 0 ? hashArr : hashArrOwn, 0,
+		inCrc != 0 ? &inTrack : 0, outCrc != 0 ? &outTrack : 0);
+	if (hashArrOwn != 0)
+		blazer_free(hashArrOwn);
+	if (res < 0)
+		return res;
+	if (inCrc != 0)
+		*inCrc = blazer_crc_track_finish(&inTrack, bufferIn + bufferInLength);
+	if (outCrc != 0)
+		*outCrc = blazer_crc_track_finish(&outTrack, bufferOut + res);
+	return res;
+}
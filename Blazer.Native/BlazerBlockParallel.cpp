@@ -0,0 +1,184 @@
+#include "stdafx.h"
+#include "Blazer.h"
+#include "Threading.h"
+#include "Block.h"
+
+// every block is compressed into own slot of out buffer, slot should have enough size for incompressible data:
+// token with escaped length of literals can take several bytes, which is not covered by (blockSize >> 8) for small blocks
+#define BLOCK_SLOT_SIZE(blockSize) ((int64_t)(blockSize) + ((blockSize) >> 8) + 16)
+
+struct block_compress_job
+{
+	unsigned char* bufferIn;
+	int64_t bufferInLength;
+	int32_t blockSize;
+	int32_t blockCount;
+	unsigned char* bufferOut;
+	int32_t* blockSizes;
+	volatile int32_t nextBlock;
+	volatile int32_t failed;
+};
+
+// blocks have same size, so shared counter balances threads well enough and there is no need in per-thread queues
+static void block_compress_worker(void* arg)
+{
+	block_compress_job* job = (block_compress_job*)arg;
+	blazer_block_hash hash;
+	hash.arr = (int32_t*)blazer_alloc_zero(sizeof(int32_t) * BLAZER_BLOCK_HASH_SIZE);
+	hash.base = 0;
+	if (hash.arr == 0)
+	{
+		job->failed = 1;
+		return;
+	}
+
+	int32_t blockIdx;
+	while ((blockIdx = blazer_atomic_increment(&job->nextBlock) - 1) < job->blockCount)
+	{
+		int64_t pos = (int64_t)blockIdx * job->blockSize;
+		int64_t rest = job->bufferInLength - pos;
+		int32_t cnt = rest < job->blockSize ? (int32_t)rest : job->blockSize;
+		unsigned char* slot = job->bufferOut + blockIdx * BLOCK_SLOT_SIZE(job->blockSize);
+		job->blockSizes[blockIdx] = blazer_block_compress_base(job->bufferIn + pos, 0, cnt, slot, 0, hash.arr, blazer_block_hash_acquire(&hash, cnt));
+	}
+
+	blazer_free(hash.arr);
+}
+
+extern "C" BLAZER_API int64_t blazer_block_compress_bound(int64_t bufferInLength, int32_t blockSize)
+{
+	if (bufferInLength <= 0 || blockSize <= 0)
+		return 0;
+	int64_t blockCount = (bufferInLength + blockSize - 1) / blockSize;
+	return blockCount * BLOCK_SLOT_SIZE(blockSize);
+}
+
+extern "C" BLAZER_API int64_t blazer_block_compress_parallel(unsigned char* bufferIn, int64_t bufferInLength, int32_t blockSize, unsigned char* bufferOut, int32_t* blockSizes, int32_t threadCount)
+{
+	if (bufferInLength < 0 || blockSize <= 0 || blockSize > (16 << 20))
+		return -1;
+	if (bufferInLength == 0)
+		return 0;
+	if ((bufferInLength + blockSize - 1) / blockSize > 0x7fffffff)
+		return -1;
+
+	block_compress_job job;
+	job.bufferIn = bufferIn;
+	job.bufferInLength = bufferInLength;
+	job.blockSize = blockSize;
+	job.blockCount = (int32_t)((bufferInLength + blockSize - 1) / blockSize);
+	job.bufferOut = bufferOut;
+	job.blockSizes = blockSizes;
+	job.nextBlock = 0;
+	job.failed = 0;
+
+	blazer_run_parallel(block_compress_worker, &job, threadCount, job.blockCount);
+
+	if (job.failed && job.nextBlock <= job.blockCount)
+		return -1;
+
+	// moving compressed blocks together. Block is never moved forward, so it cannot overwrite next slots
+	int64_t outPos = 0;
+	for (int32_t i = 0; i < job.blockCount; i++)
+	{
+		unsigned char* slot = bufferOut + i * BLOCK_SLOT_SIZE(blockSize);
+		if (bufferOut + outPos != slot)
+			blazer_move_down(bufferOut + outPos, slot, blockSizes[i]);
+		outPos += blockSizes[i];
+	}
+
+	return outPos;
+}
+
+struct block_decompress_job
+{
+	unsigned char* bufferIn;
+	int64_t bufferInLength;
+	unsigned char* bufferOut;
+	int64_t bufferOutLength;
+	blazer_block_frame* frames;
+	int32_t frameCount;
+	int32_t checkCrc;
+	volatile int32_t nextFrame;
+	volatile int32_t failed;
+};
+
+static int32_t block_decompress_frame(block_decompress_job* job, blazer_block_frame* frame, blazer_block_hash* hash)
+{
+	if (frame->inOffset < 0 || frame->inLength < 0 || frame->outOffset < 0 || frame->outLength < 0
+		|| frame->inOffset + frame->inLength > job->bufferInLength || frame->outOffset + frame->outLength > job->bufferOutLength)
+		return -5;
+
+	unsigned char* in = job->bufferIn + frame->inOffset;
+	if (job->checkCrc && crc32c_append(0, in, frame->inLength) != frame->crc)
+		return -4;
+
+	if (!frame->isCompressed)
+	{
+		if (frame->inLength > frame->outLength)
+			return -1;
+		memcpy(job->bufferOut + frame->outOffset, in, frame->inLength);
+		return frame->inLength;
+	}
+
+	return blazer_block_decompress_base(in, 0, frame->inLength, job->bufferOut + frame->outOffset, 0, frame->outLength, hash->arr, blazer_block_hash_acquire(hash, frame->outLength));
+}
+
+static void block_decompress_worker(void* arg)
+{
+	block_decompress_job* job = (block_decompress_job*)arg;
+	blazer_block_hash hash;
+	hash.arr = (int32_t*)blazer_alloc_zero(sizeof(int32_t) * BLAZER_BLOCK_HASH_SIZE);
+	hash.base = 0;
+	if (hash.arr == 0)
+	{
+		blazer_atomic_store(&job->failed, 1);
+		return;
+	}
+
+	int32_t frameIdx;
+	while (!blazer_atomic_load(&job->failed) && (frameIdx = blazer_atomic_increment(&job->nextFrame) - 1) < job->frameCount)
+	{
+		blazer_block_frame* frame = &job->frames[frameIdx];
+		// frame is owned by this thread now, so result can be written directly to it
+		frame->outLength = block_decompress_frame(job, frame, &hash);
+		if (frame->outLength < 0)
+			blazer_atomic_store(&job->failed, 1);
+	}
+
+	blazer_free(hash.arr);
+}
+
+extern "C" BLAZER_API int64_t blazer_block_decompress_parallel(unsigned char* bufferIn, int64_t bufferInLength, unsigned char* bufferOut, int64_t bufferOutLength, blazer_block_frame* frames, int32_t frameCount, int32_t checkCrc, int32_t threadCount)
+{
+	if (frameCount <= 0)
+		return 0;
+
+	block_decompress_job job;
+	job.bufferIn = bufferIn;
+	job.bufferInLength = bufferInLength;
+	job.bufferOut = bufferOut;
+	job.bufferOutLength = bufferOutLength;
+	job.frames = frames;
+	job.frameCount = frameCount;
+	job.checkCrc = checkCrc;
+	job.nextFrame = 0;
+	job.failed = 0;
+
+	blazer_run_parallel(block_decompress_worker, &job, threadCount, frameCount);
+
+	if (job.failed && job.nextFrame == 0)
+		return -1;
+
+	int64_t total = 0;
+	for (int32_t i = 0; i < frameCount; i++)
+	{
+		if (i >= job.nextFrame)
+			return -1;
+		if (frames[i].outLength < 0)
+			return frames[i].outLength;
+		total += frames[i].outLength;
+	}
+
+	return total;
+}
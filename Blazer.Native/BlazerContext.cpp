@@ -0,0 +1,76 @@
+#include "stdafx.h"
+#include "Blazer.h"
+#include "Block.h"
+
+// tables are aligned by cache line
+#define CTX_ALIGN 64
+#define ALIGN_UP(v) (((v) + CTX_ALIGN - 1) & ~(size_t)(CTX_ALIGN - 1))
+
+struct blazer_ctx
+{
+	blazer_block_hash blockHash;
+	// memory which was allocated by blazer_ctx_create, null for memory of caller
+	void* allocated;
+};
+
+extern "C" BLAZER_API size_t blazer_ctx_size(void)
+{
+	return CTX_ALIGN - 1 + ALIGN_UP(sizeof(blazer_ctx)) + sizeof(int32_t) * BLAZER_BLOCK_HASH_SIZE;
+}
+
+extern "C" BLAZER_API blazer_ctx* blazer_ctx_create(void* memory, size_t memorySize)
+{
+	size_t size = blazer_ctx_size();
+	void* allocated = 0;
+	if (memory == 0)
+	{
+		// allocated memory is already zeroed
+		allocated = blazer_alloc_zero(size);
+		if (allocated == 0)
+			return 0;
+		memory = allocated;
+	}
+	else if (memorySize < size)
+	{
+		return 0;
+	}
+
+	blazer_ctx* ctx = (blazer_ctx*)ALIGN_UP((size_t)memory);
+	ctx->blockHash.arr = (int32_t*)((unsigned char*)ctx + ALIGN_UP(sizeof(blazer_ctx)));
+	ctx->blockHash.base = 0;
+	ctx->allocated = allocated;
+	// table is cleared only once, next calls move base of positions
+	if (allocated == 0)
+		memset(ctx->blockHash.arr, 0, sizeof(int32_t) * BLAZER_BLOCK_HASH_SIZE);
+	return ctx;
+}
+
+extern "C" BLAZER_API void blazer_ctx_reset(blazer_ctx* ctx)
+{
+	// every call already starts after positions of previous one, so it is enough to move base
+	blazer_block_hash_acquire(&ctx->blockHash, 0);
+}
+
+extern "C" BLAZER_API void blazer_ctx_destroy(blazer_ctx* ctx)
+{
+	if (ctx != 0 && ctx->allocated != 0)
+		blazer_free(ctx->allocated);
+}
+
+extern "C" BLAZER_API int32_t blazer_ctx_block_compress(blazer_ctx* ctx, unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset)
+{
+	int32_t base = blazer_block_hash_acquire(&ctx->blockHash, bufferInLength);
+	return blazer_block_compress_base(bufferIn, bufferInOffset, bufferInLength, bufferOut, bufferOutOffset, ctx->blockHash.arr, base);
+}
+
+extern "C" BLAZER_API int32_t blazer_ctx_block_compress_offsets(blazer_ctx* ctx, unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset)
+{
+	int32_t base = blazer_block_hash_acquire(&ctx->blockHash, bufferInLength);
+	return blazer_block_compress_offsets_base(bufferIn, bufferInOffset, bufferInLength, bufferOut, bufferOutOffset, ctx->blockHash.arr, base);
+}
+
+extern "C" BLAZER_API int32_t blazer_ctx_block_decompress(blazer_ctx* ctx, unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength)
+{
+	int32_t base = blazer_block_hash_acquire(&ctx->blockHash, bufferOutLength);
+	return blazer_block_decompress_base(bufferIn, bufferInOffset, bufferInLength, bufferOut, bufferOutOffset, bufferOutLength, ctx->blockHash.arr, base);
+}
@@ -0,0 +1,363 @@
+#include "stdafx.h"
+#include "Blazer.h"
+#include "Stream.h"
+
+// messages with dictionary: id of dictionary (4 bytes) and data of stream algorithm with dictionary as history.
+// Data after id is same as data of patterned compressor of Blazer.Net (StreamPatternedCompressor)
+
+#define MAX_MESSAGE_SIZE (16 << 20)
+// encoder reads some bytes after data and decoder copies by wide chunks, so window has spare bytes for both
+#define WINDOW_SPARE BLAZER_DECOMPRESS_MARGIN
+#define COMPRESS_BOUND(len) ((len) + ((len) >> 8) + 16)
+
+#define CTX_ALIGN 64
+#define ALIGN_UP(v) (((v) + CTX_ALIGN - 1) & ~(size_t)(CTX_ALIGN - 1))
+
+// parameters of trainer: length of hashed sequences, length of selected segments and bits of table of frequencies
+#define TRAIN_SEQ_LEN 6
+#define TRAIN_SEGMENT_LEN 64
+#define TRAIN_HASH_BITS 20
+#define TRAIN_NO_SEQ 0xffffffff
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+static BLAZER_INLINE void write_le32(unsigned char* p, uint32_t v)
+{
+	p[0] = (unsigned char)v;
+	p[1] = (unsigned char)(v >> 8);
+	p[2] = (unsigned char)(v >> 16);
+	p[3] = (unsigned char)(v >> 24);
+}
+
+static BLAZER_INLINE uint32_t read_le32(const unsigned char* p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+struct blazer_dict
+{
+	uint32_t id;
+	int32_t level;
+	// last bytes of dictionary, which can be referenced by data
+	unsigned char* data;
+	int32_t length;
+	// hash table after compression of dictionary
+	int32_t* hashArr;
+	int32_t hashSize;
+};
+
+struct blazer_dict_ctx
+{
+	const blazer_dict* dict;
+	// copy of dictionary and then data of message
+	unsigned char* window;
+	int32_t maxMessageSize;
+	int32_t* hashArr;
+	// memory which was allocated by blazer_dict_ctx_create, null for memory of caller
+	void* allocated;
+};
+
+extern "C" BLAZER_API blazer_dict* blazer_dict_create(const unsigned char* data, int32_t length, uint32_t id, int32_t level)
+{
+	if (level == 0)
+		level = BLAZER_STREAM_LEVEL_DEFAULT;
+	int32_t hashSize = blazer_stream_hash_size(level);
+	if (length < 0 || hashSize == 0)
+		return 0;
+
+	// only last bytes of long dictionary can be reached by back references
+	int32_t dictLength = MIN(length, BLAZER_DICT_MAX_SIZE);
+	data += length - dictLength;
+
+	size_t hashOffset = ALIGN_UP(sizeof(blazer_dict));
+	size_t dataOffset = hashOffset + ALIGN_UP(sizeof(int32_t) * (size_t)hashSize);
+	size_t scratchOffset = dataOffset + ALIGN_UP((size_t)dictLength + WINDOW_SPARE);
+	// compressed dictionary is not needed, space for it is used only while table is primed
+	blazer_dict* dict = (blazer_dict*)blazer_alloc_zero(scratchOffset + COMPRESS_BOUND((size_t)dictLength));
+	if (dict == 0)
+		return 0;
+
+	dict->level = level;
+	dict->hashArr = (int32_t*)((unsigned char*)dict + hashOffset);
+	dict->hashSize = hashSize;
+	dict->data = (unsigned char*)dict + dataOffset;
+	dict->length = dictLength;
+	if (dictLength > 0)
+		memcpy(dict->data, data, dictLength);
+	dict->id = id != 0 ? id : crc32c_append(0, dict->data, (size_t)dictLength);
+
+	// same as PreparePattern of Blazer.Net: dictionary is compressed as first block of stream
+	blazer_stream_compress_block_level(dict->data, 0, dictLength, 0, (unsigned char*)dict + scratchOffset, 0, dict->hashArr, level);
+	return dict;
+}
+
+extern "C" BLAZER_API uint32_t blazer_dict_get_id(const blazer_dict* dict)
+{
+	return dict->id;
+}
+
+extern "C" BLAZER_API void blazer_dict_destroy(blazer_dict* dict)
+{
+	if (dict != 0)
+		blazer_free(dict);
+}
+
+static size_t ctx_layout(const blazer_dict* dict, int32_t maxMessageSize, size_t* windowOffset)
+{
+	*windowOffset = ALIGN_UP(sizeof(blazer_dict_ctx)) + ALIGN_UP(sizeof(int32_t) * (size_t)dict->hashSize);
+	return CTX_ALIGN - 1 + *windowOffset + (size_t)dict->length + (size_t)maxMessageSize + WINDOW_SPARE;
+}
+
+extern "C" BLAZER_API size_t blazer_dict_ctx_size(const blazer_dict* dict, int32_t maxMessageSize)
+{
+	if (maxMessageSize <= 0 || maxMessageSize > MAX_MESSAGE_SIZE)
+		return 0;
+	size_t windowOffset;
+	return ctx_layout(dict, maxMessageSize, &windowOffset);
+}
+
+extern "C" BLAZER_API blazer_dict_ctx* blazer_dict_ctx_create(void* memory, size_t memorySize, const blazer_dict* dict, int32_t maxMessageSize)
+{
+	size_t size = blazer_dict_ctx_size(dict, maxMessageSize);
+	if (size == 0)
+		return 0;
+
+	void* allocated = 0;
+	if (memory == 0)
+	{
+		allocated = blazer_alloc_zero(size);
+		if (allocated == 0)
+			return 0;
+		memory = allocated;
+	}
+	else if (memorySize < size)
+	{
+		return 0;
+	}
+
+	blazer_dict_ctx* ctx = (blazer_dict_ctx*)ALIGN_UP((size_t)memory);
+	size_t windowOffset;
+	ctx_layout(dict, maxMessageSize, &windowOffset);
+	ctx->dict = dict;
+	ctx->hashArr = (int32_t*)((unsigned char*)ctx + ALIGN_UP(sizeof(blazer_dict_ctx)));
+	ctx->window = (unsigned char*)ctx + windowOffset;
+	ctx->maxMessageSize = maxMessageSize;
+	ctx->allocated = allocated;
+	// table is copied once, every message returns it to this state
+	memcpy(ctx->hashArr, dict->hashArr, sizeof(int32_t) * (size_t)dict->hashSize);
+	if (dict->length > 0)
+		memcpy(ctx->window, dict->data, dict->length);
+	return ctx;
+}
+
+extern "C" BLAZER_API void blazer_dict_ctx_destroy(blazer_dict_ctx* ctx)
+{
+	if (ctx != 0 && ctx->allocated != 0)
+		blazer_free(ctx->allocated);
+}
+
+extern "C" BLAZER_API int32_t blazer_dict_compress_bound(int32_t length)
+{
+	return BLAZER_DICT_HEADER_SIZE + COMPRESS_BOUND(length);
+}
+
+extern "C" BLAZER_API int32_t blazer_dict_compress(blazer_dict_ctx* ctx, const unsigned char* in, int32_t length, unsigned char* out, int32_t outLength)
+{
+	if (length < 0 || length > ctx->maxMessageSize || outLength < blazer_dict_compress_bound(length))
+		return -1;
+
+	const blazer_dict* dict = ctx->dict;
+	if (length > 0)
+		memcpy(ctx->window + dict->length, in, length);
+	int32_t comprLength = blazer_stream_compress_block_level(ctx->window, dict->length, dict->length + length, 0, out, BLAZER_DICT_HEADER_SIZE, ctx->hashArr, dict->level) - BLAZER_DICT_HEADER_SIZE;
+	// positions of message are removed from table, so every message is compressed with dictionary only
+	blazer_stream_restore_hash(ctx->window, dict->length, dict->length + length, 0, ctx->hashArr, dict->hashArr, dict->level);
+
+	// count of bits of length in 64KB units, as in Blazer.Net (it uses it for size of buffer of decoder)
+	int32_t lenCnt = 0;
+	for (int32_t units = comprLength >> 16; units > 0; units >>= 1)
+		lenCnt++;
+	write_le32(out, dict->id);
+	out[4] = (unsigned char)(lenCnt | (BLAZER_ALGORITHM_STREAM << 4));
+	return BLAZER_DICT_HEADER_SIZE + comprLength;
+}
+
+extern "C" BLAZER_API uint32_t blazer_dict_message_id(const unsigned char* in, int32_t length)
+{
+	return length >= BLAZER_DICT_HEADER_SIZE ? read_le32(in) : 0;
+}
+
+extern "C" BLAZER_API int32_t blazer_dict_decompress(blazer_dict_ctx* ctx, const unsigned char* in, int32_t length, unsigned char* out, int32_t outLength)
+{
+	const blazer_dict* dict = ctx->dict;
+	if (length < BLAZER_DICT_HEADER_SIZE || (in[4] >> 4) != BLAZER_ALGORITHM_STREAM)
+		return -4;
+	if (read_le32(in) != dict->id)
+		return -5;
+
+	int32_t maxLength = outLength < ctx->maxMessageSize ? outLength : ctx->maxMessageSize;
+	if (maxLength < 0)
+		return -1;
+	int32_t res = blazer_stream_decompress_block((unsigned char*)in, BLAZER_DICT_HEADER_SIZE, length, ctx->window, dict->length, dict->length + maxLength);
+	if (res < 0)
+		return res;
+
+	int32_t cnt = res - dict->length;
+	if (cnt > 0)
+		memcpy(out, ctx->window + dict->length, cnt);
+	return cnt;
+}
+
+// hash of TRAIN_SEQ_LEN bytes from p
+static BLAZER_INLINE uint32_t train_hash(const unsigned char* p)
+{
+	uint64_t v = 0;
+	for (int32_t i = 0; i < TRAIN_SEQ_LEN; i++)
+		v = (v << 8) | p[i];
+	return (uint32_t)((v * 0x9E3779B97F4A7C15ULL) >> (64 - TRAIN_HASH_BITS));
+}
+
+struct train_state
+{
+	// hash of sequence at every position of samples, TRAIN_NO_SEQ if sequence crosses end of sample
+	uint32_t* seqs;
+	// count of every sequence in all samples, selected sequences are cleared
+	uint32_t* freqs;
+	// count of sequences in current segment, so every sequence is counted once in score of segment
+	uint16_t* active;
+};
+
+// adds sequence at position to current segment, returns change of score
+static BLAZER_INLINE int64_t train_add(train_state* s, int64_t pos)
+{
+	uint32_t seq = s->seqs[pos];
+	if (seq == TRAIN_NO_SEQ)
+		return 0;
+	return s->active[seq]++ == 0 ? s->freqs[seq] : 0;
+}
+
+static BLAZER_INLINE int64_t train_remove(train_state* s, int64_t pos)
+{
+	uint32_t seq = s->seqs[pos];
+	if (seq == TRAIN_NO_SEQ)
+		return 0;
+	return --s->active[seq] == 0 ? s->freqs[seq] : 0;
+}
+
+// returns start of segment in [from, to) with largest score (sum of frequencies of its distinct sequences) or -1 if all are 0
+static int64_t train_select(train_state* s, int64_t from, int64_t to)
+{
+	int32_t seqCount = TRAIN_SEGMENT_LEN - TRAIN_SEQ_LEN + 1;
+	int64_t score = 0;
+	int64_t bestScore = 0;
+	int64_t best = -1;
+	int64_t pos = from;
+	for (; pos + TRAIN_SEGMENT_LEN <= to; pos++)
+	{
+		if (pos == from)
+		{
+			for (int32_t i = 0; i < seqCount; i++)
+				score += train_add(s, pos + i);
+		}
+		else
+		{
+			score -= train_remove(s, pos - 1);
+			score += train_add(s, pos + seqCount - 1);
+		}
+
+		if (score > bestScore)
+		{
+			bestScore = score;
+			best = pos;
+		}
+	}
+
+	// sequences of last segment are removed, so active counts are zero for next call
+	if (pos > from)
+	{
+		for (int32_t i = 0; i < seqCount; i++)
+			train_remove(s, pos - 1 + i);
+	}
+
+	return best;
+}
+
+extern "C" BLAZER_API int32_t blazer_dict_train(const unsigned char* samples, const int32_t* sampleLengths, int32_t sampleCount, unsigned char* dict, int32_t dictCapacity)
+{
+	if (sampleCount < 0 || dictCapacity < 0)
+		return -1;
+	int64_t total = 0;
+	for (int32_t i = 0; i < sampleCount; i++)
+	{
+		if (sampleLengths[i] < 0)
+			return -1;
+		total += sampleLengths[i];
+	}
+
+	// samples, which fit into dictionary, are used as is
+	if (total <= dictCapacity)
+	{
+		if (total > 0)
+			memcpy(dict, samples, (size_t)total);
+		return (int32_t)total;
+	}
+
+	train_state s;
+	s.seqs = (uint32_t*)blazer_alloc_zero(sizeof(uint32_t) * (size_t)total);
+	s.freqs = (uint32_t*)blazer_alloc_zero(sizeof(uint32_t) << TRAIN_HASH_BITS);
+	s.active = (uint16_t*)blazer_alloc_zero(sizeof(uint16_t) << TRAIN_HASH_BITS);
+	int32_t res = -1;
+	if (s.seqs != 0 && s.freqs != 0 && s.active != 0)
+	{
+		int64_t pos = 0;
+		for (int32_t i = 0; i < sampleCount; i++)
+		{
+			for (int32_t j = 0; j < sampleLengths[i]; j++, pos++)
+			{
+				if (j + TRAIN_SEQ_LEN > sampleLengths[i])
+				{
+					s.seqs[pos] = TRAIN_NO_SEQ;
+					continue;
+				}
+
+				s.seqs[pos] = train_hash(samples + pos);
+				s.freqs[s.seqs[pos]]++;
+			}
+		}
+
+		// samples are split into epochs and best segment of every epoch is selected (as in COVER algorithm of zstd).
+		// Segments are placed from end of dictionary, so most frequent data gets shortest back references
+		int64_t epochCount = MIN((int64_t)dictCapacity / TRAIN_SEGMENT_LEN, total / TRAIN_SEGMENT_LEN);
+		int64_t epochLength = epochCount > 0 ? total / epochCount : total;
+		int32_t tail = dictCapacity;
+		for (int64_t epoch = 0; epoch < epochCount && tail >= TRAIN_SEGMENT_LEN; epoch++)
+		{
+			int64_t from = epoch * epochLength;
+			int64_t best = train_select(&s, from, epoch == epochCount - 1 ? total : from + epochLength);
+			if (best < 0)
+				continue;
+
+			// selected sequences are not counted in next segments
+			for (int64_t p = best; p < best + TRAIN_SEGMENT_LEN - TRAIN_SEQ_LEN + 1; p++)
+			{
+				if (s.seqs[p] != TRAIN_NO_SEQ)
+					s.freqs[s.seqs[p]] = 0;
+			}
+
+			tail -= TRAIN_SEGMENT_LEN;
+			memcpy(dict + tail, samples + best, TRAIN_SEGMENT_LEN);
+		}
+
+		res = dictCapacity - tail;
+		if (tail > 0)
+			blazer_move_down(dict, dict + tail, (size_t)res);
+	}
+
+	if (s.seqs != 0)
+		blazer_free(s.seqs);
+	if (s.freqs != 0)
+		blazer_free(s.freqs);
+	if (s.active != 0)
+		blazer_free(s.active);
+	return res;
+}
@@ -0,0 +1,153 @@
+#include "stdafx.h"
+#include "Blazer.h"
+#include "FileMap.h"
+
+// decoder gets at least this free space in output buffer
+#define DECODE_OUT_MIN (64 << 10)
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+static int64_t compress_file(blazer_frame_encoder* encoder, const char* inPath, const char* outPath, uint32_t flags)
+{
+	blazer_mapped_file in;
+	if (!blazer_map_file(&in, inPath))
+		return BLAZER_FILE_ERROR_INPUT;
+
+	// data is passed by whole blocks, so blocks of independent algorithms are compressed from mapping without copying
+	int64_t chunk = 512 << (flags & BLAZER_FLAG_BLOCK_SIZE_MASK);
+	int64_t bound = blazer_frame_encoder_bound(encoder, chunk);
+	blazer_file_writer writer;
+	if (!blazer_writer_open(&writer, outPath, bound))
+	{
+		blazer_unmap_file(&in);
+		return BLAZER_FILE_ERROR_OUTPUT;
+	}
+
+	int64_t res = 0;
+	for (int64_t pos = 0; pos < in.length; pos += chunk)
+	{
+		unsigned char* out = blazer_writer_reserve(&writer, bound);
+		if (out == NULL)
+		{
+			res = BLAZER_FILE_ERROR_OUTPUT;
+			break;
+		}
+
+		// space is reserved by bound, so encoder fails only if it cannot allocate memory for compression of block
+		int64_t written = blazer_frame_encoder_write(encoder, in.data + pos, MIN(chunk, in.length - pos), out, bound);
+		if (written < 0)
+		{
+			res = BLAZER_FRAME_ERROR_MEMORY;
+			break;
+		}
+
+		blazer_writer_commit(&writer, written);
+	}
+
+	if (res == 0)
+	{
+		// index of blocks is written with last block, so space for it can be larger than buffer
+		int64_t finishBound = blazer_frame_encoder_bound(encoder, 0);
+		unsigned char* out = blazer_writer_reserve(&writer, finishBound);
+		int64_t written = out != NULL ? blazer_frame_encoder_finish(encoder, out, finishBound) : BLAZER_FILE_ERROR_OUTPUT;
+		if (written < 0)
+		{
+			res = out != NULL ? BLAZER_FRAME_ERROR_MEMORY : BLAZER_FILE_ERROR_OUTPUT;
+		}
+		else
+		{
+			blazer_writer_commit(&writer, written);
+			res = blazer_writer_flush(&writer, true) ? writer.written : BLAZER_FILE_ERROR_OUTPUT;
+		}
+	}
+
+	blazer_writer_close(&writer);
+	blazer_unmap_file(&in);
+	return res;
+}
+
+extern "C" BLAZER_API int64_t blazer_file_compress(const char* inPath, const char* outPath, uint32_t flags, int32_t algorithm, int32_t level)
+{
+	blazer_frame_encoder* encoder = blazer_frame_encoder_create(flags, algorithm, level);
+	if (encoder == NULL)
+		return BLAZER_FILE_ERROR_ARGUMENT;
+
+	int64_t res = compress_file(encoder, inPath, outPath, flags);
+	blazer_frame_encoder_destroy(encoder);
+	return res;
+}
+
+extern "C" BLAZER_API int64_t blazer_file_compress_indexed(const char* inPath, const char* outPath, uint32_t flags, int32_t algorithm, int32_t level)
+{
+	blazer_frame_encoder* encoder = blazer_frame_encoder_create(flags, algorithm, level);
+	if (encoder == NULL)
+		return BLAZER_FILE_ERROR_ARGUMENT;
+
+	int64_t res = blazer_frame_encoder_enable_index(encoder) == 0 ? compress_file(encoder, inPath, outPath, flags) : BLAZER_FILE_ERROR_ARGUMENT;
+	blazer_frame_encoder_destroy(encoder);
+	return res;
+}
+
+extern "C" BLAZER_API int64_t blazer_file_compress_restartable(const char* inPath, const char* outPath, uint32_t flags, int32_t algorithm, int32_t level, int64_t restartInterval)
+{
+	blazer_frame_encoder* encoder = blazer_frame_encoder_create(flags, algorithm, level);
+	if (encoder == NULL)
+		return BLAZER_FILE_ERROR_ARGUMENT;
+
+	int64_t res = blazer_frame_encoder_set_restart_interval(encoder, restartInterval) == 0 ? compress_file(encoder, inPath, outPath, flags) : BLAZER_FILE_ERROR_ARGUMENT;
+	blazer_frame_encoder_destroy(encoder);
+	return res;
+}
+
+extern "C" BLAZER_API int64_t blazer_file_decompress(const char* inPath, const char* outPath)
+{
+	blazer_frame_decoder* decoder = blazer_frame_decoder_create(BLAZER_FLAG_INCLUDE_HEADER);
+	if (decoder == NULL)
+		return BLAZER_FRAME_ERROR_MEMORY;
+
+	blazer_mapped_file in;
+	if (!blazer_map_file(&in, inPath))
+	{
+		blazer_frame_decoder_destroy(decoder);
+		return BLAZER_FILE_ERROR_INPUT;
+	}
+
+	blazer_file_writer writer;
+	if (!blazer_writer_open(&writer, outPath, DECODE_OUT_MIN))
+	{
+		blazer_unmap_file(&in);
+		blazer_frame_decoder_destroy(decoder);
+		return BLAZER_FILE_ERROR_OUTPUT;
+	}
+
+	// whole blocks are decoded from mapping, only blocks which are split between calls are copied
+	int64_t res = 0;
+	size_t inPos = 0;
+	while (res == 0)
+	{
+		unsigned char* out = blazer_writer_reserve(&writer, DECODE_OUT_MIN);
+		if (out == NULL)
+		{
+			res = BLAZER_FILE_ERROR_OUTPUT;
+			break;
+		}
+
+		size_t inLength = (size_t)in.length - inPos;
+		size_t outFree = (size_t)(writer.capacity - writer.pos);
+		size_t outLength = outFree;
+		res = blazer_frame_decode(decoder, in.data + inPos, &inLength, out, &outLength);
+		inPos += inLength;
+		blazer_writer_commit(&writer, outLength);
+		// decoder stops before end of input only if output is full
+		if (res == 0 && inPos == (size_t)in.length && outLength < outFree)
+			res = blazer_frame_decoder_end(decoder);
+	}
+
+	if (res == 1)
+		res = blazer_writer_flush(&writer, true) ? writer.written : BLAZER_FILE_ERROR_OUTPUT;
+
+	blazer_writer_close(&writer);
+	blazer_unmap_file(&in);
+	blazer_frame_decoder_destroy(decoder);
+	return res;
+}
@@ -0,0 +1,806 @@
+#include "stdafx.h"
+#include "Blazer.h"
+#include "Block.h"
+#include "Stream.h"
+#include "FrameIndex.h"
+#include "Probe.h"
+#include "Threading.h"
+
+// framed format of BlazerInputStream and BlazerOutputStream (see Blazer.Net)
+
+#define MAX_BACK_REF ((1 << 16) + 256)
+#define FILE_HEADER_SIZE 8
+#define FOOTER_SIZE 4
+#define BLOCK_HEADER_SIZE 4
+#define BLOCK_HEADER_CRC_SIZE 8
+// encoder reads some bytes after data and decoder copies by wide chunks, so window has spare bytes for both
+#define WINDOW_SPARE BLAZER_DECOMPRESS_MARGIN
+#define COMPRESS_BOUND(len) ((len) + ((len) >> 8) + 16)
+
+#define BLOCK_TYPE_CONTROL_DATA_EMPTY 0xf0
+#define BLOCK_TYPE_CONTROL_DATA 0xf1
+#define BLOCK_TYPE_COMMENT 0xf9
+#define BLOCK_TYPE_FILE_INFO 0xfd
+#define BLOCK_TYPE_FOOTER 0xff
+
+// flags of Blazer.Net, which are not supported by native library
+#define FLAG_ENCRYPT_INNER 0x1000
+#define FLAG_ENCRYPT_OUTER 0x2000
+#define FLAG_ONLY_ONE_FILE 0x8000
+#define FLAG_MULTIPLE_FILES 0x10000
+#define FLAG_INCLUDE_COMMENT 0x20000
+#define FLAG_ALGORITHM_MASK 0xf0
+
+#define ENCODER_FLAGS (BLAZER_FLAG_BLOCK_SIZE_MASK | BLAZER_FLAG_INCLUDE_CRC | BLAZER_FLAG_INCLUDE_HEADER | BLAZER_FLAG_INCLUDE_FOOTER | BLAZER_FLAG_RESPECT_FLUSH)
+// file info and comment blocks are skipped by decoder, so these flags can be read
+#define DECODER_FLAGS (ENCODER_FLAGS | FLAG_ALGORITHM_MASK | FLAG_ONLY_ONE_FILE | FLAG_MULTIPLE_FILES | FLAG_INCLUDE_COMMENT)
+
+#define CTX_ALIGN 64
+#define ALIGN_UP(v) (((v) + CTX_ALIGN - 1) & ~(size_t)(CTX_ALIGN - 1))
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+// ways of compression of block chosen by adaptive encoder: data is stored as is, compressed by level of encoder
+// or by high level of stream encoder
+#define MODE_RAW 0
+#define MODE_COMPRESS 1
+#define MODE_HIGH 2
+
+static BLAZER_INLINE void write_le32(unsigned char* p, uint32_t v)
+{
+	p[0] = (unsigned char)v;
+	p[1] = (unsigned char)(v >> 8);
+	p[2] = (unsigned char)(v >> 16);
+	p[3] = (unsigned char)(v >> 24);
+}
+
+static BLAZER_INLINE uint32_t read_le32(const unsigned char* p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+struct blazer_frame_encoder
+{
+	uint32_t flags;
+	int32_t algorithm;
+	int32_t level;
+	int32_t blockSize;
+	int32_t blockHeaderSize;
+	int32_t isHeaderWritten;
+	// data of current block. For stream algorithm it is placed after history, which is moved to start of window when next block does not fit
+	unsigned char* window;
+	int32_t windowLength;
+	// start of current block in window
+	int32_t pos;
+	// count of collected bytes of current block
+	int32_t blockLength;
+	// global offset of window start for positions in hash table, can overflow
+	uint32_t shift;
+	int32_t* hashArr;
+	blazer_block_hash blockHash;
+	// blocks of block algorithm are written with explicit offsets (BLAZER_BLOCK_TYPE_BLOCK_OFFSETS)
+	int32_t isOffsets;
+	// count of written bytes of data and of framed output
+	int64_t totalIn;
+	int64_t totalOut;
+	// index of blocks, it is written by finish
+	int32_t isIndexEnabled;
+	// minimal count of bytes between restart points (entries of index), 0 - every block
+	int64_t restartInterval;
+	// uncompressed offset of last restart point
+	int64_t restartPos;
+	// next block starts new entry, history of stream is dropped before it
+	int32_t isRestartPoint;
+	blazer_index_entry* entries;
+	int64_t entryCount;
+	int64_t entryCapacity;
+	// adaptive encoding: table of probe (null if it is disabled), level and hash table of stream encoder for blocks
+	// with many repeats (0 and null if they are compressed by level of encoder)
+	int32_t* probeHashArr;
+	int32_t highLevel;
+	int32_t* highHashArr;
+	blazer_adaptive_stats adaptiveStats;
+};
+
+extern "C" BLAZER_API blazer_frame_encoder* blazer_frame_encoder_create(uint32_t flags, int32_t algorithm, int32_t level)
+{
+	if ((flags & ~(uint32_t)ENCODER_FLAGS) != 0 || algorithm < BLAZER_ALGORITHM_NO_COMPRESS || algorithm > BLAZER_ALGORITHM_BLOCK)
+		return 0;
+	if (level == 0)
+		level = BLAZER_STREAM_LEVEL_DEFAULT;
+
+	int32_t blockSize = 512 << (flags & BLAZER_FLAG_BLOCK_SIZE_MASK);
+	int32_t hashSize = 0;
+	int32_t windowLength = blockSize;
+	if (algorithm == BLAZER_ALGORITHM_STREAM)
+	{
+		hashSize = blazer_stream_hash_size(level);
+		if (hashSize == 0)
+			return 0;
+		// window has space for two lengths of history, so history is moved after at least MAX_BACK_REF bytes of data
+		windowLength = 2 * MAX_BACK_REF + blockSize;
+	}
+	else if (algorithm == BLAZER_ALGORITHM_BLOCK)
+	{
+		hashSize = BLAZER_BLOCK_HASH_SIZE;
+	}
+
+	size_t hashOffset = ALIGN_UP(sizeof(blazer_frame_encoder));
+	size_t windowOffset = hashOffset + ALIGN_UP(sizeof(int32_t) * (size_t)hashSize);
+	blazer_frame_encoder* encoder = (blazer_frame_encoder*)blazer_alloc_zero(windowOffset + windowLength + WINDOW_SPARE);
+	if (encoder == 0)
+		return 0;
+
+	encoder->flags = flags;
+	encoder->algorithm = algorithm;
+	encoder->level = level;
+	encoder->blockSize = blockSize;
+	encoder->blockHeaderSize = (flags & BLAZER_FLAG_INCLUDE_CRC) != 0 ? BLOCK_HEADER_CRC_SIZE : BLOCK_HEADER_SIZE;
+	// header is written with first data
+	encoder->isHeaderWritten = (flags & BLAZER_FLAG_INCLUDE_HEADER) == 0;
+	encoder->hashArr = (int32_t*)((unsigned char*)encoder + hashOffset);
+	encoder->window = (unsigned char*)encoder + windowOffset;
+	encoder->windowLength = windowLength;
+	encoder->blockHash.arr = encoder->hashArr;
+	encoder->blockHash.base = 0;
+	encoder->isRestartPoint = 1;
+	return encoder;
+}
+
+extern "C" BLAZER_API void blazer_frame_encoder_destroy(blazer_frame_encoder* encoder)
+{
+	if (encoder == 0)
+		return;
+	if (encoder->entries != 0)
+		blazer_free(encoder->entries);
+	if (encoder->probeHashArr != 0)
+		blazer_free(encoder->probeHashArr);
+	if (encoder->highHashArr != 0)
+		blazer_free(encoder->highHashArr);
+	blazer_free(encoder);
+}
+
+extern "C" BLAZER_API int32_t blazer_frame_encoder_enable_index(blazer_frame_encoder* encoder)
+{
+	// blocks of stream depend on previous ones, so they can be decoded from index only after restart of history
+	if (encoder->algorithm == BLAZER_ALGORITHM_STREAM)
+		return -1;
+	return blazer_frame_encoder_set_restart_interval(encoder, 0);
+}
+
+extern "C" BLAZER_API int32_t blazer_frame_encoder_set_restart_interval(blazer_frame_encoder* encoder, int64_t interval)
+{
+	if (interval < 0 || encoder->totalOut > 0 || encoder->blockLength > 0)
+		return -1;
+	encoder->isIndexEnabled = 1;
+	encoder->restartInterval = interval;
+	return 0;
+}
+
+extern "C" BLAZER_API int32_t blazer_frame_encoder_use_offsets(blazer_frame_encoder* encoder)
+{
+	if (encoder->algorithm != BLAZER_ALGORITHM_BLOCK || encoder->totalOut > 0 || encoder->blockLength > 0)
+		return -1;
+	encoder->isOffsets = 1;
+	return 0;
+}
+
+extern "C" BLAZER_API int32_t blazer_frame_encoder_set_adaptive(blazer_frame_encoder* encoder, int32_t highLevel)
+{
+	if (encoder->algorithm == BLAZER_ALGORITHM_NO_COMPRESS || encoder->probeHashArr != 0 || encoder->totalOut > 0 || encoder->blockLength > 0)
+		return -1;
+	// levels of stream are decoded by same decoder, so they can be mixed in one frame
+	int32_t highHashSize = 0;
+	if (highLevel != 0)
+	{
+		highHashSize = encoder->algorithm == BLAZER_ALGORITHM_STREAM ? blazer_stream_hash_size(highLevel) : 0;
+		if (highHashSize == 0)
+			return -1;
+	}
+
+	encoder->probeHashArr = (int32_t*)blazer_alloc_zero(sizeof(int32_t) * BLAZER_PROBE_HASH_SIZE);
+	if (encoder->probeHashArr == 0)
+		return -1;
+	if (highHashSize > 0)
+	{
+		encoder->highHashArr = (int32_t*)blazer_alloc_zero(sizeof(int32_t) * (size_t)highHashSize);
+		if (encoder->highHashArr == 0)
+		{
+			blazer_free(encoder->probeHashArr);
+			encoder->probeHashArr = 0;
+			return -1;
+		}
+		encoder->highLevel = highLevel;
+	}
+
+	return 0;
+}
+
+extern "C" BLAZER_API void blazer_frame_encoder_get_adaptive_stats(const blazer_frame_encoder* encoder, blazer_adaptive_stats* stats)
+{
+	*stats = encoder->adaptiveStats;
+}
+
+// reserves space for entries of blocks of next length bytes, returns false if memory cannot be allocated
+static bool reserve_entries(blazer_frame_encoder* encoder, int64_t length)
+{
+	int64_t required = encoder->entryCount + (encoder->blockLength + length) / encoder->blockSize + 1;
+	if (!encoder->isIndexEnabled || required <= encoder->entryCapacity)
+		return true;
+
+	int64_t capacity = encoder->entryCapacity * 2 > required ? encoder->entryCapacity * 2 : required;
+	blazer_index_entry* entries = (blazer_index_entry*)blazer_alloc_zero(sizeof(blazer_index_entry) * (size_t)capacity);
+	if (entries == 0)
+		return false;
+	if (encoder->entries != 0)
+	{
+		memcpy(entries, encoder->entries, sizeof(blazer_index_entry) * (size_t)encoder->entryCount);
+		blazer_free(encoder->entries);
+	}
+
+	encoder->entries = entries;
+	encoder->entryCapacity = capacity;
+	return true;
+}
+
+// size of header, blocks of next length bytes and footer without index, which is written only by finish
+static int64_t blocks_bound(const blazer_frame_encoder* encoder, int64_t length)
+{
+	int64_t blockCount = (encoder->blockLength + length) / encoder->blockSize + 1;
+	return FILE_HEADER_SIZE + blockCount * (encoder->blockHeaderSize + COMPRESS_BOUND(encoder->blockSize)) + FOOTER_SIZE;
+}
+
+extern "C" BLAZER_API int64_t blazer_frame_encoder_bound(const blazer_frame_encoder* encoder, int64_t length)
+{
+	int64_t blockCount = (encoder->blockLength + length) / encoder->blockSize + 1;
+	int64_t indexSize = encoder->isIndexEnabled ? blazer_index_size(encoder->entryCount + blockCount, encoder->blockSize, encoder->blockHeaderSize) : 0;
+	return blocks_bound(encoder, length) + indexSize;
+}
+
+static int32_t write_header(blazer_frame_encoder* encoder, unsigned char* out)
+{
+	if (encoder->isHeaderWritten)
+		return 0;
+
+	out[0] = 'b';
+	out[1] = 'L';
+	out[2] = 'z';
+	// version of file structure
+	out[3] = 0x01;
+	write_le32(out + 4, (encoder->flags & ~(uint32_t)FLAG_ALGORITHM_MASK) | ((uint32_t)encoder->algorithm << 4));
+	encoder->isHeaderWritten = 1;
+	encoder->totalOut += FILE_HEADER_SIZE;
+	return FILE_HEADER_SIZE;
+}
+
+// crc of payload is finished by track, which is started at payload and can be updated by compressor
+static int32_t write_block_header(blazer_frame_encoder* encoder, unsigned char* out, unsigned char type, int32_t length, blazer_crc_track* crcTrack)
+{
+	// length is at least 1, so it is written without this byte
+	write_le32(out, type | ((uint32_t)(length - 1) << 8));
+	if ((encoder->flags & BLAZER_FLAG_INCLUDE_CRC) != 0)
+		write_le32(out + 4, blazer_crc_track_finish(crcTrack, out + encoder->blockHeaderSize + length));
+	return encoder->blockHeaderSize + length;
+}
+
+static int32_t encode_block(blazer_frame_encoder* encoder, unsigned char* data, int32_t length, unsigned char* out, blazer_crc_track* inTrack);
+
+// compresses length bytes of data into block. Data is in window for stream algorithm and can be anywhere for other ones
+static int32_t write_block(blazer_frame_encoder* encoder, unsigned char* data, int32_t length, unsigned char* out)
+{
+	if (length == 0)
+		return 0;
+
+	blazer_index_entry* entry = 0;
+	if (encoder->isIndexEnabled && encoder->isRestartPoint)
+	{
+		// space is reserved by caller
+		entry = &encoder->entries[encoder->entryCount++];
+		entry->compressedOffset = encoder->totalOut;
+		entry->uncompressedOffset = encoder->totalIn;
+		entry->crc = 0;
+		encoder->restartPos = encoder->totalIn;
+		encoder->isRestartPoint = 0;
+	}
+	else if (encoder->isIndexEnabled)
+	{
+		entry = &encoder->entries[encoder->entryCount - 1];
+	}
+
+	// crc of entry covers all its blocks, it is calculated by compressor while data is in cache
+	blazer_crc_track inTrack;
+	blazer_crc_track_init(&inTrack, data);
+	inTrack.crc = entry != 0 ? entry->crc : 0;
+	int32_t written = encode_block(encoder, data, length, out, entry != 0 ? &inTrack : 0);
+	if (entry != 0)
+		entry->crc = blazer_crc_track_finish(&inTrack, data + length);
+	encoder->totalIn += length;
+	encoder->totalOut += written;
+	if (encoder->isIndexEnabled && encoder->totalIn - encoder->restartPos >= encoder->restartInterval)
+		encoder->isRestartPoint = 1;
+	return written;
+}
+
+// returns way of compression of block, it is chosen by probe for adaptive encoder
+static int32_t choose_mode(blazer_frame_encoder* encoder, unsigned char* data, int32_t length)
+{
+	if (encoder->algorithm == BLAZER_ALGORITHM_NO_COMPRESS)
+		return MODE_RAW;
+	if (encoder->probeHashArr == 0)
+		return MODE_COMPRESS;
+
+	int64_t start = blazer_time_ns();
+	// repeats of history before block are found too
+	int32_t history = encoder->algorithm == BLAZER_ALGORITHM_STREAM ? MIN(encoder->pos, BLAZER_PROBE_HISTORY) : 0;
+	int32_t repeats = blazer_probe_repeats(data - history, history, history + length, encoder->probeHashArr);
+	encoder->adaptiveStats.probeNanoseconds += blazer_time_ns() - start;
+	if (repeats < BLAZER_PROBE_RAW_MAX)
+	{
+		encoder->adaptiveStats.rawBlocks++;
+		encoder->adaptiveStats.rawBytes += length;
+		return MODE_RAW;
+	}
+	return repeats >= BLAZER_PROBE_HIGH_MIN && encoder->highHashArr != 0 ? MODE_HIGH : MODE_COMPRESS;
+}
+
+// inTrack (can be null) is updated with crc of data
+static int32_t encode_block(blazer_frame_encoder* encoder, unsigned char* data, int32_t length, unsigned char* out, blazer_crc_track* inTrack)
+{
+	unsigned char* outData = out + encoder->blockHeaderSize;
+	blazer_crc_track outTrack;
+	blazer_crc_track_init(&outTrack, outData);
+	blazer_crc_track* outTrackUsed = (encoder->flags & BLAZER_FLAG_INCLUDE_CRC) != 0 ? &outTrack : 0;
+	int32_t comprLength = length + 1;
+	unsigned char type = (unsigned char)encoder->algorithm;
+	blazer_adaptive_stats* stats = &encoder->adaptiveStats;
+	int32_t mode = choose_mode(encoder, data, length);
+	if (mode == MODE_HIGH)
+	{
+		comprLength = blazer_stream_compress_track(encoder->window, encoder->pos, encoder->pos + length, (int32_t)encoder->shift, outData, 0, encoder->highHashArr, encoder->highLevel, inTrack, outTrackUsed);
+		stats->highBlocks++;
+		stats->highBytes += length;
+	}
+	else if (mode == MODE_COMPRESS && encoder->algorithm == BLAZER_ALGORITHM_STREAM)
+	{
+		comprLength = blazer_stream_compress_track(encoder->window, encoder->pos, encoder->pos + length, (int32_t)encoder->shift, outData, 0, encoder->hashArr, encoder->level, inTrack, outTrackUsed);
+		stats->compressedBlocks++;
+		stats->compressedBytes += length;
+	}
+	else if (mode == MODE_COMPRESS)
+	{
+		int32_t base = blazer_block_hash_acquire(&encoder->blockHash, length);
+		comprLength = blazer_block_compress_track(data, 0, length, outData, 0, encoder->hashArr, base, encoder->isOffsets != 0, inTrack, outTrackUsed);
+		if (encoder->isOffsets)
+			type = BLAZER_BLOCK_TYPE_BLOCK_OFFSETS;
+		stats->compressedBlocks++;
+		stats->compressedBytes += length;
+	}
+
+	// should not compress (data is still in history of stream, as in managed encoder)
+	if (comprLength > length)
+	{
+		if (mode != MODE_RAW)
+			stats->expandedBlocks++;
+		memcpy(outData, data, length);
+		blazer_crc_track_init(&outTrack, outData);
+		return write_block_header(encoder, out, BLAZER_ALGORITHM_NO_COMPRESS, length, &outTrack);
+	}
+
+	return write_block_header(encoder, out, type, comprLength, &outTrack);
+}
+
+// writes collected data as block and prepares window for next block
+static int32_t write_collected(blazer_frame_encoder* encoder, unsigned char* out)
+{
+	int32_t written = write_block(encoder, encoder->window + encoder->pos, encoder->blockLength, out);
+	if (encoder->algorithm == BLAZER_ALGORITHM_STREAM)
+	{
+		encoder->pos += encoder->blockLength;
+		if (encoder->isIndexEnabled && encoder->isRestartPoint)
+		{
+			// next block starts window without history. Positions of hash table are before new shift,
+			// so compressor rejects them as references before start of buffer and table is not cleared
+			encoder->shift += encoder->pos;
+			encoder->pos = 0;
+		}
+		else if (encoder->pos + encoder->blockSize > encoder->windowLength)
+		{
+			blazer_move_down(encoder->window, encoder->window + encoder->pos - MAX_BACK_REF, MAX_BACK_REF);
+			encoder->shift += encoder->pos - MAX_BACK_REF;
+			encoder->pos = MAX_BACK_REF;
+		}
+	}
+
+	encoder->blockLength = 0;
+	return written;
+}
+
+extern "C" BLAZER_API int64_t blazer_frame_encoder_write(blazer_frame_encoder* encoder, const unsigned char* data, int64_t length, unsigned char* out, int64_t outLength)
+{
+	if (length < 0 || outLength < blocks_bound(encoder, length) || !reserve_entries(encoder, length))
+		return -1;
+
+	int64_t written = write_header(encoder, out);
+	while (length > 0)
+	{
+		// full blocks of independent algorithms are compressed directly from data
+		if (encoder->blockLength == 0 && length >= encoder->blockSize && encoder->algorithm != BLAZER_ALGORITHM_STREAM)
+		{
+			written += write_block(encoder, (unsigned char*)data, encoder->blockSize, out + written);
+			data += encoder->blockSize;
+			length -= encoder->blockSize;
+			continue;
+		}
+
+		int32_t cnt = (int32_t)MIN(length, (int64_t)(encoder->blockSize - encoder->blockLength));
+		memcpy(encoder->window + encoder->pos + encoder->blockLength, data, cnt);
+		encoder->blockLength += cnt;
+		data += cnt;
+		length -= cnt;
+		if (encoder->blockLength == encoder->blockSize)
+			written += write_collected(encoder, out + written);
+	}
+
+	return written;
+}
+
+extern "C" BLAZER_API int64_t blazer_frame_encoder_flush(blazer_frame_encoder* encoder, unsigned char* out, int64_t outLength)
+{
+	if (outLength < blocks_bound(encoder, 0) || !reserve_entries(encoder, 0))
+		return -1;
+
+	int64_t written = write_header(encoder, out);
+	if ((encoder->flags & BLAZER_FLAG_RESPECT_FLUSH) != 0)
+		written += write_collected(encoder, out + written);
+	return written;
+}
+
+extern "C" BLAZER_API int64_t blazer_frame_encoder_finish(blazer_frame_encoder* encoder, unsigned char* out, int64_t outLength)
+{
+	if (outLength < blazer_frame_encoder_bound(encoder, 0) || !reserve_entries(encoder, 0))
+		return -1;
+
+	int64_t written = write_header(encoder, out);
+	written += write_collected(encoder, out + written);
+	if (encoder->isIndexEnabled)
+	{
+		int64_t indexSize = blazer_index_write(encoder->entries, encoder->entryCount, encoder->totalIn, encoder->blockSize, (encoder->flags & BLAZER_FLAG_INCLUDE_CRC) != 0, out + written);
+		written += indexSize;
+		encoder->totalOut += indexSize;
+		// finish can be called again, but index should not be written twice
+		encoder->isIndexEnabled = 0;
+	}
+
+	if ((encoder->flags & BLAZER_FLAG_INCLUDE_FOOTER) != 0)
+	{
+		unsigned char* footer = out + written;
+		footer[0] = BLOCK_TYPE_FOOTER;
+		footer[1] = 'Z';
+		footer[2] = 'l';
+		footer[3] = 'B';
+		written += FOOTER_SIZE;
+	}
+
+	return written;
+}
+
+enum frame_decoder_state
+{
+	STATE_HEADER,
+	STATE_BLOCK_HEADER,
+	STATE_BLOCK_DATA,
+	STATE_OUTPUT,
+	STATE_FINISHED,
+	STATE_ERROR
+};
+
+struct blazer_frame_decoder
+{
+	frame_decoder_state state;
+	int32_t error;
+	uint32_t flags;
+	int32_t algorithm;
+	int32_t blockSize;
+	// file header or header of current block
+	unsigned char header[FILE_HEADER_SIZE];
+	int32_t headerPos;
+	int32_t blockType;
+	int32_t blockLength;
+	// compressed block, which is split between calls
+	unsigned char* inBuffer;
+	int32_t inPos;
+	// decompressed data, for stream algorithm it is placed after history
+	unsigned char* window;
+	int32_t windowLength;
+	// end of decompressed data
+	int32_t pos;
+	// start of data, which is not returned yet
+	int32_t outPos;
+	blazer_block_hash blockHash;
+	// buffers are allocated when size of block is known
+	void* buffers;
+};
+
+static int32_t init_decoder(blazer_frame_decoder* decoder, uint32_t flags)
+{
+	if ((flags & ~(uint32_t)DECODER_FLAGS) != 0)
+		return BLAZER_FRAME_ERROR_FLAGS;
+	int32_t algorithm = (flags & FLAG_ALGORITHM_MASK) >> 4;
+	if (algorithm > BLAZER_ALGORITHM_BLOCK)
+		return BLAZER_FRAME_ERROR_FLAGS;
+
+	decoder->flags = flags;
+	decoder->algorithm = algorithm;
+	decoder->blockSize = 512 << (flags & BLAZER_FLAG_BLOCK_SIZE_MASK);
+	decoder->windowLength = algorithm == BLAZER_ALGORITHM_STREAM ? 2 * MAX_BACK_REF + decoder->blockSize : decoder->blockSize;
+	int32_t hashSize = algorithm == BLAZER_ALGORITHM_BLOCK ? BLAZER_BLOCK_HASH_SIZE : 0;
+
+	size_t windowOffset = ALIGN_UP(sizeof(int32_t) * (size_t)hashSize);
+	size_t inOffset = windowOffset + ALIGN_UP((size_t)decoder->windowLength + WINDOW_SPARE);
+	unsigned char* buffers = (unsigned char*)blazer_alloc_zero(inOffset + decoder->blockSize);
+	if (buffers == 0)
+		return BLAZER_FRAME_ERROR_MEMORY;
+
+	decoder->buffers = buffers;
+	decoder->blockHash.arr = (int32_t*)buffers;
+	decoder->blockHash.base = 0;
+	decoder->window = buffers + windowOffset;
+	decoder->inBuffer = buffers + inOffset;
+	decoder->state = STATE_BLOCK_HEADER;
+	return 0;
+}
+
+extern "C" BLAZER_API blazer_frame_decoder* blazer_frame_decoder_create(uint32_t flags)
+{
+	blazer_frame_decoder* decoder = (blazer_frame_decoder*)blazer_alloc_zero(sizeof(blazer_frame_decoder));
+	if (decoder == 0)
+		return 0;
+
+	decoder->state = STATE_HEADER;
+	if ((flags & BLAZER_FLAG_INCLUDE_HEADER) == 0 && init_decoder(decoder, flags) != 0)
+	{
+		blazer_frame_decoder_destroy(decoder);
+		return 0;
+	}
+
+	return decoder;
+}
+
+extern "C" BLAZER_API void blazer_frame_decoder_destroy(blazer_frame_decoder* decoder)
+{
+	if (decoder == 0)
+		return;
+	if (decoder->buffers != 0)
+		blazer_free(decoder->buffers);
+	blazer_free(decoder);
+}
+
+static int32_t parse_header(blazer_frame_decoder* decoder)
+{
+	unsigned char* h = decoder->header;
+	if (h[0] != 'b' || h[1] != 'L' || h[2] != 'z' || h[3] != 0x01)
+		return BLAZER_FRAME_ERROR_HEADER;
+	return init_decoder(decoder, read_le32(h + 4));
+}
+
+// returns 1 if all bytes of header are collected, 0 if more data is required or error
+static int32_t parse_block_header(blazer_frame_decoder* decoder)
+{
+	unsigned char* h = decoder->header;
+	decoder->blockType = h[0];
+	if (decoder->blockType == BLOCK_TYPE_FOOTER)
+	{
+		if (h[1] != 'Z' || h[2] != 'l' || h[3] != 'B')
+			return BLAZER_FRAME_ERROR_BLOCK;
+		decoder->state = STATE_FINISHED;
+		return 1;
+	}
+
+	// some variant of ping message, has no data
+	if (decoder->blockType == BLOCK_TYPE_CONTROL_DATA_EMPTY)
+	{
+		decoder->headerPos = 0;
+		return 1;
+	}
+
+	decoder->blockLength = (int32_t)(read_le32(h) >> 8) + 1;
+	if (decoder->blockLength > decoder->blockSize)
+		return BLAZER_FRAME_ERROR_BLOCK;
+	if ((decoder->flags & BLAZER_FLAG_INCLUDE_CRC) != 0 && decoder->headerPos < BLOCK_HEADER_CRC_SIZE)
+		return 0;
+
+	decoder->headerPos = 0;
+	decoder->inPos = 0;
+	decoder->state = STATE_BLOCK_DATA;
+	return 1;
+}
+
+static int32_t process_block(blazer_frame_decoder* decoder, unsigned char* data)
+{
+	int32_t length = decoder->blockLength;
+	int32_t type = decoder->blockType;
+	bool isCrc = (decoder->flags & BLAZER_FLAG_INCLUDE_CRC) != 0;
+	bool isCompressed = type == decoder->algorithm || type == BLAZER_BLOCK_TYPE_BLOCK_OFFSETS;
+	// crc of compressed block is calculated by decompressor while data is in cache, other blocks are checked before processing
+	if (isCrc && !isCompressed && crc32c_append(0, data, length) != read_le32(decoder->header + 4))
+		return BLAZER_FRAME_ERROR_CRC;
+
+	if (type == BLOCK_TYPE_CONTROL_DATA || type == BLOCK_TYPE_COMMENT || type == BLOCK_TYPE_FILE_INFO)
+	{
+		decoder->state = STATE_BLOCK_HEADER;
+		return 0;
+	}
+
+	if (type != BLAZER_ALGORITHM_NO_COMPRESS && type != decoder->algorithm
+		&& !(type == BLAZER_BLOCK_TYPE_BLOCK_OFFSETS && decoder->algorithm == BLAZER_ALGORITHM_BLOCK))
+	{
+		// damaged type is reported as damaged data
+		if (isCrc && crc32c_append(0, data, length) != read_le32(decoder->header + 4))
+			return BLAZER_FRAME_ERROR_CRC;
+		return BLAZER_FRAME_ERROR_BLOCK;
+	}
+
+	// independent blocks are always decompressed from start of window
+	if (decoder->algorithm != BLAZER_ALGORITHM_STREAM)
+		decoder->pos = 0;
+	else if (decoder->pos + decoder->blockSize > decoder->windowLength)
+	{
+		blazer_move_down(decoder->window, decoder->window + decoder->pos - MAX_BACK_REF, MAX_BACK_REF);
+		decoder->pos = MAX_BACK_REF;
+	}
+
+	int32_t res;
+	blazer_crc_track inTrack;
+	blazer_crc_track_init(&inTrack, data);
+	blazer_crc_track* inTrackUsed = isCrc ? &inTrack : 0;
+	if (type == BLAZER_ALGORITHM_NO_COMPRESS)
+	{
+		memcpy(decoder->window + decoder->pos, data, length);
+		res = decoder->pos + length;
+	}
+	else if (type == BLAZER_ALGORITHM_STREAM)
+	{
+		res = blazer_stream_decompress_track(data, 0, length, decoder->window, decoder->pos, decoder->pos + decoder->blockSize, inTrackUsed, 0);
+	}
+	else if (type == BLAZER_BLOCK_TYPE_BLOCK_OFFSETS)
+	{
+		res = blazer_block_decompress_offsets_track(data, 0, length, decoder->window, 0, decoder->blockSize, inTrackUsed, 0);
+	}
+	else
+	{
+		int32_t base = blazer_block_hash_acquire(&decoder->blockHash, decoder->blockSize);
+		res = blazer_block_decompress_track(data, 0, length, decoder->window, 0, decoder->blockSize, decoder->blockHash.arr, base, inTrackUsed, 0);
+	}
+
+	// data is checked after decompression, so damaged block is reported as crc error as before, even if it cannot be decompressed
+	if (isCompressed && isCrc)
+	{
+		uint32_t crc = res >= 0 ? blazer_crc_track_finish(&inTrack, data + length) : crc32c_append(0, data, length);
+		if (crc != read_le32(decoder->header + 4))
+			return BLAZER_FRAME_ERROR_CRC;
+	}
+
+	if (res < 0)
+		return BLAZER_FRAME_ERROR_DATA;
+
+	decoder->outPos = decoder->pos;
+	decoder->pos = res;
+	decoder->state = STATE_OUTPUT;
+	return 0;
+}
+
+// copies bytes of header from input, returns true if header has required length
+static bool collect_header(blazer_frame_decoder* decoder, int32_t required, const unsigned char* in, size_t* inPos, size_t inLength)
+{
+	int32_t cnt = (int32_t)MIN((size_t)(required - decoder->headerPos), inLength - *inPos);
+	// input can be null when decoder is finished without data
+	if (cnt == 0)
+		return decoder->headerPos == required;
+	memcpy(decoder->header + decoder->headerPos, in + *inPos, cnt);
+	decoder->headerPos += cnt;
+	*inPos += cnt;
+	return decoder->headerPos == required;
+}
+
+extern "C" BLAZER_API int32_t blazer_frame_decode(blazer_frame_decoder* decoder, const unsigned char* in, size_t* inLength, unsigned char* out, size_t* outLength)
+{
+	size_t inPos = 0;
+	size_t outPos = 0;
+	int32_t res = 0;
+	while (res == 0)
+	{
+		if (decoder->state == STATE_HEADER)
+		{
+			if (!collect_header(decoder, FILE_HEADER_SIZE, in, &inPos, *inLength))
+				break;
+			decoder->headerPos = 0;
+			res = parse_header(decoder);
+		}
+		else if (decoder->state == STATE_BLOCK_HEADER)
+		{
+			// crc is read only for blocks with data
+			int32_t required = decoder->headerPos < BLOCK_HEADER_SIZE ? BLOCK_HEADER_SIZE : BLOCK_HEADER_CRC_SIZE;
+			if (!collect_header(decoder, required, in, &inPos, *inLength))
+				break;
+			res = parse_block_header(decoder);
+			if (res > 0)
+				res = 0;
+			else if (res == 0 && inPos == *inLength)
+				break;
+		}
+		else if (decoder->state == STATE_BLOCK_DATA)
+		{
+			unsigned char* data;
+			size_t available = *inLength - inPos;
+			// whole block in input is processed without copying
+			if (decoder->inPos == 0 && available >= (size_t)decoder->blockLength)
+			{
+				data = (unsigned char*)in + inPos;
+				inPos += decoder->blockLength;
+			}
+			else
+			{
+				int32_t cnt = (int32_t)MIN((size_t)(decoder->blockLength - decoder->inPos), available);
+				memcpy(decoder->inBuffer + decoder->inPos, in + inPos, cnt);
+				decoder->inPos += cnt;
+				inPos += cnt;
+				if (decoder->inPos < decoder->blockLength)
+					break;
+				data = decoder->inBuffer;
+			}
+
+			res = process_block(decoder, data);
+		}
+		else if (decoder->state == STATE_OUTPUT)
+		{
+			size_t cnt = MIN((size_t)(decoder->pos - decoder->outPos), *outLength - outPos);
+			memcpy(out + outPos, decoder->window + decoder->outPos, cnt);
+			outPos += cnt;
+			decoder->outPos += (int32_t)cnt;
+			if (decoder->outPos < decoder->pos)
+				break;
+			decoder->state = STATE_BLOCK_HEADER;
+		}
+		else if (decoder->state == STATE_FINISHED)
+		{
+			res = 1;
+		}
+		else
+		{
+			res = decoder->error;
+		}
+	}
+
+	if (res < 0)
+	{
+		decoder->state = STATE_ERROR;
+		decoder->error = res;
+	}
+
+	*inLength = inPos;
+	*outLength = outPos;
+	return res;
+}
+
+extern "C" BLAZER_API void blazer_frame_decoder_reset(blazer_frame_decoder* decoder)
+{
+	// buffers are kept, stale positions of block hash table are ignored by base
+	decoder->state = decoder->buffers != 0 ? STATE_BLOCK_HEADER : STATE_HEADER;
+	decoder->error = 0;
+	decoder->headerPos = 0;
+	decoder->inPos = 0;
+	decoder->pos = 0;
+	decoder->outPos = 0;
+}
+
+extern "C" BLAZER_API int32_t blazer_frame_decoder_end(blazer_frame_decoder* decoder)
+{
+	if (decoder->state == STATE_ERROR)
+		return decoder->error;
+	if (decoder->state == STATE_FINISHED)
+		return 1;
+	// stream without footer can be ended after any block
+	if (decoder->state == STATE_BLOCK_HEADER && decoder->headerPos == 0 && (decoder->flags & BLAZER_FLAG_INCLUDE_FOOTER) == 0)
+		return 1;
+	return BLAZER_FRAME_ERROR_TRUNCATED;
+}
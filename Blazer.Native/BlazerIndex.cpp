@@ -0,0 +1,370 @@
+#include "stdafx.h"
+#include "Blazer.h"
+#include "FileMap.h"
+#include "FrameIndex.h"
+
+#define FILE_HEADER_SIZE 8
+#define FOOTER_SIZE 4
+#define BLOCK_HEADER_SIZE 4
+#define BLOCK_HEADER_CRC_SIZE 8
+#define BLOCK_TYPE_CONTROL_DATA 0xf1
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+static const unsigned char IndexMagic[4] = { 'b', 'I', 'd', 'x' };
+
+static BLAZER_INLINE void write_le32(unsigned char* p, uint32_t v)
+{
+	p[0] = (unsigned char)v;
+	p[1] = (unsigned char)(v >> 8);
+	p[2] = (unsigned char)(v >> 16);
+	p[3] = (unsigned char)(v >> 24);
+}
+
+static BLAZER_INLINE void write_le64(unsigned char* p, int64_t v)
+{
+	write_le32(p, (uint32_t)v);
+	write_le32(p + 4, (uint32_t)((uint64_t)v >> 32));
+}
+
+static BLAZER_INLINE uint32_t read_le32(const unsigned char* p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static BLAZER_INLINE int64_t read_le64(const unsigned char* p)
+{
+	return (int64_t)((uint64_t)read_le32(p) | ((uint64_t)read_le32(p + 4) << 32));
+}
+
+// memcmp is not an intrinsic function in MSVC
+static BLAZER_INLINE bool is_magic(const unsigned char* p)
+{
+	return p[0] == IndexMagic[0] && p[1] == IndexMagic[1] && p[2] == IndexMagic[2] && p[3] == IndexMagic[3];
+}
+
+// length of next block of payload, trailer is kept in last block
+static BLAZER_INLINE int64_t index_chunk(int64_t rest, int32_t blockSize)
+{
+	if (rest <= blockSize)
+		return rest;
+	return rest - blockSize < BLAZER_INDEX_TRAILER_SIZE ? rest - BLAZER_INDEX_TRAILER_SIZE : blockSize;
+}
+
+int64_t blazer_index_size(int64_t entryCount, int32_t blockSize, int32_t blockHeaderSize)
+{
+	int64_t rest = BLAZER_INDEX_HEADER_SIZE + entryCount * BLAZER_INDEX_ENTRY_SIZE + BLAZER_INDEX_TRAILER_SIZE;
+	int64_t size = 0;
+	while (rest > 0)
+	{
+		int64_t chunk = index_chunk(rest, blockSize);
+		size += blockHeaderSize + chunk;
+		rest -= chunk;
+	}
+
+	return size;
+}
+
+int64_t blazer_index_write(const blazer_index_entry* entries, int64_t entryCount, int64_t totalLength, int32_t blockSize, bool includeCrc, unsigned char* out)
+{
+	int32_t blockHeaderSize = includeCrc ? BLOCK_HEADER_CRC_SIZE : BLOCK_HEADER_SIZE;
+	int64_t size = blazer_index_size(entryCount, blockSize, blockHeaderSize);
+	int64_t payloadLength = BLAZER_INDEX_HEADER_SIZE + entryCount * BLAZER_INDEX_ENTRY_SIZE + BLAZER_INDEX_TRAILER_SIZE;
+
+	// payload is written to end of space and then blocks are moved down to their places before it
+	unsigned char* payload = out + size - payloadLength;
+	unsigned char* p = payload;
+	memcpy(p, IndexMagic, 4);
+	write_le32(p + 4, (uint32_t)entryCount);
+	write_le64(p + 8, totalLength);
+	p += BLAZER_INDEX_HEADER_SIZE;
+	for (int64_t i = 0; i < entryCount; i++)
+	{
+		write_le64(p, entries[i].compressedOffset);
+		write_le64(p + 8, entries[i].uncompressedOffset);
+		write_le32(p + 16, entries[i].crc);
+		p += BLAZER_INDEX_ENTRY_SIZE;
+	}
+
+	write_le32(p, (uint32_t)size);
+	memcpy(p + 4, IndexMagic, 4);
+
+	unsigned char* dst = out;
+	int64_t rest = payloadLength;
+	while (rest > 0)
+	{
+		int64_t chunk = index_chunk(rest, blockSize);
+		blazer_move_down(dst + blockHeaderSize, payload, (size_t)chunk);
+		write_le32(dst, BLOCK_TYPE_CONTROL_DATA | ((uint32_t)(chunk - 1) << 8));
+		if (includeCrc)
+			write_le32(dst + 4, crc32c_append(0, dst + blockHeaderSize, (size_t)chunk));
+		dst += blockHeaderSize + chunk;
+		payload += chunk;
+		rest -= chunk;
+	}
+
+	return size;
+}
+
+struct blazer_indexed_file
+{
+	blazer_mapped_file file;
+	blazer_frame_decoder* decoder;
+	int32_t blockSize;
+	// end of data blocks (start of index)
+	int64_t dataEnd;
+	int64_t length;
+	blazer_index_entry* entries;
+	int64_t entryCount;
+	// decompressed blocks
+	unsigned char* scratch;
+};
+
+// reads payload of index blocks between dataEnd and end into allocated buffer, returns NULL if blocks are invalid
+static unsigned char* read_index_payload(blazer_indexed_file* indexed, uint32_t flags, int64_t end, int64_t* payloadLength, int32_t* error)
+{
+	bool includeCrc = (flags & BLAZER_FLAG_INCLUDE_CRC) != 0;
+	int32_t blockHeaderSize = includeCrc ? BLOCK_HEADER_CRC_SIZE : BLOCK_HEADER_SIZE;
+	unsigned char* payload = (unsigned char*)blazer_alloc_zero((size_t)(end - indexed->dataEnd) + 1);
+	if (payload == NULL)
+	{
+		*error = BLAZER_FRAME_ERROR_MEMORY;
+		return NULL;
+	}
+
+	*payloadLength = 0;
+	int64_t pos = indexed->dataEnd;
+	const unsigned char* data = indexed->file.data;
+	while (pos < end)
+	{
+		if (end - pos < blockHeaderSize || data[pos] != BLOCK_TYPE_CONTROL_DATA)
+			break;
+		int64_t length = (read_le32(data + pos) >> 8) + 1;
+		if (length > end - pos - blockHeaderSize)
+			break;
+		if (includeCrc && crc32c_append(0, data + pos + blockHeaderSize, (size_t)length) != read_le32(data + pos + 4))
+		{
+			*error = BLAZER_FRAME_ERROR_CRC;
+			blazer_free(payload);
+			return NULL;
+		}
+
+		memcpy(payload + *payloadLength, data + pos + blockHeaderSize, (size_t)length);
+		*payloadLength += length;
+		pos += blockHeaderSize + length;
+	}
+
+	if (pos != end)
+	{
+		*error = BLAZER_FILE_ERROR_INDEX;
+		blazer_free(payload);
+		return NULL;
+	}
+
+	return payload;
+}
+
+// parses and validates entries of payload
+static int32_t parse_index(blazer_indexed_file* indexed, const unsigned char* payload, int64_t payloadLength)
+{
+	if (payloadLength < BLAZER_INDEX_HEADER_SIZE + BLAZER_INDEX_TRAILER_SIZE || !is_magic(payload))
+		return BLAZER_FILE_ERROR_INDEX;
+
+	int64_t entryCount = read_le32(payload + 4);
+	indexed->length = read_le64(payload + 8);
+	if (payloadLength != BLAZER_INDEX_HEADER_SIZE + entryCount * BLAZER_INDEX_ENTRY_SIZE + BLAZER_INDEX_TRAILER_SIZE || indexed->length < 0 || (entryCount == 0) != (indexed->length == 0))
+		return BLAZER_FILE_ERROR_INDEX;
+
+	indexed->entries = (blazer_index_entry*)blazer_alloc_zero(sizeof(blazer_index_entry) * (size_t)(entryCount + 1));
+	if (indexed->entries == NULL)
+		return BLAZER_FRAME_ERROR_MEMORY;
+
+	const unsigned char* p = payload + BLAZER_INDEX_HEADER_SIZE;
+	int64_t prevCompressed = FILE_HEADER_SIZE - 1;
+	int64_t prevUncompressed = -1;
+	for (int64_t i = 0; i < entryCount; i++)
+	{
+		blazer_index_entry* entry = &indexed->entries[i];
+		entry->compressedOffset = read_le64(p);
+		entry->uncompressedOffset = read_le64(p + 8);
+		entry->crc = read_le32(p + 16);
+		// entries should be in order, first one is start of data
+		if (entry->compressedOffset <= prevCompressed || entry->compressedOffset >= indexed->dataEnd
+			|| entry->uncompressedOffset <= prevUncompressed || entry->uncompressedOffset >= indexed->length
+			|| (i == 0 && entry->uncompressedOffset != 0))
+			return BLAZER_FILE_ERROR_INDEX;
+		prevCompressed = entry->compressedOffset;
+		prevUncompressed = entry->uncompressedOffset;
+		p += BLAZER_INDEX_ENTRY_SIZE;
+	}
+
+	// end of last entry
+	indexed->entries[entryCount].uncompressedOffset = indexed->length;
+	indexed->entryCount = entryCount;
+	return 0;
+}
+
+static int32_t open_index(blazer_indexed_file* indexed)
+{
+	const unsigned char* data = indexed->file.data;
+	int64_t end = indexed->file.length;
+	if (end < FILE_HEADER_SIZE || data[0] != 'b' || data[1] != 'L' || data[2] != 'z' || data[3] != 0x01)
+		return BLAZER_FRAME_ERROR_HEADER;
+
+	uint32_t flags = read_le32(data + 4);
+	// blocks are decoded from entries, so decoder does not read header
+	indexed->decoder = blazer_frame_decoder_create(flags & ~(uint32_t)BLAZER_FLAG_INCLUDE_HEADER);
+	if (indexed->decoder == NULL)
+		return BLAZER_FRAME_ERROR_FLAGS;
+
+	if ((flags & BLAZER_FLAG_INCLUDE_FOOTER) != 0)
+	{
+		if (end < FILE_HEADER_SIZE + FOOTER_SIZE || data[end - 4] != 0xff || data[end - 3] != 'Z' || data[end - 2] != 'l' || data[end - 1] != 'B')
+			return BLAZER_FRAME_ERROR_TRUNCATED;
+		end -= FOOTER_SIZE;
+	}
+
+	if (end < FILE_HEADER_SIZE + BLAZER_INDEX_TRAILER_SIZE || !is_magic(data + end - 4))
+		return BLAZER_FILE_ERROR_INDEX;
+	int64_t indexSize = read_le32(data + end - 8);
+	if (indexSize > end - FILE_HEADER_SIZE)
+		return BLAZER_FILE_ERROR_INDEX;
+
+	indexed->blockSize = 512 << (flags & BLAZER_FLAG_BLOCK_SIZE_MASK);
+	indexed->dataEnd = end - indexSize;
+	indexed->scratch = (unsigned char*)blazer_alloc_zero((size_t)indexed->blockSize);
+	if (indexed->scratch == NULL)
+		return BLAZER_FRAME_ERROR_MEMORY;
+
+	int32_t error = 0;
+	int64_t payloadLength;
+	unsigned char* payload = read_index_payload(indexed, flags, end, &payloadLength, &error);
+	if (payload == NULL)
+		return error;
+
+	error = parse_index(indexed, payload, payloadLength);
+	blazer_free(payload);
+	return error;
+}
+
+extern "C" BLAZER_API blazer_indexed_file* blazer_indexed_file_open(const char* path, int32_t* error)
+{
+	blazer_indexed_file* indexed = (blazer_indexed_file*)blazer_alloc_zero(sizeof(blazer_indexed_file));
+	if (indexed == NULL)
+	{
+		*error = BLAZER_FRAME_ERROR_MEMORY;
+		return NULL;
+	}
+
+	if (!blazer_map_file(&indexed->file, path))
+	{
+		blazer_free(indexed);
+		*error = BLAZER_FILE_ERROR_INPUT;
+		return NULL;
+	}
+
+	*error = open_index(indexed);
+	if (*error != 0)
+	{
+		blazer_indexed_file_close(indexed);
+		return NULL;
+	}
+
+	return indexed;
+}
+
+extern "C" BLAZER_API int64_t blazer_indexed_file_length(const blazer_indexed_file* file)
+{
+	return file->length;
+}
+
+// returns last entry, which starts before or at offset
+static int64_t find_entry(const blazer_indexed_file* file, int64_t offset)
+{
+	int64_t lo = 0;
+	int64_t hi = file->entryCount - 1;
+	while (lo < hi)
+	{
+		int64_t mid = (lo + hi + 1) / 2;
+		if (file->entries[mid].uncompressedOffset <= offset)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+
+	return lo;
+}
+
+extern "C" BLAZER_API int64_t blazer_indexed_file_read(blazer_indexed_file* file, int64_t offset, unsigned char* out, int64_t length)
+{
+	if (offset < 0 || length < 0)
+		return BLAZER_FILE_ERROR_ARGUMENT;
+	if (offset >= file->length)
+		return 0;
+	if (length > file->length - offset)
+		length = file->length - offset;
+
+	int64_t entryIdx = find_entry(file, offset);
+	blazer_frame_decoder_reset(file->decoder);
+	int64_t inPos = file->entries[entryIdx].compressedOffset;
+	int64_t pos = file->entries[entryIdx].uncompressedOffset;
+	int64_t end = offset + length;
+	uint32_t crc = 0;
+	while (pos < end)
+	{
+		size_t inLength = (size_t)(file->dataEnd - inPos);
+		size_t outLength = (size_t)file->blockSize;
+		int32_t res = blazer_frame_decode(file->decoder, file->file.data + inPos, &inLength, file->scratch, &outLength);
+		if (res < 0)
+			return res;
+		inPos += inLength;
+		if (outLength == 0)
+		{
+			// control blocks have no data, but end of data blocks is an error
+			if (inLength == 0)
+				return BLAZER_FRAME_ERROR_TRUNCATED;
+			continue;
+		}
+
+		int64_t from = pos > offset ? pos : offset;
+		int64_t to = MIN(pos + (int64_t)outLength, end);
+		if (from < to)
+			memcpy(out + (from - offset), file->scratch + (from - pos), (size_t)(to - from));
+
+		// entries are checked only if they are decompressed completely
+		int64_t chunkPos = 0;
+		while (chunkPos < (int64_t)outLength)
+		{
+			if (entryIdx == file->entryCount)
+				return BLAZER_FILE_ERROR_INDEX;
+			int64_t entryEnd = file->entries[entryIdx + 1].uncompressedOffset;
+			int64_t cnt = MIN((int64_t)outLength - chunkPos, entryEnd - (pos + chunkPos));
+			crc = crc32c_append(crc, file->scratch + chunkPos, (size_t)cnt);
+			chunkPos += cnt;
+			if (pos + chunkPos == entryEnd)
+			{
+				if (crc != file->entries[entryIdx].crc)
+					return BLAZER_FRAME_ERROR_CRC;
+				entryIdx++;
+				crc = 0;
+			}
+		}
+
+		pos += outLength;
+	}
+
+	return length;
+}
+
+extern "C" BLAZER_API void blazer_indexed_file_close(blazer_indexed_file* file)
+{
+	if (file == NULL)
+		return;
+	blazer_frame_decoder_destroy(file->decoder);
+	if (file->entries != NULL)
+		blazer_free(file->entries);
+	if (file->scratch != NULL)
+		blazer_free(file->scratch);
+	blazer_unmap_file(&file->file);
+	blazer_free(file);
+}
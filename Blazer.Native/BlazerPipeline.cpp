@@ -0,0 +1,509 @@
+#include "stdafx.h"
+#include "Blazer.h"
+#include "FileMap.h"
+#include "IoRing.h"
+#include "Threading.h"
+
+#ifdef BLAZER_IO_URING
+#include <errno.h>
+#endif
+
+// pipeline of file compression: reads, compression of independent blocks by worker threads and writes are overlapped.
+// Block i uses slot i % depth, so slot is free for next read only after its block is written
+
+#define MAX_THREADS 64
+#define MAX_QUEUE_DEPTH 1024
+
+enum slot_state
+{
+	SLOT_FREE,
+	SLOT_READING,
+	SLOT_READ,
+	SLOT_COMPRESSING,
+	SLOT_COMPRESSED,
+	SLOT_WRITING
+};
+
+struct pipeline_slot
+{
+	unsigned char* in;
+	unsigned char* out;
+	int64_t inLength;
+	int64_t outLength;
+	int64_t outOffset;
+	slot_state state;
+	// transferred bytes of current io_uring request, it can be completed partially
+	int64_t done;
+	int64_t submitTime;
+#ifdef BLAZER_IO_URING
+	struct iovec iov;
+#endif
+};
+
+struct pipeline
+{
+	blazer_mutex mutex;
+	// signaled on every change of slot state and on error
+	blazer_cond cond;
+	pipeline_slot* slots;
+	int32_t depth;
+	uint32_t flags;
+	int64_t blockSize;
+	int64_t blockCount;
+	int64_t inLength;
+	// size of out buffer of slot
+	int64_t outBound;
+	blazer_file in;
+	blazer_file out;
+	// next blocks of stages
+	int64_t nextRead;
+	int64_t nextCompress;
+	int64_t nextWrite;
+	int64_t writtenCount;
+	int64_t outPos;
+	int64_t error;
+	blazer_pipeline_stats stats;
+};
+
+static BLAZER_INLINE pipeline_slot* slot_of(pipeline* p, int64_t block)
+{
+	return &p->slots[block % p->depth];
+}
+
+static BLAZER_INLINE int64_t block_length(pipeline* p, int64_t block)
+{
+	int64_t rest = p->inLength - block * p->blockSize;
+	return rest < p->blockSize ? rest : p->blockSize;
+}
+
+// stops all stages, mutex should be locked
+static void set_error(pipeline* p, int64_t error)
+{
+	if (p->error == 0)
+		p->error = error;
+	blazer_cond_broadcast(&p->cond);
+}
+
+static void stall_begin(blazer_pipeline_stage_stats* stage, int64_t* stallStart)
+{
+	if (*stallStart != 0)
+		return;
+	*stallStart = blazer_time_ns();
+	stage->stalls++;
+}
+
+static void stall_end(blazer_pipeline_stage_stats* stage, int64_t* stallStart)
+{
+	if (*stallStart == 0)
+		return;
+	stage->stallNanoseconds += blazer_time_ns() - *stallStart;
+	*stallStart = 0;
+}
+
+static void compress_worker(void* arg)
+{
+	pipeline* p = (pipeline*)arg;
+	// header and footer are written by pipeline, so encoder writes only blocks
+	blazer_frame_encoder* encoder = blazer_frame_encoder_create(p->flags & ~(uint32_t)(BLAZER_FLAG_INCLUDE_HEADER | BLAZER_FLAG_INCLUDE_FOOTER), BLAZER_ALGORITHM_BLOCK, 0);
+	int64_t stallStart = 0;
+	blazer_mutex_lock(&p->mutex);
+	if (encoder == NULL)
+		set_error(p, BLAZER_FRAME_ERROR_MEMORY);
+
+	while (p->error == 0 && p->nextCompress < p->blockCount)
+	{
+		pipeline_slot* slot = slot_of(p, p->nextCompress);
+		if (slot->state != SLOT_READ)
+		{
+			stall_begin(&p->stats.compress, &stallStart);
+			blazer_cond_wait(&p->cond, &p->mutex);
+			continue;
+		}
+
+		stall_end(&p->stats.compress, &stallStart);
+		p->nextCompress++;
+		slot->state = SLOT_COMPRESSING;
+		blazer_mutex_unlock(&p->mutex);
+
+		int64_t start = blazer_time_ns();
+		int64_t written = blazer_frame_encoder_write(encoder, slot->in, slot->inLength, slot->out, p->outBound);
+		// last block is shorter than block size and is kept by encoder until finish
+		if (written >= 0 && slot->inLength < p->blockSize)
+		{
+			int64_t finished = blazer_frame_encoder_finish(encoder, slot->out + written, p->outBound - written);
+			written = finished >= 0 ? written + finished : finished;
+		}
+		int64_t time = blazer_time_ns() - start;
+
+		blazer_mutex_lock(&p->mutex);
+		// buffer has space of bound, so encoder fails only if memory for compression of block cannot be allocated
+		if (written < 0)
+		{
+			set_error(p, BLAZER_FRAME_ERROR_MEMORY);
+			break;
+		}
+
+		slot->outLength = written;
+		slot->state = SLOT_COMPRESSED;
+		p->stats.compress.bytes += slot->inLength;
+		p->stats.compress.busyNanoseconds += time;
+		blazer_cond_broadcast(&p->cond);
+	}
+
+	stall_end(&p->stats.compress, &stallStart);
+	blazer_mutex_unlock(&p->mutex);
+	blazer_frame_encoder_destroy(encoder);
+}
+
+static void read_worker(void* arg)
+{
+	pipeline* p = (pipeline*)arg;
+	int64_t stallStart = 0;
+	blazer_mutex_lock(&p->mutex);
+	while (p->error == 0 && p->nextRead < p->blockCount)
+	{
+		int64_t block = p->nextRead;
+		pipeline_slot* slot = slot_of(p, block);
+		if (slot->state != SLOT_FREE)
+		{
+			stall_begin(&p->stats.read, &stallStart);
+			blazer_cond_wait(&p->cond, &p->mutex);
+			continue;
+		}
+
+		stall_end(&p->stats.read, &stallStart);
+		p->nextRead++;
+		slot->state = SLOT_READING;
+		slot->inLength = block_length(p, block);
+		blazer_mutex_unlock(&p->mutex);
+
+		int64_t start = blazer_time_ns();
+		bool ok = blazer_file_read_at(&p->in, slot->in, slot->inLength, block * p->blockSize);
+		int64_t time = blazer_time_ns() - start;
+
+		blazer_mutex_lock(&p->mutex);
+		if (!ok)
+		{
+			set_error(p, BLAZER_FILE_ERROR_INPUT);
+			break;
+		}
+
+		slot->state = SLOT_READ;
+		p->stats.read.bytes += slot->inLength;
+		p->stats.read.busyNanoseconds += time;
+		blazer_cond_broadcast(&p->cond);
+	}
+
+	stall_end(&p->stats.read, &stallStart);
+	blazer_mutex_unlock(&p->mutex);
+}
+
+// writes compressed blocks in order by current thread
+static void write_blocks(pipeline* p)
+{
+	int64_t stallStart = 0;
+	blazer_mutex_lock(&p->mutex);
+	while (p->error == 0 && p->nextWrite < p->blockCount)
+	{
+		pipeline_slot* slot = slot_of(p, p->nextWrite);
+		if (slot->state != SLOT_COMPRESSED)
+		{
+			stall_begin(&p->stats.write, &stallStart);
+			blazer_cond_wait(&p->cond, &p->mutex);
+			continue;
+		}
+
+		stall_end(&p->stats.write, &stallStart);
+		p->nextWrite++;
+		slot->state = SLOT_WRITING;
+		slot->outOffset = p->outPos;
+		p->outPos += slot->outLength;
+		blazer_mutex_unlock(&p->mutex);
+
+		int64_t start = blazer_time_ns();
+		bool ok = blazer_file_write_at(&p->out, slot->out, slot->outLength, slot->outOffset);
+		int64_t time = blazer_time_ns() - start;
+
+		blazer_mutex_lock(&p->mutex);
+		if (!ok)
+		{
+			set_error(p, BLAZER_FILE_ERROR_OUTPUT);
+			break;
+		}
+
+		slot->state = SLOT_FREE;
+		p->writtenCount++;
+		p->stats.write.bytes += slot->outLength;
+		p->stats.write.busyNanoseconds += time;
+		blazer_cond_broadcast(&p->cond);
+	}
+
+	stall_end(&p->stats.write, &stallStart);
+	blazer_mutex_unlock(&p->mutex);
+}
+
+#ifdef BLAZER_IO_URING
+
+// prepares read or rest of read (write) of slot, request is identified by block and direction
+static void prepare_transfer(pipeline* p, blazer_io_ring* ring, int64_t block, bool write)
+{
+	pipeline_slot* slot = slot_of(p, block);
+	unsigned char* buffer = write ? slot->out : slot->in;
+	int64_t length = write ? slot->outLength : slot->inLength;
+	int64_t offset = write ? slot->outOffset : block * p->blockSize;
+	slot->iov.iov_base = buffer + slot->done;
+	slot->iov.iov_len = (size_t)(length - slot->done);
+	// every slot has at most one request, so queue with two entries per slot cannot be full
+	if (!blazer_io_ring_prepare(ring, write, write ? p->out.fd : p->in.fd, &slot->iov, offset + slot->done, (uint64_t)block * 2 + (write ? 1 : 0)))
+		set_error(p, write ? BLAZER_FILE_ERROR_OUTPUT : BLAZER_FILE_ERROR_INPUT);
+}
+
+// handles completion of request, returns true if request is submitted again for rest of data
+static bool complete_transfer(pipeline* p, blazer_io_ring* ring, uint64_t userData, int32_t result)
+{
+	int64_t block = (int64_t)(userData >> 1);
+	bool write = (userData & 1) != 0;
+	pipeline_slot* slot = slot_of(p, block);
+	int64_t length = write ? slot->outLength : slot->inLength;
+	if (result == -EINTR || result == -EAGAIN)
+		result = 0;
+	else if (result <= 0)
+		set_error(p, write ? BLAZER_FILE_ERROR_OUTPUT : BLAZER_FILE_ERROR_INPUT);
+
+	slot->done += result > 0 ? result : 0;
+	if (p->error != 0)
+		return false;
+	if (slot->done < length)
+	{
+		prepare_transfer(p, ring, block, write);
+		return p->error == 0;
+	}
+
+	blazer_pipeline_stage_stats* stage = write ? &p->stats.write : &p->stats.read;
+	stage->bytes += length;
+	stage->busyNanoseconds += blazer_time_ns() - slot->submitTime;
+	if (write)
+	{
+		slot->state = SLOT_FREE;
+		p->writtenCount++;
+	}
+	else
+	{
+		slot->state = SLOT_READ;
+	}
+
+	blazer_cond_broadcast(&p->cond);
+	return false;
+}
+
+// reads and writes blocks through io_uring by current thread, compression is done by workers
+static void ring_blocks(pipeline* p, blazer_io_ring* ring)
+{
+	int32_t inFlight = 0;
+	int32_t writesInFlight = 0;
+	int64_t readStall = 0;
+	int64_t writeStall = 0;
+	blazer_mutex_lock(&p->mutex);
+	for (;;)
+	{
+		while (p->error == 0 && p->nextRead < p->blockCount && slot_of(p, p->nextRead)->state == SLOT_FREE)
+		{
+			stall_end(&p->stats.read, &readStall);
+			pipeline_slot* slot = slot_of(p, p->nextRead);
+			slot->state = SLOT_READING;
+			slot->inLength = block_length(p, p->nextRead);
+			slot->done = 0;
+			slot->submitTime = blazer_time_ns();
+			prepare_transfer(p, ring, p->nextRead++, false);
+			inFlight++;
+		}
+
+		// all slots are in flight
+		if (p->error == 0 && p->nextRead < p->blockCount)
+			stall_begin(&p->stats.read, &readStall);
+
+		while (p->error == 0 && p->nextWrite < p->blockCount && slot_of(p, p->nextWrite)->state == SLOT_COMPRESSED)
+		{
+			stall_end(&p->stats.write, &writeStall);
+			pipeline_slot* slot = slot_of(p, p->nextWrite);
+			slot->state = SLOT_WRITING;
+			slot->outOffset = p->outPos;
+			p->outPos += slot->outLength;
+			slot->done = 0;
+			slot->submitTime = blazer_time_ns();
+			prepare_transfer(p, ring, p->nextWrite++, true);
+			inFlight++;
+			writesInFlight++;
+		}
+
+		if (p->error == 0 && p->nextWrite < p->blockCount && writesInFlight == 0)
+			stall_begin(&p->stats.write, &writeStall);
+
+		if (inFlight == 0)
+		{
+			if (p->error != 0 || p->writtenCount == p->blockCount)
+				break;
+			// waiting for compression
+			blazer_cond_wait(&p->cond, &p->mutex);
+			continue;
+		}
+
+		blazer_mutex_unlock(&p->mutex);
+		bool ok = blazer_io_ring_submit(ring, 1);
+		blazer_mutex_lock(&p->mutex);
+		if (!ok)
+		{
+			// requests cannot be completed, buffers are released only after ring is closed
+			set_error(p, BLAZER_FILE_ERROR_OUTPUT);
+			break;
+		}
+
+		uint64_t userData;
+		int32_t result;
+		while (blazer_io_ring_complete(ring, &userData, &result))
+		{
+			if (!complete_transfer(p, ring, userData, result))
+			{
+				inFlight--;
+				if ((userData & 1) != 0)
+					writesInFlight--;
+			}
+		}
+	}
+
+	stall_end(&p->stats.read, &readStall);
+	stall_end(&p->stats.write, &writeStall);
+	blazer_mutex_unlock(&p->mutex);
+}
+
+#endif
+
+static int64_t run_pipeline(pipeline* p, blazer_frame_encoder* encoder, int32_t threadCount, int32_t ioMode)
+{
+	// header and footer are written by encoder of whole stream through buffer of first slot
+	int64_t headerLength = blazer_frame_encoder_flush(encoder, p->slots[0].out, p->outBound);
+	if (!blazer_file_write_at(&p->out, p->slots[0].out, headerLength, 0))
+		return BLAZER_FILE_ERROR_OUTPUT;
+	p->outPos = headerLength;
+
+	blazer_thread threads[MAX_THREADS + 1];
+	int32_t started = 0;
+	while (started < threadCount && blazer_thread_start(&threads[started], compress_worker, p))
+		started++;
+	if (started == 0)
+		return BLAZER_FRAME_ERROR_MEMORY;
+
+	blazer_io_ring ring;
+	if (ioMode == BLAZER_PIPELINE_IO_AUTO && blazer_io_ring_setup(&ring, (uint32_t)p->depth * 2))
+	{
+		p->stats.ioRing = 1;
+#ifdef BLAZER_IO_URING
+		ring_blocks(p, &ring);
+#endif
+		blazer_io_ring_destroy(&ring);
+	}
+	else if (blazer_thread_start(&threads[started], read_worker, p))
+	{
+		write_blocks(p);
+		started++;
+	}
+	else
+	{
+		blazer_mutex_lock(&p->mutex);
+		set_error(p, BLAZER_FRAME_ERROR_MEMORY);
+		blazer_mutex_unlock(&p->mutex);
+	}
+
+	for (int32_t i = 0; i < started; i++)
+		blazer_thread_join(&threads[i]);
+	if (p->error != 0)
+		return p->error;
+
+	int64_t footerLength = blazer_frame_encoder_finish(encoder, p->slots[0].out, p->outBound);
+	if (footerLength < 0)
+		return BLAZER_FRAME_ERROR_MEMORY;
+	if (!blazer_file_write_at(&p->out, p->slots[0].out, footerLength, p->outPos))
+		return BLAZER_FILE_ERROR_OUTPUT;
+	return p->outPos + footerLength;
+}
+
+extern "C" BLAZER_API int64_t blazer_file_compress_pipelined(const char* inPath, const char* outPath, uint32_t flags, int32_t threadCount, int32_t queueDepth, int32_t ioMode, blazer_pipeline_stats* stats)
+{
+	int64_t startTime = blazer_time_ns();
+	blazer_frame_encoder* encoder = blazer_frame_encoder_create(flags, BLAZER_ALGORITHM_BLOCK, 0);
+	if (encoder == NULL)
+		return BLAZER_FILE_ERROR_ARGUMENT;
+
+	if (threadCount <= 0)
+		threadCount = blazer_cpu_count();
+	if (threadCount > MAX_THREADS)
+		threadCount = MAX_THREADS;
+	if (queueDepth <= 0)
+		queueDepth = threadCount * 2 + 2;
+	if (queueDepth > MAX_QUEUE_DEPTH)
+		queueDepth = MAX_QUEUE_DEPTH;
+
+	pipeline* p = (pipeline*)blazer_alloc_zero(sizeof(pipeline));
+	if (p == NULL)
+	{
+		blazer_frame_encoder_destroy(encoder);
+		return BLAZER_FRAME_ERROR_MEMORY;
+	}
+
+	int64_t res = 0;
+	bool isInOpened = blazer_file_open_read(&p->in, inPath, &p->inLength);
+	bool isOutOpened = isInOpened && blazer_file_open_write(&p->out, outPath);
+	if (!isInOpened)
+		res = BLAZER_FILE_ERROR_INPUT;
+	else if (!isOutOpened)
+		res = BLAZER_FILE_ERROR_OUTPUT;
+
+	p->flags = flags;
+	p->blockSize = 512 << (flags & BLAZER_FLAG_BLOCK_SIZE_MASK);
+	p->blockCount = (p->inLength + p->blockSize - 1) / p->blockSize;
+	p->outBound = blazer_frame_encoder_bound(encoder, p->blockSize);
+	// there is no sense in slots without blocks
+	p->depth = p->blockCount < queueDepth ? (p->blockCount > 0 ? (int32_t)p->blockCount : 1) : queueDepth;
+	if (res == 0)
+	{
+		p->slots = (pipeline_slot*)blazer_alloc_zero(sizeof(pipeline_slot) * p->depth);
+		for (int32_t i = 0; p->slots != NULL && i < p->depth; i++)
+		{
+			p->slots[i].in = (unsigned char*)blazer_alloc_zero((size_t)(p->blockSize + p->outBound));
+			if (p->slots[i].in == NULL)
+				break;
+			p->slots[i].out = p->slots[i].in + p->blockSize;
+		}
+
+		if (p->slots == NULL || p->slots[p->depth - 1].in == NULL)
+			res = BLAZER_FRAME_ERROR_MEMORY;
+	}
+
+	if (res == 0)
+	{
+		blazer_mutex_init(&p->mutex);
+		blazer_cond_init(&p->cond);
+		res = run_pipeline(p, encoder, threadCount, ioMode);
+		blazer_cond_destroy(&p->cond);
+		blazer_mutex_destroy(&p->mutex);
+	}
+
+	p->stats.elapsedNanoseconds = blazer_time_ns() - startTime;
+	if (stats != NULL)
+		*stats = p->stats;
+
+	if (p->slots != NULL)
+	{
+		for (int32_t i = 0; i < p->depth && p->slots[i].in != NULL; i++)
+			blazer_free(p->slots[i].in);
+		blazer_free(p->slots);
+	}
+
+	if (isOutOpened)
+		blazer_file_close(&p->out);
+	if (isInOpened)
+		blazer_file_close(&p->in);
+	blazer_free(p);
+	blazer_frame_encoder_destroy(encoder);
+	return res;
+}
@@ -0,0 +1,108 @@
+#include "stdafx.h"
+#include "Blazer.h"
+#include "Probe.h"
+
+// blocks up to this length are scanned fully, larger ones by segments spread evenly over block
+#define PROBE_SEGMENT_COUNT 16
+#define PROBE_SEGMENT_LEN 512
+#define PROBE_FULL_LEN (PROBE_SEGMENT_COUNT * PROBE_SEGMENT_LEN)
+// step of positions added to table between segments, segment is longer than it, so long repeats of data between
+// segments are found by some position of segment. Step of large blocks is increased to add at most PROBE_MAX_INSERTS
+// positions, so table keeps positions of far repeats too
+#define PROBE_STRIDE 8
+#define PROBE_MAX_INSERTS (1 << 16)
+#define PROBE_SMALL_INSERTS (1 << 14)
+#define PROBE_SMALL_HASH_BITS 12
+
+#define MUL 1527631329
+
+static BLAZER_INLINE uint32_t read32(const unsigned char* p)
+{
+	uint32_t v;
+	memcpy(&v, p, 4);
+	return v;
+}
+
+static BLAZER_INLINE uint32_t probe_hash(uint32_t seq, int32_t hashBits)
+{
+	return (seq * MUL) >> (32 - hashBits);
+}
+
+// adds every stride position of [start, end) to table
+static BLAZER_INLINE void probe_insert(const unsigned char* data, int32_t start, int32_t end, int32_t stride, int32_t* hashArr, int32_t hashBits)
+{
+	for (int32_t idx = start; idx < end; idx += stride)
+		hashArr[probe_hash(read32(data + idx), hashBits)] = idx + 1;
+}
+
+// searches every position of [start, end) in table and adds it, returns count of bytes covered by repeats
+static BLAZER_INLINE int32_t probe_segment(const unsigned char* data, int32_t start, int32_t end, int32_t* hashArr, int32_t hashBits)
+{
+	int32_t covered = 0;
+	int32_t idx = start;
+	while (idx < end)
+	{
+		uint32_t seq = read32(data + idx);
+		uint32_t hashKey = probe_hash(seq, hashBits);
+		// positions are stored plus one, so zero is empty entry
+		int32_t prev = hashArr[hashKey] - 1;
+		hashArr[hashKey] = idx + 1;
+		if (prev >= 0 && read32(data + prev) == seq)
+		{
+			// end of segment is at least 3 bytes before end of data
+			int32_t len = 4;
+			while (idx + len < end && data[prev + len] == data[idx + len])
+				len++;
+			covered += len;
+			idx += len;
+			continue;
+		}
+
+		idx++;
+	}
+
+	return covered < end - start ? covered : end - start;
+}
+
+int32_t blazer_probe_repeats(const unsigned char* data, int32_t dataOffset, int32_t dataLength, int32_t* hashArr)
+{
+	// last positions have less than 4 bytes
+	int32_t positionsEnd = dataLength - 3;
+	if (positionsEnd <= dataOffset)
+		return 0;
+
+	int32_t stride = PROBE_STRIDE;
+	while (stride < PROBE_SEGMENT_LEN / 4 && positionsEnd / stride > PROBE_MAX_INSERTS)
+		stride *= 2;
+	// small data needs only part of table, which fits into cache of processor
+	int32_t hashBits = positionsEnd / stride > PROBE_SMALL_INSERTS ? BLAZER_PROBE_HASH_BITS : PROBE_SMALL_HASH_BITS;
+
+	memset(hashArr, 0, sizeof(int32_t) << hashBits);
+	probe_insert(data, 0, dataOffset, stride, hashArr, hashBits);
+	int32_t length = positionsEnd - dataOffset;
+	if (length <= PROBE_FULL_LEN)
+		return (int32_t)((int64_t)probe_segment(data, dataOffset, positionsEnd, hashArr, hashBits) * 1000 / length);
+
+	int64_t step = (int64_t)(length - PROBE_SEGMENT_LEN) / (PROBE_SEGMENT_COUNT - 1);
+	int32_t covered = 0;
+	int32_t pos = dataOffset;
+	for (int32_t i = 0; i < PROBE_SEGMENT_COUNT; i++)
+	{
+		int32_t start = dataOffset + (int32_t)(step * i);
+		probe_insert(data, pos, start, stride, hashArr, hashBits);
+		covered += probe_segment(data, start, start + PROBE_SEGMENT_LEN, hashArr, hashBits);
+		pos = start + PROBE_SEGMENT_LEN;
+	}
+
+	return (int32_t)((int64_t)covered * 1000 / PROBE_FULL_LEN);
+}
+
+extern "C" BLAZER_API int32_t blazer_probe_block(const unsigned char* data, int32_t length)
+{
+	int32_t* hashArr = (int32_t*)blazer_alloc_zero(sizeof(int32_t) * BLAZER_PROBE_HASH_SIZE);
+	if (hashArr == 0)
+		return -1;
+	int32_t res = blazer_probe_repeats(data, 0, length, hashArr);
+	blazer_free(hashArr);
+	return res;
+}
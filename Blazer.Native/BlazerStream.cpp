@@ -1,18 +1,38 @@
 #include "stdafx.h"
+#include "Blazer.h"
+#include "WideCopy.h"
+#include "Match.h"
+#include "StreamHigh.h"
+#include "Stream.h"
 
 #define HASH_TABLE_BITS  16
-#define HASH_TABLE_LEN  ((1 << HASH_TABLE_BITS) - 1)
 #define MAX_BACK_REF  ((1 << 16) + 256)
 #define MIN_SEQ_LEN  4
+
+// matches longer than this count of bytes are added to hash sparsely (if BLAZER_STREAM_DENSE_HASH is not set)
+#define SPARSE_HASH_MIN 32
+#define SPARSE_HASH_STEP 4
+#define SPARSE_HASH_TAIL 4
+// with BLAZER_STREAM_LAZY next position is checked only for matches shorter than this count of bytes
+#define LAZY_SEQ_MAX 32
 // #define MUL  0x0C5AE896A
 
 // carefully selected random number
 #define MUL 1527631329
 
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
-#define CALC_HASH(v) ((v) * MUL) >> (32 - HASH_TABLE_BITS)
+#define CALC_HASH(v) (((v) * MUL) >> hashShift)
 
-inline unsigned char* copy_memory(unsigned char* src, unsigned char* dst, __int32 count)
+// positions in hash table are global offsets modulo 2^32, so distance to stored position is correct after overflow
+// of global offset and table never needs rebasing. Returns back reference or 0 if stored position cannot be used:
+// it is empty, too far, out of buffer or is same as current
+static BLAZER_INLINE int32_t stored_back_ref(int32_t stored, uint32_t pos, int32_t idxIn)
+{
+	uint32_t backRef = pos - (uint32_t)stored;
+	return backRef < MAX_BACK_REF && (int32_t)backRef <= idxIn - 3 ? (int32_t)backRef : 0;
+}
+
+static BLAZER_INLINE unsigned char* copy_memory(unsigned char* src, unsigned char* dst, int32_t count)
 {
 	/*while (count > 0 && ((int)src & 7) != 0)
 	{
@@ -22,7 +42,7 @@ inline unsigned char* copy_memory(unsigned char* src, unsigned char* dst, __int3
 
 	while (count > 0)
 	{
-		*(int*)dst = *(int*)src;
+		blazer_copy4(dst, src);
 		dst += sizeof(int);
 		src += sizeof(int);
 		count -= sizeof(int);
@@ -38,23 +58,7 @@ inline unsigned char* copy_memory(unsigned char* src, unsigned char* dst, __int3
 	return dst;
 }
 
-inline unsigned char* copy_memory4(unsigned char* src, unsigned char* dst, __int32 count)
-{
-	while (count > 0)
-	{
-		*(__int32*)dst = *(__int32*)src;
-		dst += sizeof(__int32);
-		src += sizeof(__int32);
-		count -= sizeof(__int32);
-	}
-	
-	dst += count;
-
-	return dst;
-}
-
-
-int __inline write_len(unsigned char* bufferOut, int c)
+static BLAZER_INLINE int write_len(unsigned char* bufferOut, int c)
 {
 	if (c < 253) 
 	{
@@ -71,23 +75,124 @@ int __inline write_len(unsigned char* bufferOut, int c)
 	{
 		*(bufferOut) = 254;
 		c -= 253 + 256;
-		*((unsigned __int16*)(bufferOut + 1)) = c;
+		*((uint16_t*)(bufferOut + 1)) = c;
 		return 3;
 	}
 // 	else
 	{
 		*(bufferOut) = 255;
 		c -= 253 + (256 * 256);
-		*((unsigned __int32*)(bufferOut + 1)) = c;
+		*((uint32_t*)(bufferOut + 1)) = c;
 		return 5;
 	}
 }
 
-extern "C" __declspec(dllexport) __int32 blazer_stream_compress_block(unsigned char* bufferIn, __int32 bufferInOffset, __int32 bufferInLength, __int32 bufferInShift, unsigned char* bufferOut, __int32 bufferOutOffset, __int32* hashArr)
+// reads 4 bytes in same order as they are shifted into mulEl
+static BLAZER_INLINE uint32_t read_be32(const unsigned char* p)
 {
+	return (uint32_t)((p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]);
+}
+
+struct stream_level
+{
+	int32_t hashBits;
+	int32_t flags;
+	// parameters of high encoder, 0 for fast encoder
+	int32_t maxDepth;
+	int32_t lazyDepth;
+	int32_t niceLen;
+};
+
+// index is level - BLAZER_STREAM_LEVEL_MIN
+static const stream_level _levels[] = {
+	{ 12, 0, 0, 0, 0 },
+	{ 14, 0, 0, 0, 0 },
+	{ HASH_TABLE_BITS, 0, 0, 0, 0 },
+	{ HASH_TABLE_BITS, BLAZER_STREAM_DENSE_HASH, 0, 0, 0 },
+	{ 18, BLAZER_STREAM_DENSE_HASH, 0, 0, 0 },
+	{ 0, 0, 8, 1, 64 },
+	{ 0, 0, 32, 1, 128 },
+	{ 0, 0, 64, 1, 256 },
+	{ 0, 0, 256, 2, 1024 },
+};
+
+static int32_t stream_compress(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, int32_t bufferInShift, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, int32_t hashBits, int32_t flags, blazer_crc_track* inTrack, blazer_crc_track* outTrack);
+
+extern "C" BLAZER_API int32_t blazer_stream_compress_block(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, int32_t bufferInShift, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr)
+{
+	return stream_compress(bufferIn, bufferInOffset, bufferInLength, bufferInShift, bufferOut, bufferOutOffset, hashArr, HASH_TABLE_BITS, 0, 0, 0);
+}
+
+extern "C" BLAZER_API int32_t blazer_stream_compress_block_ex(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, int32_t bufferInShift, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, int32_t flags)
+{
+	return stream_compress(bufferIn, bufferInOffset, bufferInLength, bufferInShift, bufferOut, bufferOutOffset, hashArr, HASH_TABLE_BITS, flags, 0, 0);
+}
+
+extern "C" BLAZER_API int32_t blazer_stream_hash_size(int32_t level)
+{
+	if (level < BLAZER_STREAM_LEVEL_MIN || level > BLAZER_STREAM_LEVEL_MAX)
+		return 0;
+	const stream_level* l = &_levels[level - BLAZER_STREAM_LEVEL_MIN];
+	return l->maxDepth > 0 ? BLAZER_HIGH_HASH_SIZE : 1 << l->hashBits;
+}
+
+extern "C" BLAZER_API int32_t blazer_stream_compress_block_level(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, int32_t bufferInShift, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, int32_t level)
+{
+	return blazer_stream_compress_track(bufferIn, bufferInOffset, bufferInLength, bufferInShift, bufferOut, bufferOutOffset, hashArr, level, 0, 0);
+}
+
+int32_t blazer_stream_compress_track(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, int32_t bufferInShift, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, int32_t level, blazer_crc_track* inTrack, blazer_crc_track* outTrack)
+{
+	if (level < BLAZER_STREAM_LEVEL_MIN || level > BLAZER_STREAM_LEVEL_MAX)
+		return -1;
+	const stream_level* l = &_levels[level - BLAZER_STREAM_LEVEL_MIN];
+	// high levels are limited by search of matches, not by memory, so crc is calculated after compression
+	if (l->maxDepth > 0)
+		return blazer_stream_compress_high(bufferIn, bufferInOffset, bufferInLength, bufferInShift, bufferOut, bufferOutOffset, hashArr, l->maxDepth, l->lazyDepth, l->niceLen);
+	return stream_compress(bufferIn, bufferInOffset, bufferInLength, bufferInShift, bufferOut, bufferOutOffset, hashArr, l->hashBits, l->flags, inTrack, outTrack);
+}
+
+extern "C" BLAZER_API int32_t blazer_stream_compress_block_crc(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, int32_t bufferInShift, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, int32_t level, uint32_t* inCrc, uint32_t* outCrc)
+{
+	blazer_crc_track inTrack, outTrack;
+	blazer_crc_track_init(&inTrack, bufferIn + bufferInOffset);
+	blazer_crc_track_init(&outTrack, bufferOut + bufferOutOffset);
+	int32_t res = blazer_stream_compress_track(bufferIn, bufferInOffset, bufferInLength, bufferInShift, bufferOut, bufferOutOffset, hashArr, level,
+		inCrc != 0 ? &inTrack : 0, outCrc != 0 ? &outTrack : 0);
+	if (res < 0)
+		return res;
+	if (inCrc != 0)
+		*inCrc = blazer_crc_track_finish(&inTrack, bufferIn + bufferInLength);
+	if (outCrc != 0)
+		*outCrc = blazer_crc_track_finish(&outTrack, bufferOut + res);
+	return res;
+}
+
+void blazer_stream_restore_hash(const unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, int32_t bufferInShift, int32_t* hashArr, const int32_t* origHashArr, int32_t level)
+{
+	const stream_level* l = &_levels[level - BLAZER_STREAM_LEVEL_MIN];
+	if (l->maxDepth > 0)
+	{
+		blazer_stream_high_restore_hash(bufferIn, bufferInOffset, bufferInLength, bufferInShift, hashArr, origHashArr);
+		return;
+	}
+
+	// encoder stores positions by hash of 4 bytes, which end at position (sparse positions are subset of them)
+	int hashShift = 32 - l->hashBits;
+	for (int32_t idx = bufferInOffset + 3; idx < bufferInLength; idx++)
+	{
+		uint32_t hashKey = CALC_HASH(read_be32(bufferIn + idx - 3));
+		hashArr[hashKey] = origHashArr[hashKey];
+	}
+}
+
+static int32_t stream_compress(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, int32_t bufferInShift, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, int32_t hashBits, int32_t flags, blazer_crc_track* inTrack, blazer_crc_track* outTrack)
+{
+	blazer_long_match_func longMatch = blazer_get_long_match();
+	int hashShift = 32 - hashBits;
 	int cntLit;
 
-	unsigned __int32 mulEl = 0;
+	uint32_t mulEl = 0;
 
 	unsigned char* bufferOutOrig = bufferOut;
 	bufferOut += bufferOutOffset;
@@ -96,10 +201,10 @@ extern "C" __declspec(dllexport) __int32 blazer_stream_compress_block(unsigned c
 
 	int idxIn = bufferInOffset;
 	int lastProcessedIdxIn = idxIn;
-	int globalOfs = bufferInShift;
+	uint32_t globalOfs = (uint32_t)bufferInShift;
 	if (bufferInLength - idxIn > 3)
 	{
-		mulEl = (unsigned __int32)(bufferIn[idxIn] << 16 | bufferIn[idxIn+1] << 8 | bufferIn[idxIn+2]);
+		mulEl = (uint32_t)(bufferIn[idxIn] << 16 | bufferIn[idxIn+1] << 8 | bufferIn[idxIn+2]);
 		idxIn += 3;
 	}
 	else
@@ -112,15 +217,15 @@ extern "C" __declspec(dllexport) __int32 blazer_stream_compress_block(unsigned c
 		unsigned char elemP0 = bufferIn[idxIn];
 
 		mulEl = (mulEl << 8) | elemP0;
-		unsigned __int32 hashKey = CALC_HASH(mulEl);
-		int hashVal = hashArr[hashKey] - globalOfs;
-		hashArr[hashKey] = idxIn + globalOfs;
-		int backRef = idxIn - hashVal;
+		uint32_t hashKey = CALC_HASH(mulEl);
+		uint32_t pos = idxIn + globalOfs;
+		int backRef = stored_back_ref(hashArr[hashKey], pos, idxIn);
+		hashArr[hashKey] = (int32_t)pos;
+		int hashVal = idxIn - backRef;
 
-		if (hashVal == 0 
-			|| backRef >= MAX_BACK_REF
+		if (backRef == 0
 			|| (backRef >= 257 && bufferIn[hashVal + 1] != bufferIn[idxIn + 1])
-			|| mulEl != (unsigned __int32)((bufferIn[hashVal - 3] << 24) | (bufferIn[hashVal - 2] << 16) | (bufferIn[hashVal - 1] << 8) | bufferIn[hashVal - 0]))
+			|| mulEl != (uint32_t)((bufferIn[hashVal - 3] << 24) | (bufferIn[hashVal - 2] << 16) | (bufferIn[hashVal - 1] << 8) | bufferIn[hashVal - 0]))
 		{
 			idxIn++;
 			continue;
@@ -131,21 +236,44 @@ extern "C" __declspec(dllexport) __int32 blazer_stream_compress_block(unsigned c
 		hashVal++;
 		idxIn++;
 
-		while (idxIn < bufferInLength)
+		int matchEnd = idxIn + blazer_match_length(bufferIn + hashVal, bufferIn + idxIn, bufferIn + bufferInLength, longMatch);
+		if ((flags & BLAZER_STREAM_LAZY) != 0 && matchEnd - idxIn < LAZY_SEQ_MAX && idxIn < iterMax)
 		{
-			elemP0 = bufferIn[idxIn];
-			mulEl = (mulEl << 8) | elemP0;
-			hashKey = CALC_HASH(mulEl);
-			hashArr[hashKey] = idxIn + globalOfs;
-
-			if (bufferIn[hashVal] == elemP0)
+			// candidate of next position is checked by same rules as in main loop. If it gives larger gain,
+			// current position is left as literal and next iteration takes this candidate (hash is not changed for it yet)
+			uint32_t mulElNext = (mulEl << 8) | bufferIn[idxIn];
+			int backRefNext = stored_back_ref(hashArr[CALC_HASH(mulElNext)], idxIn + globalOfs, idxIn);
+			int hashValNext = idxIn - backRefNext;
+			if (backRefNext != 0
+				&& mulElNext == read_be32(bufferIn + hashValNext - 3))
 			{
-				hashVal++;
-				idxIn++;
+				int matchEndNext = idxIn + 1 + blazer_match_length(bufferIn + hashValNext + 1, bufferIn + idxIn + 1, bufferIn + bufferInLength, longMatch);
+				// sequence of next position is one byte shorter at start, token size depends on length of back reference
+				if (matchEndNext - 1 - (backRefNext < 257 ? 2 : 3) > matchEnd - (backRef < 257 ? 2 : 3))
+					continue;
 			}
-			else break;
 		}
 
+		// positions of match (and first different byte) are added to hash after search
+		int hashEnd = matchEnd < bufferInLength ? matchEnd + 1 : bufferInLength;
+		if ((flags & BLAZER_STREAM_DENSE_HASH) == 0 && hashEnd - idxIn > SPARSE_HASH_MIN)
+		{
+			// long matches are hashed sparsely, only last positions are added densely to continue search after match
+			int denseStart = hashEnd - SPARSE_HASH_TAIL;
+			for (; idxIn < denseStart; idxIn += SPARSE_HASH_STEP)
+				hashArr[CALC_HASH(read_be32(bufferIn + idxIn - 3))] = (int32_t)(idxIn + globalOfs);
+			idxIn = denseStart;
+			mulEl = read_be32(bufferIn + idxIn - 4);
+		}
+
+		for (; idxIn < hashEnd; idxIn++)
+		{
+			mulEl = (mulEl << 8) | bufferIn[idxIn];
+			hashArr[CALC_HASH(mulEl)] = (int32_t)(idxIn + globalOfs);
+		}
+
+		idxIn = matchEnd;
+
 		int seqLen = idxIn - cntLit - lastProcessedIdxIn - MIN_SEQ_LEN;
 
 		if (backRef >= 256 + 1)
@@ -156,12 +284,12 @@ extern "C" __declspec(dllexport) __int32 blazer_stream_compress_block(unsigned c
 				if (seqLen < 15)
 				{
 					*(bufferOut++) = (unsigned char)((cntLit << 4) | seqLen | 128);
-					*((unsigned __int16*)bufferOut) = backRef;bufferOut += 2;
+					*((uint16_t*)bufferOut) = backRef;bufferOut += 2;
 				}
 				else
 				{
 					*(bufferOut++) = (unsigned char)((cntLit << 4) | 15 | 128);
-					*((unsigned __int16*)bufferOut) = backRef;bufferOut += 2;
+					*((uint16_t*)bufferOut) = backRef;bufferOut += 2;
 					bufferOut += write_len(bufferOut, seqLen - 15);
 				}
 			}
@@ -170,13 +298,13 @@ extern "C" __declspec(dllexport) __int32 blazer_stream_compress_block(unsigned c
 				if (seqLen < 15)
 				{
 					*(bufferOut++) = (unsigned char)((7 << 4) | seqLen | 128);
-					*((unsigned __int16*)bufferOut) = backRef;bufferOut += 2;
+					*((uint16_t*)bufferOut) = backRef;bufferOut += 2;
 					bufferOut += write_len(bufferOut, cntLit - 7);
 				}
 				else
 				{
 					*(bufferOut++) = (unsigned char)((7 << 4) | 15 | 128);
-					*((unsigned __int16*)bufferOut) = backRef;bufferOut += 2;
+					*((uint16_t*)bufferOut) = backRef;bufferOut += 2;
 					bufferOut += write_len(bufferOut, cntLit - 7);
 					bufferOut += write_len(bufferOut, seqLen - 15);
 				}
@@ -223,15 +351,20 @@ extern "C" __declspec(dllexport) __int32 blazer_stream_compress_block(unsigned c
 		lastProcessedIdxIn = idxIn;
 		idxIn += 3;
 
+		if (inTrack != 0)
+			blazer_crc_track_step(inTrack, bufferIn + lastProcessedIdxIn);
+		if (outTrack != 0)
+			blazer_crc_track_step(outTrack, bufferOut);
+
 		if (idxIn < bufferInLength)
 		{
 			mulEl = (mulEl << 8) | bufferIn[idxIn - 2];
 			hashKey = CALC_HASH(mulEl);
-			hashArr[hashKey] = idxIn - 2 + globalOfs;
+			hashArr[hashKey] = (int32_t)(idxIn - 2 + globalOfs);
 
 			mulEl = (mulEl << 8) | bufferIn[idxIn - 1];
 			hashKey = CALC_HASH(mulEl);
-			hashArr[hashKey] = idxIn - 1 + globalOfs;
+			hashArr[hashKey] = (int32_t)(idxIn - 1 + globalOfs);
 		}
 	}
 
@@ -241,7 +374,7 @@ extern "C" __declspec(dllexport) __int32 blazer_stream_compress_block(unsigned c
 	if (cntLit > 0)
 	{
 		*(bufferOut++) = (unsigned char)(MIN(127, cntLit) | 128);
-		*((unsigned __int16*)bufferOut) = 0xffff;
+		*((uint16_t*)bufferOut) = 0xffff;
 		bufferOut += 2;
 
 		if (cntLit >= 127)
@@ -254,10 +387,50 @@ extern "C" __declspec(dllexport) __int32 blazer_stream_compress_block(unsigned c
 		}
 	}
 
-	return (__int32)(bufferOut - bufferOutOrig);
+	return (int32_t)(bufferOut - bufferOutOrig);
+}
+
+// reads extended length of literals or sequence without bounds checks
+static BLAZER_INLINE int64_t read_len_fast(unsigned char** pBufferIn)
+{
+	unsigned char* bufferIn = *pBufferIn;
+	int64_t len = *(bufferIn++);
+	if (len == 253)
+	{
+		len += *(bufferIn++);
+	}
+	else if (len == 254)
+	{
+		len = 253 + 256 + *(uint16_t*)(bufferIn);
+		bufferIn += 2;
+	}
+	else if (len == 255)
+	{
+		len = 253 + (256 * 256) + (int64_t)*(uint32_t*)(bufferIn);
+		bufferIn += 4;
+	}
+
+	*pBufferIn = bufferIn;
+	return len;
 }
 
-extern "C" __declspec(dllexport) __int32 blazer_stream_decompress_block(unsigned char* bufferIn, __int32 bufferInOffset, __int32 bufferInLength, unsigned char* bufferOut, __int32 bufferOutOffset, __int32 bufferOutLength)
+// reads extended length of literals or sequence, returns -1 if in buffer is truncated
+static BLAZER_INLINE int64_t read_len_safe(unsigned char** pBufferIn, unsigned char* bufferInEnd)
+{
+	unsigned char* bufferIn = *pBufferIn;
+	if (bufferIn >= bufferInEnd)
+		return -1;
+	unsigned char lenR = *bufferIn;
+	int need = lenR < 253 ? 1 : (lenR == 253 ? 2 : (lenR == 254 ? 3 : 5));
+	if (bufferInEnd - bufferIn < need)
+		return -1;
+	return read_len_fast(pBufferIn);
+}
+
+// longest token header: element, 2 bytes of back reference and two lengths of 5 bytes
+#define MAX_TOKEN_HEADER 13
+
+int32_t blazer_stream_decompress_track(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength, blazer_crc_track* inTrack, blazer_crc_track* outTrack)
 {
 	unsigned char* bufferInEnd = bufferIn + bufferInLength;
 	bufferIn += bufferInOffset;
@@ -266,107 +439,178 @@ extern "C" __declspec(dllexport) __int32 blazer_stream_decompress_block(unsigned
 	unsigned char* bufferOutEnd = bufferOut + bufferOutLength;
 	bufferOut += bufferOutOffset;
 
-	while (bufferIn < bufferInEnd)
+	// fast loop works while token header and wide copies cannot cross ends of buffers,
+	// token which does not fit is left for precise tail loop. Loop is skipped when any buffer has no room for margin,
+	// otherwise even empty token would copy wide chunk after end of out buffer
+	bool isFast = bufferInEnd - bufferIn > BLAZER_DECOMPRESS_MARGIN && bufferOutEnd - bufferOut > BLAZER_DECOMPRESS_MARGIN;
+	unsigned char* bufferInFast = isFast ? bufferInEnd - BLAZER_DECOMPRESS_MARGIN : bufferIn;
+	unsigned char* bufferOutFast = isFast ? bufferOutEnd - BLAZER_DECOMPRESS_MARGIN : bufferOut;
+	blazer_long_copy_func longCopy = blazer_get_long_copy();
+	// crc of data is updated when out position reaches limit, without tracking it is never reached in fast loop
+	unsigned char* crcLimit = inTrack != 0 || outTrack != 0 ? bufferOut + BLAZER_CRC_TRACK_CHUNK : bufferOutEnd;
+
+	while (bufferIn < bufferInFast)
 	{
-		unsigned char elem = *(bufferIn++);
+		if (bufferOut >= crcLimit)
+		{
+			if (inTrack != 0)
+				blazer_crc_track_step(inTrack, bufferIn);
+			if (outTrack != 0)
+				blazer_crc_track_step(outTrack, bufferOut);
+			crcLimit = bufferOut + BLAZER_CRC_TRACK_CHUNK;
+		}
 
-		int seqCntFirst = elem & 0xf;
-		int litCntFirst = (elem >> 4) & 7;
+		unsigned char* token = bufferIn;
+		unsigned char elem = *(bufferIn++);
 
-		int litCnt = litCntFirst;
-		int seqCnt;
-		int backRef;
+		int64_t litCnt = (elem >> 4) & 7;
+		int64_t seqCnt = (elem & 0xf) + 4;
+		int64_t backRef;
 
 		if (elem >= 128)
 		{
-			backRef = *(unsigned __int16*)(bufferIn) + 257;
+			backRef = *(uint16_t*)(bufferIn) + 257;
 			bufferIn += 2;
 			if (backRef == 0xffff + 257)
 			{
-				seqCnt = 0;
-				seqCntFirst = 0;
+				// last literals
 				litCnt = elem - 128;
-				litCntFirst = litCnt == 127 ? 7 : 0;
+				seqCnt = 0;
 				backRef = 0;
-			}
-			else 
-			{
-				seqCnt = seqCntFirst + /*5*/ 4;
+				if (litCnt == 127)
+					litCnt += read_len_fast(&bufferIn);
 			}
 		}
 		else
 		{
 			backRef = *(bufferIn++) + 1;
-			seqCnt = seqCntFirst + 4;
 		}
 
-		if (litCntFirst == 7)
+		if (litCnt == 7 && seqCnt > 0)
+			litCnt += read_len_fast(&bufferIn);
+		if (seqCnt == 15 + 4)
+			seqCnt += read_len_fast(&bufferIn);
+
+		if (litCnt > bufferInFast - bufferIn || litCnt + seqCnt > bufferOutFast - bufferOut)
 		{
-			unsigned char litCntR = *(bufferIn++);
-			
-			if (litCntR < 253) litCnt += litCntR;
-			else if (litCntR == 253)
-				litCnt += 253 + *(bufferIn++);
-			else if (litCntR == 254)
-			{
-				litCnt += 253 + 256 + *(unsigned __int16*)(bufferIn);
-				bufferIn += 2;
-			}
-			else
-			{
-				litCnt += 253 + (256 * 256) + *(unsigned __int32*)(bufferIn);
-				bufferIn += 4;
-			}
+			bufferIn = token;
+			break;
 		}
 
-		if (seqCntFirst == 15)
+		unsigned char* litEnd = bufferOut + litCnt;
+		unsigned char* seqEnd = litEnd + seqCnt;
+		if (backRef > litEnd - bufferOutOrig)
+			return -3;
+
+		blazer_literal_copy(bufferOut, bufferIn, (size_t)litCnt, longCopy);
+		bufferIn += litCnt;
+		bufferOut = litEnd;
+		if (seqCnt > 0)
+			blazer_match_copy(bufferOut, (size_t)backRef, (size_t)seqCnt, longCopy);
+		bufferOut = seqEnd;
+	}
+
+	// tail loop checks every read and copies data precisely near buffer ends
+	while (bufferIn < bufferInEnd)
+	{
+		unsigned char elem = *(bufferIn++);
+
+		int64_t litCnt = (elem >> 4) & 7;
+		int64_t seqCnt = (elem & 0xf) + 4;
+		int64_t backRef;
+
+		if (elem >= 128)
 		{
-			unsigned char seqCntR = *(bufferIn++);
-			if (seqCntR < 253) seqCnt += seqCntR;
-			else if (seqCntR == 253)
-				seqCnt += 253 + *(bufferIn++);
-			else if (seqCntR == 254)
-			{
-				seqCnt += 253 + 256 + *(unsigned __int16*)(bufferIn);
-				bufferIn += 2;
-			}
-			else
+			if (bufferInEnd - bufferIn < 2)
+				return -2;
+			backRef = *(uint16_t*)(bufferIn) + 257;
+			bufferIn += 2;
+			if (backRef == 0xffff + 257)
 			{
-				seqCnt += 253 + (256 * 256) + *(unsigned __int32*)(bufferIn);
-				bufferIn += 4;
+				litCnt = elem - 128;
+				seqCnt = 0;
+				backRef = 0;
+				if (litCnt == 127)
+				{
+					int64_t len = read_len_safe(&bufferIn, bufferInEnd);
+					if (len < 0)
+						return -2;
+					litCnt += len;
+				}
 			}
 		}
+		else
+		{
+			if (bufferIn >= bufferInEnd)
+				return -2;
+			backRef = *(bufferIn++) + 1;
+		}
+
+		if (litCnt == 7 && seqCnt > 0)
+		{
+			int64_t len = read_len_safe(&bufferIn, bufferInEnd);
+			if (len < 0)
+				return -2;
+			litCnt += len;
+		}
+
+		if (seqCnt == 15 + 4)
+		{
+			int64_t len = read_len_safe(&bufferIn, bufferInEnd);
+			if (len < 0)
+				return -2;
+			seqCnt += len;
+		}
 
-		unsigned char* maxOutLength = bufferOut + litCnt + seqCnt;
-		if (maxOutLength > bufferOutEnd)
+		if (litCnt + seqCnt > bufferOutEnd - bufferOut)
 			return -1;
 
-		if (bufferIn + litCnt > bufferInEnd)
+		if (litCnt > bufferInEnd - bufferIn)
 			return -2;
 
-		bufferOut = copy_memory(bufferIn, bufferOut, litCnt);
-		bufferIn += litCnt;
-
-		if (bufferOut - backRef < bufferOutOrig)
+		unsigned char* litEnd = bufferOut + litCnt;
+		unsigned char* seqEnd = litEnd + seqCnt;
+		if (backRef > litEnd - bufferOutOrig)
 			return -3;
 
-		if (backRef >= sizeof(int)/*&& seqCnt > sizeof(int)*/)
-		{
-			bufferOut = copy_memory(bufferOut - backRef, bufferOut, seqCnt);
-		}
-		else if (backRef >= 4) 
+		memcpy(bufferOut, bufferIn, (size_t)litCnt);
+		bufferIn += litCnt;
+		bufferOut = litEnd;
+
+		// matches do not read in buffer, so they can be copied by wide chunks till end of out buffer
+		if (seqCnt > 0 && bufferOutEnd - seqEnd >= BLAZER_DECOMPRESS_MARGIN)
 		{
-			bufferOut = copy_memory4(bufferOut - backRef, bufferOut, seqCnt);
+			blazer_match_copy(bufferOut, (size_t)backRef, (size_t)seqCnt, longCopy);
+			bufferOut = seqEnd;
 		}
 		else
 		{
-			while (--seqCnt >= 0)
-			{
-				*(bufferOut) = *(bufferOut - backRef);
-				bufferOut++;
-			}
+			unsigned char* src = bufferOut - backRef;
+			while (bufferOut < seqEnd)
+				*bufferOut++ = *src++;
 		}
 	}
 
-	return (__int32)(bufferOut - bufferOutOrig);
+	return (int32_t)(bufferOut - bufferOutOrig);
+}
+
+extern "C" BLAZER_API int32_t blazer_stream_decompress_block(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength)
+{
+	return blazer_stream_decompress_track(bufferIn, bufferInOffset, bufferInLength, bufferOut, bufferOutOffset, bufferOutLength, 0, 0);
+}
+
+extern "C" BLAZER_API int32_t blazer_stream_decompress_block_crc(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength, uint32_t* inCrc, uint32_t* outCrc)
+{
+	blazer_crc_track inTrack, outTrack;
+	blazer_crc_track_init(&inTrack, bufferIn + bufferInOffset);
+	blazer_crc_track_init(&outTrack, bufferOut + bufferOutOffset);
+	int32_t res = blazer_stream_decompress_track(bufferIn, bufferInOffset, bufferInLength, bufferOut, bufferOutOffset, bufferOutLength,
+		inCrc != 0 ? &inTrack : 0, outCrc != 0 ? &outTrack : 0);
+	if (res < 0)
+		return res;
+	if (inCrc != 0)
+		*inCrc = blazer_crc_track_finish(&inTrack, bufferIn + bufferInLength);
+	if (outCrc != 0)
+		*outCrc = blazer_crc_track_finish(&outTrack, bufferOut + res);
+	return res;
 }
@@ -0,0 +1,325 @@
+#include "stdafx.h"
+#include "Blazer.h"
+
+#define MAX_BACK_REF ((1 << 16) + 256)
+#define MAX_BLOCK_SIZE (16 << 20)
+// encoder reads some bytes after data and decoder copies by wide chunks, so window has spare bytes for both
+#define WINDOW_SPARE BLAZER_DECOMPRESS_MARGIN
+#define COMPRESS_BOUND(len) ((len) + ((len) >> 8) + 16)
+
+#define CTX_ALIGN 64
+#define ALIGN_UP(v) (((v) + CTX_ALIGN - 1) & ~(size_t)(CTX_ALIGN - 1))
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+// snapshot: 'bSnp', mode, level, count of table entries (0 if table is not stored), length of history,
+// global offset of history start, CRC32C of history and table (4 bytes each, little-endian), history, table
+#define SNAPSHOT_HEADER_SIZE 28
+
+struct blazer_stream_ctx
+{
+	// history and current block, history is moved to start of window when next block does not fit
+	unsigned char* window;
+	int32_t windowLength;
+	// end of data in window
+	int32_t pos;
+	// global offset of window start for positions in hash table, can overflow
+	uint32_t shift;
+	// compressed data, which does not fit into first out segment or is split into several in segments
+	unsigned char* scratch;
+	int32_t scratchLength;
+	int32_t* hashArr;
+	int32_t hashSize;
+	int32_t maxBlockSize;
+	int32_t level;
+	// hash table is restored from compact snapshot and should be built from history before next block
+	int32_t isHashStale;
+	// memory which was allocated by blazer_stream_ctx_create, null for memory of caller
+	void* allocated;
+};
+
+static const unsigned char SnapshotMagic[4] = { 'b', 'S', 'n', 'p' };
+
+static BLAZER_INLINE void write_le32(unsigned char* p, uint32_t v)
+{
+	p[0] = (unsigned char)v;
+	p[1] = (unsigned char)(v >> 8);
+	p[2] = (unsigned char)(v >> 16);
+	p[3] = (unsigned char)(v >> 24);
+}
+
+static BLAZER_INLINE uint32_t read_le32(const unsigned char* p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// window has space for two lengths of history, so history is moved after at least MAX_BACK_REF bytes of data
+static BLAZER_INLINE int32_t window_length(int32_t maxBlockSize)
+{
+	return 2 * MAX_BACK_REF + maxBlockSize;
+}
+
+static size_t ctx_layout(int32_t maxBlockSize, int32_t hashSize, size_t* windowOffset, size_t* scratchOffset)
+{
+	*windowOffset = ALIGN_UP(sizeof(blazer_stream_ctx)) + ALIGN_UP(sizeof(int32_t) * (size_t)hashSize);
+	*scratchOffset = *windowOffset + ALIGN_UP((size_t)window_length(maxBlockSize) + WINDOW_SPARE);
+	return CTX_ALIGN - 1 + *scratchOffset + COMPRESS_BOUND((size_t)maxBlockSize);
+}
+
+// returns total length of segments or -1 if some length is invalid
+static int64_t segments_length(const blazer_segment* segments, int32_t count)
+{
+	int64_t total = 0;
+	for (int32_t i = 0; i < count; i++)
+	{
+		if (segments[i].length < 0)
+			return -1;
+		total += segments[i].length;
+	}
+
+	return total;
+}
+
+static void gather(unsigned char* dst, const blazer_segment* segments, int32_t count)
+{
+	for (int32_t i = 0; i < count; i++)
+	{
+		memcpy(dst, segments[i].data, segments[i].length);
+		dst += segments[i].length;
+	}
+}
+
+// segments should have enough space for all data
+static void scatter(const unsigned char* src, int32_t length, const blazer_segment* segments)
+{
+	for (int32_t i = 0; length > 0; i++)
+	{
+		int32_t cnt = MIN(length, segments[i].length);
+		memcpy(segments[i].data, src, cnt);
+		src += cnt;
+		length -= cnt;
+	}
+}
+
+// moves last MAX_BACK_REF bytes of history to start of window if length bytes do not fit after it
+static void reserve_window(blazer_stream_ctx* ctx, int32_t length)
+{
+	if (ctx->pos + length <= ctx->windowLength)
+		return;
+
+	int32_t keep = MIN(ctx->pos, MAX_BACK_REF);
+	blazer_move_down(ctx->window, ctx->window + ctx->pos - keep, keep);
+	ctx->shift += ctx->pos - keep;
+	ctx->pos = keep;
+}
+
+extern "C" BLAZER_API size_t blazer_stream_ctx_size(int32_t maxBlockSize, int32_t level)
+{
+	if (maxBlockSize <= 0 || maxBlockSize > MAX_BLOCK_SIZE)
+		return 0;
+	int32_t hashSize = level == 0 ? 0 : blazer_stream_hash_size(level);
+	if (level != 0 && hashSize == 0)
+		return 0;
+
+	size_t windowOffset, scratchOffset;
+	return ctx_layout(maxBlockSize, hashSize, &windowOffset, &scratchOffset);
+}
+
+extern "C" BLAZER_API blazer_stream_ctx* blazer_stream_ctx_create(void* memory, size_t memorySize, int32_t maxBlockSize, int32_t level)
+{
+	size_t size = blazer_stream_ctx_size(maxBlockSize, level);
+	if (size == 0)
+		return 0;
+
+	void* allocated = 0;
+	if (memory == 0)
+	{
+		allocated = blazer_alloc_zero(size);
+		if (allocated == 0)
+			return 0;
+		memory = allocated;
+	}
+	else if (memorySize < size)
+	{
+		return 0;
+	}
+
+	blazer_stream_ctx* ctx = (blazer_stream_ctx*)ALIGN_UP((size_t)memory);
+	int32_t hashSize = level == 0 ? 0 : blazer_stream_hash_size(level);
+	size_t windowOffset, scratchOffset;
+	ctx_layout(maxBlockSize, hashSize, &windowOffset, &scratchOffset);
+	ctx->hashArr = (int32_t*)((unsigned char*)ctx + ALIGN_UP(sizeof(blazer_stream_ctx)));
+	ctx->hashSize = hashSize;
+	ctx->window = (unsigned char*)ctx + windowOffset;
+	ctx->windowLength = window_length(maxBlockSize);
+	ctx->scratch = (unsigned char*)ctx + scratchOffset;
+	ctx->scratchLength = COMPRESS_BOUND(maxBlockSize);
+	ctx->pos = 0;
+	ctx->shift = 0;
+	ctx->maxBlockSize = maxBlockSize;
+	ctx->level = level;
+	ctx->isHashStale = 0;
+	ctx->allocated = allocated;
+	if (allocated == 0)
+		memset(ctx->hashArr, 0, sizeof(int32_t) * (size_t)hashSize);
+	return ctx;
+}
+
+extern "C" BLAZER_API void blazer_stream_ctx_reset(blazer_stream_ctx* ctx)
+{
+	// positions in hash table are compared by distance, so old positions become too far without clearing of table.
+	// New data is written from start of window, so old data cannot be referenced too
+	ctx->shift += ctx->pos + MAX_BACK_REF;
+	ctx->pos = 0;
+	ctx->isHashStale = 0;
+}
+
+extern "C" BLAZER_API void blazer_stream_ctx_destroy(blazer_stream_ctx* ctx)
+{
+	if (ctx != 0 && ctx->allocated != 0)
+		blazer_free(ctx->allocated);
+}
+
+// adds positions of history to cleared table by compression of history into scratch (by parts, which fit into it).
+// Table is not same as table of original context, but it has same history, so ratio is almost same
+static void rebuild_hash(blazer_stream_ctx* ctx)
+{
+	for (int32_t pos = 0; pos < ctx->pos; pos += ctx->maxBlockSize)
+		blazer_stream_compress_block_level(ctx->window, pos, MIN(pos + ctx->maxBlockSize, ctx->pos), (int32_t)ctx->shift, ctx->scratch, 0, ctx->hashArr, ctx->level);
+	ctx->isHashStale = 0;
+}
+
+extern "C" BLAZER_API int32_t blazer_stream_compress_segments(blazer_stream_ctx* ctx, const blazer_segment* segmentsIn, int32_t countIn, const blazer_segment* segmentsOut, int32_t countOut)
+{
+	int64_t length = segments_length(segmentsIn, countIn);
+	int64_t outLength = segments_length(segmentsOut, countOut);
+	if (ctx->level == 0 || length < 0 || length > ctx->maxBlockSize || outLength < 0)
+		return -1;
+
+	int32_t cnt = (int32_t)length;
+	if (ctx->isHashStale)
+		rebuild_hash(ctx);
+	reserve_window(ctx, cnt);
+	gather(ctx->window + ctx->pos, segmentsIn, countIn);
+
+	// usually first out segment is large enough and data is compressed directly into it
+	bool isDirect = countOut > 0 && segmentsOut[0].length >= COMPRESS_BOUND(cnt);
+	unsigned char* out = isDirect ? segmentsOut[0].data : ctx->scratch;
+	int32_t comprLength = blazer_stream_compress_block_level(ctx->window, ctx->pos, ctx->pos + cnt, (int32_t)ctx->shift, out, 0, ctx->hashArr, ctx->level);
+	ctx->pos += cnt;
+
+	if (!isDirect)
+	{
+		if (comprLength > outLength)
+			return -2;
+		scatter(ctx->scratch, comprLength, segmentsOut);
+	}
+
+	return comprLength;
+}
+
+extern "C" BLAZER_API int32_t blazer_stream_decompress_segments(blazer_stream_ctx* ctx, const blazer_segment* segmentsIn, int32_t countIn, const blazer_segment* segmentsOut, int32_t countOut)
+{
+	int64_t length = segments_length(segmentsIn, countIn);
+	int64_t outLength = segments_length(segmentsOut, countOut);
+	if (length < 0 || outLength < 0)
+		return -1;
+	if (length > ctx->scratchLength)
+		return -4;
+
+	unsigned char* in = ctx->scratch;
+	if (countIn == 1)
+		in = segmentsIn[0].data;
+	else
+		gather(ctx->scratch, segmentsIn, countIn);
+
+	int32_t maxLength = (int32_t)MIN(outLength, (int64_t)ctx->maxBlockSize);
+	reserve_window(ctx, maxLength);
+	int32_t res = blazer_stream_decompress_block(in, 0, (int32_t)length, ctx->window, ctx->pos, ctx->pos + maxLength);
+	if (res < 0)
+		return res;
+
+	int32_t cnt = res - ctx->pos;
+	scatter(ctx->window + ctx->pos, cnt, segmentsOut);
+	ctx->pos = res;
+	return cnt;
+}
+
+// count of table entries, which are saved in mode
+static int32_t snapshot_hash_size(const blazer_stream_ctx* ctx, int32_t mode)
+{
+	// table of compact snapshot is built again after restore, so table which is not built yet is not saved too
+	return mode == BLAZER_SNAPSHOT_FULL && !ctx->isHashStale ? ctx->hashSize : 0;
+}
+
+extern "C" BLAZER_API int64_t blazer_stream_ctx_snapshot_size(const blazer_stream_ctx* ctx, int32_t mode)
+{
+	if (mode != BLAZER_SNAPSHOT_FULL && mode != BLAZER_SNAPSHOT_COMPACT)
+		return -1;
+	return SNAPSHOT_HEADER_SIZE + MIN(ctx->pos, MAX_BACK_REF) + sizeof(int32_t) * (int64_t)snapshot_hash_size(ctx, mode);
+}
+
+extern "C" BLAZER_API int64_t blazer_stream_ctx_snapshot(const blazer_stream_ctx* ctx, int32_t mode, unsigned char* out, int64_t outLength)
+{
+	int64_t size = blazer_stream_ctx_snapshot_size(ctx, mode);
+	if (size < 0 || outLength < size)
+		return -1;
+
+	// only last MAX_BACK_REF bytes of window can be referenced by next blocks
+	int32_t historyLength = MIN(ctx->pos, MAX_BACK_REF);
+	int32_t hashSize = snapshot_hash_size(ctx, mode);
+	unsigned char* p = out + SNAPSHOT_HEADER_SIZE;
+	memcpy(p, ctx->window + ctx->pos - historyLength, historyLength);
+	p += historyLength;
+	for (int32_t i = 0; i < hashSize; i++, p += 4)
+		write_le32(p, (uint32_t)ctx->hashArr[i]);
+
+	memcpy(out, SnapshotMagic, 4);
+	write_le32(out + 4, hashSize > 0 ? BLAZER_SNAPSHOT_FULL : BLAZER_SNAPSHOT_COMPACT);
+	write_le32(out + 8, (uint32_t)ctx->level);
+	write_le32(out + 12, (uint32_t)hashSize);
+	write_le32(out + 16, (uint32_t)historyLength);
+	write_le32(out + 20, ctx->shift + (uint32_t)(ctx->pos - historyLength));
+	write_le32(out + 24, crc32c_append(0, out + SNAPSHOT_HEADER_SIZE, (size_t)(size - SNAPSHOT_HEADER_SIZE)));
+	return size;
+}
+
+extern "C" BLAZER_API int32_t blazer_stream_ctx_restore(blazer_stream_ctx* ctx, const unsigned char* data, int64_t length)
+{
+	if (length < SNAPSHOT_HEADER_SIZE || data[0] != SnapshotMagic[0] || data[1] != SnapshotMagic[1] || data[2] != SnapshotMagic[2] || data[3] != SnapshotMagic[3])
+		return -1;
+
+	uint32_t mode = read_le32(data + 4);
+	int32_t level = (int32_t)read_le32(data + 8);
+	uint32_t hashSize = read_le32(data + 12);
+	uint32_t historyLength = read_le32(data + 16);
+	if ((mode != BLAZER_SNAPSHOT_FULL && mode != BLAZER_SNAPSHOT_COMPACT) || historyLength > MAX_BACK_REF || hashSize > 0x10000000
+		|| (mode == BLAZER_SNAPSHOT_FULL) != (hashSize > 0)
+		|| length != SNAPSHOT_HEADER_SIZE + (int64_t)historyLength + (int64_t)sizeof(int32_t) * hashSize
+		|| crc32c_append(0, data + SNAPSHOT_HEADER_SIZE, (size_t)(length - SNAPSHOT_HEADER_SIZE)) != read_le32(data + 24))
+		return -1;
+	// table of full snapshot is used as is, so it should have same layout, compact one can be restored into any context
+	bool isTableUsed = mode == BLAZER_SNAPSHOT_FULL && ctx->level != 0;
+	if (isTableUsed && (level != ctx->level || (int32_t)hashSize != ctx->hashSize))
+		return -2;
+
+	const unsigned char* p = data + SNAPSHOT_HEADER_SIZE;
+	memcpy(ctx->window, p, historyLength);
+	p += historyLength;
+	ctx->pos = (int32_t)historyLength;
+	ctx->shift = read_le32(data + 20);
+	ctx->isHashStale = 0;
+	if (isTableUsed)
+	{
+		for (uint32_t i = 0; i < hashSize; i++, p += 4)
+			ctx->hashArr[i] = (int32_t)read_le32(p);
+	}
+	else if (ctx->level != 0)
+	{
+		// table is built by first compressed block, so restore is cheap and context, which only decodes, never builds it
+		memset(ctx->hashArr, 0, sizeof(int32_t) * (size_t)ctx->hashSize);
+		ctx->isHashStale = historyLength > 0;
+	}
+
+	return 0;
+}
@@ -0,0 +1,260 @@
+#include "stdafx.h"
+#include "Blazer.h"
+#include "StreamHigh.h"
+#include "Match.h"
+
+#define MIN_SEQ_LEN  4
+#define CHAIN_MASK  (BLAZER_HIGH_CHAIN_LEN - 1)
+
+// carefully selected random number
+#define MUL 1527631329
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+struct high_state
+{
+	unsigned char* bufferIn;
+	int32_t bufferInLength;
+	// positions are global offsets modulo 2^32 (as in stream encoder), distances are computed in unsigned arithmetic
+	uint32_t globalOfs;
+	int32_t* heads;
+	uint16_t* chains;
+	// first position, which is not added to chains yet
+	int32_t nextInsert;
+	int32_t maxDepth;
+	int32_t niceLen;
+	blazer_long_match_func longMatch;
+};
+
+struct high_match
+{
+	int32_t len;
+	int32_t backRef;
+	// saved bytes: length of sequence without size of token
+	int32_t gain;
+};
+
+static BLAZER_INLINE uint32_t read32(const unsigned char* p)
+{
+	uint32_t v;
+	memcpy(&v, p, 4);
+	return v;
+}
+
+static BLAZER_INLINE uint32_t calc_hash(const unsigned char* p)
+{
+	return (read32(p) * MUL) >> (32 - BLAZER_HIGH_HASH_BITS);
+}
+
+static BLAZER_INLINE int write_len(unsigned char* bufferOut, int c)
+{
+	if (c < 253)
+	{
+		*(bufferOut) = (unsigned char)c;
+		return 1;
+	}
+	if (c < 253 + 256)
+	{
+		*(bufferOut) = 253;
+		*(bufferOut + 1) = (unsigned char)(c - 253);
+		return 2;
+	}
+	if (c < 253 + (256 * 256))
+	{
+		*(bufferOut) = 254;
+		c -= 253 + 256;
+		*((uint16_t*)(bufferOut + 1)) = c;
+		return 3;
+	}
+// 	else
+	{
+		*(bufferOut) = 255;
+		c -= 253 + (256 * 256);
+		*((uint32_t*)(bufferOut + 1)) = c;
+		return 5;
+	}
+}
+
+// chains store distance to previous position with same hash, so they do not depend on shift of data.
+// There is no value for empty head: position 0 is valid after wrapping of global offset, so empty or stale heads
+// are rejected by distance checks and comparison of data as in stream encoder
+static BLAZER_INLINE void insert_positions(high_state* s, int32_t idxEnd)
+{
+	int32_t idx = s->nextInsert;
+	for (; idx < idxEnd; idx++)
+	{
+		uint32_t hashKey = calc_hash(s->bufferIn + idx);
+		uint32_t pos = idx + s->globalOfs;
+		uint32_t prev = (uint32_t)s->heads[hashKey];
+		s->chains[pos & CHAIN_MASK] = (uint16_t)MIN(pos - prev, CHAIN_MASK);
+		s->heads[hashKey] = (int32_t)pos;
+	}
+
+	s->nextInsert = idx;
+}
+
+// finds best match for idxIn in previous positions with gain larger than minGain, match.len is 0 if nothing is found
+static BLAZER_INLINE void find_match(high_state* s, int32_t idxIn, int32_t minGain, high_match* match)
+{
+	unsigned char* bufferIn = s->bufferIn;
+	unsigned char* cur = bufferIn + idxIn;
+	unsigned char* curEnd = bufferIn + s->bufferInLength;
+	int32_t maxLen = s->bufferInLength - idxIn;
+	// shorter sequences cannot give required gain even with short back reference
+	int32_t bestLen = minGain + 2 < MIN_SEQ_LEN - 1 ? MIN_SEQ_LEN - 1 : minGain + 2;
+	match->len = 0;
+	match->gain = minGain;
+	if (bestLen >= maxLen)
+		return;
+
+	insert_positions(s, idxIn);
+	uint32_t seq = read32(cur);
+	uint32_t head = (uint32_t)s->heads[calc_hash(cur)];
+	uint32_t pos = idxIn + s->globalOfs;
+	uint32_t backRef = pos - head;
+
+	for (int32_t depth = s->maxDepth; depth > 0; depth--)
+	{
+		if (backRef == 0 || backRef > CHAIN_MASK || backRef > (uint32_t)idxIn)
+			break;
+
+		unsigned char* src = cur - backRef;
+		// positions are checked from nearest, so only longer match can be better
+		if (read32(src + bestLen - 3) == read32(cur + bestLen - 3) && read32(src) == seq)
+		{
+			int32_t len = MIN_SEQ_LEN + blazer_match_length(src + MIN_SEQ_LEN, cur + MIN_SEQ_LEN, curEnd, s->longMatch);
+			int32_t gain = len - (backRef < 257 ? 2 : 3);
+			if (gain > match->gain)
+			{
+				match->len = len;
+				match->backRef = (int32_t)backRef;
+				match->gain = gain;
+				bestLen = len;
+				if (len >= s->niceLen || len == maxLen)
+					break;
+			}
+		}
+
+		uint32_t delta = s->chains[(pos - backRef) & CHAIN_MASK];
+		if (delta == 0)
+			break;
+		backRef += delta;
+	}
+}
+
+static BLAZER_INLINE unsigned char* write_seq(unsigned char* bufferOut, unsigned char* lit, int32_t cntLit, int32_t seqLen, int32_t backRef)
+{
+	seqLen -= MIN_SEQ_LEN;
+	unsigned char elem = (unsigned char)((MIN(cntLit, 7) << 4) | MIN(seqLen, 15));
+	if (backRef >= 256 + 1)
+	{
+		backRef -= 256 + 1;
+		*(bufferOut++) = elem | 128;
+		*((uint16_t*)bufferOut) = (uint16_t)backRef;
+		bufferOut += 2;
+	}
+	else
+	{
+		// 1 is always min, should not write it
+		*(bufferOut++) = elem;
+		*(bufferOut++) = (unsigned char)(backRef - 1);
+	}
+
+	if (cntLit >= 7)
+		bufferOut += write_len(bufferOut, cntLit - 7);
+	if (seqLen >= 15)
+		bufferOut += write_len(bufferOut, seqLen - 15);
+
+	memcpy(bufferOut, lit, cntLit);
+	return bufferOut + cntLit;
+}
+
+int32_t blazer_stream_compress_high(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, int32_t bufferInShift, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, int32_t maxDepth, int32_t lazyDepth, int32_t niceLen)
+{
+	high_state s;
+	s.bufferIn = bufferIn;
+	s.bufferInLength = bufferInLength;
+	s.globalOfs = bufferInShift;
+	s.heads = hashArr;
+	s.chains = (uint16_t*)(hashArr + (1 << BLAZER_HIGH_HASH_BITS));
+	// last positions of previous block are hashed by bytes of this block, so they are added to chains now
+	s.nextInsert = bufferInOffset < MIN_SEQ_LEN - 1 ? 0 : bufferInOffset - (MIN_SEQ_LEN - 1);
+	s.maxDepth = maxDepth;
+	s.niceLen = niceLen;
+	s.longMatch = blazer_get_long_match();
+
+	unsigned char* bufferOutOrig = bufferOut;
+	bufferOut += bufferOutOffset;
+
+	int32_t idxIn = bufferInOffset;
+	int32_t lastProcessedIdxIn = idxIn;
+	// last position, which has enough bytes for sequence
+	int32_t iterMax = bufferInLength - MIN_SEQ_LEN;
+
+	high_match match;
+	high_match matchNext;
+	while (idxIn <= iterMax)
+	{
+		find_match(&s, idxIn, 0, &match);
+		if (match.len == 0)
+		{
+			idxIn++;
+			continue;
+		}
+
+		// lazy matching: every skipped position costs one literal, so next match is better only with larger gain
+		for (int32_t step = 1; step <= lazyDepth && match.len < niceLen && idxIn + step <= iterMax;)
+		{
+			find_match(&s, idxIn + step, match.gain, &matchNext);
+			if (matchNext.len > 0)
+			{
+				idxIn += step;
+				match = matchNext;
+				step = 1;
+			}
+			else
+			{
+				step++;
+			}
+		}
+
+		bufferOut = write_seq(bufferOut, bufferIn + lastProcessedIdxIn, idxIn - lastProcessedIdxIn, match.len, match.backRef);
+		idxIn += match.len;
+		lastProcessedIdxIn = idxIn;
+	}
+
+	// positions of last sequence and last literals are added to chains for next block, except last ones,
+	// which do not have enough bytes for hash yet
+	insert_positions(&s, iterMax + 1);
+
+	int32_t cntLit = bufferInLength - lastProcessedIdxIn;
+	if (cntLit > 0)
+	{
+		*(bufferOut++) = (unsigned char)(MIN(127, cntLit) | 128);
+		*((uint16_t*)bufferOut) = 0xffff;
+		bufferOut += 2;
+
+		if (cntLit >= 127)
+			bufferOut += write_len(bufferOut, cntLit - 127);
+
+		memcpy(bufferOut, bufferIn + lastProcessedIdxIn, cntLit);
+		bufferOut += cntLit;
+	}
+
+	return (int32_t)(bufferOut - bufferOutOrig);
+}
+
+void blazer_stream_high_restore_hash(const unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, int32_t bufferInShift, int32_t* hashArr, const int32_t* origHashArr)
+{
+	uint16_t* chains = (uint16_t*)(hashArr + (1 << BLAZER_HIGH_HASH_BITS));
+	const uint16_t* origChains = (const uint16_t*)(origHashArr + (1 << BLAZER_HIGH_HASH_BITS));
+	// positions are hashed by 4 bytes, which start at them, so block changes positions from 3 bytes before it
+	int32_t idxStart = bufferInOffset < MIN_SEQ_LEN - 1 ? 0 : bufferInOffset - (MIN_SEQ_LEN - 1);
+	for (int32_t idx = idxStart; idx <= bufferInLength - MIN_SEQ_LEN; idx++)
+	{
+		uint32_t hashKey = calc_hash(bufferIn + idx);
+		uint32_t pos = idx + (uint32_t)bufferInShift;
+		hashArr[hashKey] = origHashArr[hashKey];
+		chains[pos & CHAIN_MASK] = origChains[pos & CHAIN_MASK];
+	}
+}
@@ -0,0 +1,42 @@
+// Block.h : internal functions of block algorithm for reusable hash tables
+// Hash table stores positions with base offset. Positions which are not greater than base of current block are
+// treated as empty, so table can be reused for next block by moving of base instead of clearing
+
+#pragma once
+
+#include "stdafx.h"
+#include "Crc32c.h"
+
+#define BLAZER_BLOCK_HASH_SIZE (1 << 16)
+
+struct blazer_block_hash
+{
+	int32_t* arr;
+	// base for next block, all stored positions are less than it
+	int32_t base;
+};
+
+// returns base for block with positions up to length (right offset of buffer) and moves base of next block after them.
+// Table is cleared only when positions do not fit into int32
+static BLAZER_INLINE int32_t blazer_block_hash_acquire(blazer_block_hash* hash, int32_t length)
+{
+	if (hash->base > 0x7fffffff - length - 1)
+	{
+		memset(hash->arr, 0, sizeof(int32_t) * BLAZER_BLOCK_HASH_SIZE);
+		hash->base = 0;
+	}
+
+	int32_t base = hash->base;
+	hash->base = base + length + 1;
+	return base;
+}
+
+// same as blazer_block_compress_block and blazer_block_decompress_block with base of positions in hashArr
+int32_t blazer_block_compress_base(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, int32_t base);
+int32_t blazer_block_decompress_base(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength, int32_t* hashArr, int32_t base);
+// same as blazer_block_compress_offsets with base of positions in hashArr
+int32_t blazer_block_compress_offsets_base(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, int32_t base);
+// same as above functions, crc of read and written data is updated by tracks during processing (tracks can be null)
+int32_t blazer_block_compress_track(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, int32_t base, bool isOffsets, blazer_crc_track* inTrack, blazer_crc_track* outTrack);
+int32_t blazer_block_decompress_track(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength, int32_t* hashArr, int32_t base, blazer_crc_track* inTrack, blazer_crc_track* outTrack);
+int32_t blazer_block_decompress_offsets_track(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength, blazer_crc_track* inTrack, blazer_crc_track* outTrack);
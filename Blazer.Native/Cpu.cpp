@@ -0,0 +1,112 @@
+#include "stdafx.h"
+#include "Cpu.h"
+
+#ifdef BLAZER_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(BLAZER_ARM64) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+static int32_t _features;
+
+#ifdef BLAZER_X86
+static void cpuid(uint32_t leaf, uint32_t* regs)
+{
+#ifdef _MSC_VER
+	__cpuidex((int*)regs, (int)leaf, 0);
+#else
+	__cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// state of registers, which is saved by os on context switch
+static uint64_t xgetbv()
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	uint32_t eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((uint64_t)edx << 32) | eax;
+#endif
+}
+#endif
+
+static void detect_features()
+{
+#ifdef BLAZER_X86
+	uint32_t regs[4];
+	cpuid(0, regs);
+	uint32_t maxLeaf = regs[0];
+	if (maxLeaf < 1)
+		return;
+
+	cpuid(1, regs);
+	int32_t features = 0;
+	if (regs[2] & (1 << 20))
+		features |= BLAZER_CPU_SSE42;
+	if (regs[2] & (1 << 1))
+		features |= BLAZER_CPU_PCLMUL;
+
+	// avx registers can be used only if os saves them (osxsave and xmm/ymm state are enabled)
+	bool osAvx = (regs[2] & (1 << 27)) != 0 && (regs[2] & (1 << 28)) != 0 && (xgetbv() & 6) == 6;
+	// avx-512 also needs opmask and zmm state
+	bool osAvx512 = osAvx && (xgetbv() & 0xe6) == 0xe6;
+	if (osAvx && maxLeaf >= 7)
+	{
+		cpuid(7, regs);
+		if (regs[1] & (1 << 5))
+			features |= BLAZER_CPU_AVX2;
+		if (osAvx512 && (regs[1] & (1 << 16)) && (regs[2] & (1 << 10)) && (features & BLAZER_CPU_PCLMUL))
+			features |= BLAZER_CPU_AVX512_CLMUL;
+	}
+
+	_features = features;
+#elif defined(BLAZER_ARM64)
+#if defined(_WIN32)
+	if (IsProcessorFeaturePresent(PF_ARM_V8_CRC32_INSTRUCTIONS_AVAILABLE))
+		_features = BLAZER_CPU_ARM_CRC32;
+#elif defined(__linux__)
+	if (getauxval(AT_HWCAP) & HWCAP_CRC32)
+		_features = BLAZER_CPU_ARM_CRC32;
+#elif defined(__APPLE__)
+	// all 64-bit Apple processors have crc32 instructions
+	_features = BLAZER_CPU_ARM_CRC32;
+#endif
+#endif
+}
+
+#ifdef _WIN32
+static INIT_ONCE _features_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK detect_features_once(PINIT_ONCE, PVOID, PVOID*)
+{
+	detect_features();
+	return TRUE;
+}
+
+int32_t blazer_cpu_features()
+{
+	InitOnceExecuteOnce(&_features_once, detect_features_once, NULL, NULL);
+	return _features;
+}
+#else
+static pthread_once_t _features_once = PTHREAD_ONCE_INIT;
+
+int32_t blazer_cpu_features()
+{
+	pthread_once(&_features_once, detect_features);
+	return _features;
+}
+#endif
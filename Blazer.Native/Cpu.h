@@ -0,0 +1,36 @@
+// Cpu.h : detection of processor features for runtime selection of optimized code paths
+
+#pragma once
+
+#include "stdafx.h"
+
+#define BLAZER_CPU_SSE42 0x1
+#define BLAZER_CPU_AVX2 0x2
+// carry-less multiplication of 128-bit registers
+#define BLAZER_CPU_PCLMUL 0x4
+// AVX-512F with carry-less multiplication of 512-bit registers (VPCLMULQDQ)
+#define BLAZER_CPU_AVX512_CLMUL 0x8
+// crc32 instructions of ARMv8
+#define BLAZER_CPU_ARM_CRC32 0x10
+
+// gcc and clang require explicit target for extended instruction sets, but we do not want to require them for whole library
+#if defined(BLAZER_X86) && !defined(_MSC_VER)
+#define BLAZER_TARGET_AVX2 __attribute__((target("avx2")))
+#define BLAZER_TARGET_PCLMUL __attribute__((target("sse4.2,pclmul")))
+#define BLAZER_TARGET_AVX512_CLMUL __attribute__((target("sse4.2,pclmul,avx512f,vpclmulqdq")))
+#else
+#define BLAZER_TARGET_AVX2
+#define BLAZER_TARGET_PCLMUL
+#define BLAZER_TARGET_AVX512_CLMUL
+#endif
+
+#if defined(BLAZER_ARM64) && defined(__clang__)
+#define BLAZER_TARGET_ARM_CRC32 __attribute__((target("crc")))
+#elif defined(BLAZER_ARM64) && defined(__GNUC__)
+#define BLAZER_TARGET_ARM_CRC32 __attribute__((target("+crc")))
+#else
+#define BLAZER_TARGET_ARM_CRC32
+#endif
+
+// returns BLAZER_CPU_* flags of current processor, result is detected once and cached
+int32_t blazer_cpu_features();
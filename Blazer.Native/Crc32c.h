@@ -0,0 +1,55 @@
+// Crc32c.h : kernels of crc32c, crc32c_append uses fastest one which is supported by processor
+
+#pragma once
+
+#include "stdafx.h"
+#include "Blazer.h"
+
+// software version with tables
+#define BLAZER_CRC32C_TABLE 0
+// crc instructions of SSE 4.2 or ARMv8
+#define BLAZER_CRC32C_HW 1
+// folding by carry-less multiplication of 128-bit registers
+#define BLAZER_CRC32C_PCLMUL 2
+// folding by carry-less multiplication of 512-bit registers
+#define BLAZER_CRC32C_AVX512 3
+
+typedef uint32_t (*blazer_crc32c_func)(uint32_t crc, const uint8_t* input, size_t length);
+
+// returns kernel (same interface as crc32c_append) or null if it is not supported by processor or platform
+blazer_crc32c_func blazer_crc32c_kernel(int32_t kernel);
+
+// crc of data which is read or written sequentially by codec loop. It is updated by chunks right after they are
+// processed (while they are in cache), so large blocks are not read again from memory for checksum
+struct blazer_crc_track
+{
+	// start of data which is not added to crc yet
+	const unsigned char* pos;
+	uint32_t crc;
+};
+
+#define BLAZER_CRC_TRACK_CHUNK (16 * 1024)
+
+static BLAZER_INLINE void blazer_crc_track_init(blazer_crc_track* track, const unsigned char* start)
+{
+	track->pos = start;
+	track->crc = 0;
+}
+
+// adds data up to end if it is not shorter than chunk
+static BLAZER_INLINE void blazer_crc_track_step(blazer_crc_track* track, const unsigned char* end)
+{
+	if (end - track->pos >= BLAZER_CRC_TRACK_CHUNK)
+	{
+		track->crc = crc32c_append(track->crc, track->pos, (size_t)(end - track->pos));
+		track->pos = end;
+	}
+}
+
+// adds rest of data and returns crc
+static BLAZER_INLINE uint32_t blazer_crc_track_finish(blazer_crc_track* track, const unsigned char* end)
+{
+	track->crc = crc32c_append(track->crc, track->pos, (size_t)(end - track->pos));
+	track->pos = end;
+	return track->crc;
+}
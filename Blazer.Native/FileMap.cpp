@@ -0,0 +1,332 @@
+#include "stdafx.h"
+#include "FileMap.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// writes are done by whole pages of file system cache
+#define WRITE_ALIGN (64 << 10)
+#define MIN_WRITE_BUFFER (4 << 20)
+
+#ifdef _WIN32
+// converts UTF-8 path into allocated wide string
+static wchar_t* to_wide_path(const char* path)
+{
+	int len = MultiByteToWideChar(CP_UTF8, 0, path, -1, NULL, 0);
+	if (len <= 0)
+		return NULL;
+	wchar_t* wide = (wchar_t*)blazer_alloc_zero(sizeof(wchar_t) * len);
+	if (wide != NULL && MultiByteToWideChar(CP_UTF8, 0, path, -1, wide, len) != len)
+	{
+		blazer_free(wide);
+		return NULL;
+	}
+
+	return wide;
+}
+
+static HANDLE open_file(const char* path, DWORD access, DWORD creation, DWORD flags)
+{
+	wchar_t* wide = to_wide_path(path);
+	if (wide == NULL)
+		return INVALID_HANDLE_VALUE;
+	HANDLE file = CreateFileW(wide, access, FILE_SHARE_READ, NULL, creation, flags, NULL);
+	blazer_free(wide);
+	return file;
+}
+#endif
+
+bool blazer_map_file(blazer_mapped_file* file, const char* path)
+{
+	file->data = NULL;
+	file->length = 0;
+#ifdef _WIN32
+	file->mapping = NULL;
+	file->file = open_file(path, GENERIC_READ, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN);
+	if (file->file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file->file, &size) || (uint64_t)size.QuadPart > (size_t)-1)
+	{
+		blazer_unmap_file(file);
+		return false;
+	}
+
+	file->length = size.QuadPart;
+	// empty file cannot be mapped
+	if (file->length == 0)
+		return true;
+
+	file->mapping = CreateFileMappingW(file->file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (file->mapping != NULL)
+		file->data = (const unsigned char*)MapViewOfFile(file->mapping, FILE_MAP_READ, 0, 0, 0);
+	if (file->data == NULL)
+	{
+		blazer_unmap_file(file);
+		return false;
+	}
+
+	return true;
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (uint64_t)st.st_size > (size_t)-1)
+	{
+		close(fd);
+		return false;
+	}
+
+	file->length = st.st_size;
+	if (file->length > 0)
+	{
+		void* data = mmap(NULL, (size_t)file->length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED)
+		{
+			// read ahead is larger for sequential access and pages are freed earlier
+			madvise(data, (size_t)file->length, MADV_SEQUENTIAL);
+			file->data = (const unsigned char*)data;
+		}
+	}
+
+	// mapping keeps reference to file
+	close(fd);
+	return file->length == 0 || file->data != NULL;
+#endif
+}
+
+void blazer_unmap_file(blazer_mapped_file* file)
+{
+#ifdef _WIN32
+	if (file->data != NULL)
+		UnmapViewOfFile(file->data);
+	if (file->mapping != NULL)
+		CloseHandle(file->mapping);
+	if (file->file != INVALID_HANDLE_VALUE)
+		CloseHandle(file->file);
+	file->mapping = NULL;
+	file->file = INVALID_HANDLE_VALUE;
+#else
+	if (file->data != NULL)
+		munmap((void*)file->data, (size_t)file->length);
+#endif
+	file->data = NULL;
+	file->length = 0;
+}
+
+bool blazer_writer_open(blazer_file_writer* writer, const char* path, int64_t minCapacity)
+{
+	// buffer has space for aligned chunk and rest of previous chunk
+	int64_t capacity = minCapacity + WRITE_ALIGN;
+	if (capacity < MIN_WRITE_BUFFER)
+		capacity = MIN_WRITE_BUFFER;
+	capacity = (capacity + WRITE_ALIGN - 1) & ~(int64_t)(WRITE_ALIGN - 1);
+
+	writer->pos = 0;
+	writer->written = 0;
+	writer->capacity = capacity;
+	// buffer is aligned to page for direct transfer by kernel
+	writer->allocated = blazer_alloc_zero((size_t)capacity + 4096);
+	if (writer->allocated == NULL)
+		return false;
+	writer->buffer = (unsigned char*)(((size_t)writer->allocated + 4095) & ~(size_t)4095);
+
+#ifdef _WIN32
+	writer->file = open_file(path, GENERIC_WRITE, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN);
+	if (writer->file != INVALID_HANDLE_VALUE)
+		return true;
+#else
+	writer->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (writer->fd >= 0)
+		return true;
+#endif
+
+	blazer_free(writer->allocated);
+	writer->allocated = NULL;
+	return false;
+}
+
+static bool write_all(blazer_file_writer* writer, const unsigned char* data, int64_t length)
+{
+	while (length > 0)
+	{
+#ifdef _WIN32
+		DWORD cnt = length > 0x40000000 ? 0x40000000 : (DWORD)length;
+		DWORD res;
+		if (!WriteFile(writer->file, data, cnt, &res, NULL) || res == 0)
+			return false;
+#else
+		size_t cnt = length > 0x40000000 ? 0x40000000 : (size_t)length;
+		ssize_t res = write(writer->fd, data, cnt);
+		if (res < 0 && errno == EINTR)
+			continue;
+		if (res <= 0)
+			return false;
+#endif
+		data += res;
+		length -= res;
+		writer->written += res;
+	}
+
+	return true;
+}
+
+bool blazer_writer_flush(blazer_file_writer* writer, bool final)
+{
+	int64_t cnt = final ? writer->pos : writer->pos & ~(int64_t)(WRITE_ALIGN - 1);
+	if (!write_all(writer, writer->buffer, cnt))
+		return false;
+
+	blazer_move_down(writer->buffer, writer->buffer + cnt, (size_t)(writer->pos - cnt));
+	writer->pos -= cnt;
+	return true;
+}
+
+unsigned char* blazer_writer_reserve(blazer_file_writer* writer, int64_t length)
+{
+	if (writer->capacity - writer->pos < length && !blazer_writer_flush(writer, false))
+		return NULL;
+	if (writer->capacity - writer->pos >= length)
+		return writer->buffer + writer->pos;
+
+	// rest of aligned chunk is kept, so buffer grows to same layout as in blazer_writer_open
+	int64_t capacity = (length + 2 * WRITE_ALIGN - 1) & ~(int64_t)(WRITE_ALIGN - 1);
+	void* allocated = blazer_alloc_zero((size_t)capacity + 4096);
+	if (allocated == NULL)
+		return NULL;
+	unsigned char* buffer = (unsigned char*)(((size_t)allocated + 4095) & ~(size_t)4095);
+	memcpy(buffer, writer->buffer, (size_t)writer->pos);
+	blazer_free(writer->allocated);
+	writer->allocated = allocated;
+	writer->buffer = buffer;
+	writer->capacity = capacity;
+	return writer->buffer + writer->pos;
+}
+
+void blazer_writer_close(blazer_file_writer* writer)
+{
+#ifdef _WIN32
+	CloseHandle(writer->file);
+#else
+	close(writer->fd);
+#endif
+	blazer_free(writer->allocated);
+	writer->allocated = NULL;
+}
+
+bool blazer_file_open_read(blazer_file* file, const char* path, int64_t* length)
+{
+#ifdef _WIN32
+	file->handle = open_file(path, GENERIC_READ, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN);
+	if (file->handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file->handle, &size))
+	{
+		blazer_file_close(file);
+		return false;
+	}
+
+	*length = size.QuadPart;
+	return true;
+#else
+	file->fd = open(path, O_RDONLY);
+	if (file->fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(file->fd, &st) != 0)
+	{
+		blazer_file_close(file);
+		return false;
+	}
+
+	*length = st.st_size;
+	posix_fadvise(file->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	return true;
+#endif
+}
+
+bool blazer_file_open_write(blazer_file* file, const char* path)
+{
+#ifdef _WIN32
+	file->handle = open_file(path, GENERIC_WRITE, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN);
+	return file->handle != INVALID_HANDLE_VALUE;
+#else
+	file->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	return file->fd >= 0;
+#endif
+}
+
+bool blazer_file_read_at(blazer_file* file, unsigned char* buffer, int64_t length, int64_t offset)
+{
+	while (length > 0)
+	{
+#ifdef _WIN32
+		// offset of overlapped structure is used by synchronous handle too
+		OVERLAPPED overlapped;
+		memset(&overlapped, 0, sizeof(overlapped));
+		overlapped.Offset = (DWORD)offset;
+		overlapped.OffsetHigh = (DWORD)(offset >> 32);
+		DWORD res;
+		if (!ReadFile(file->handle, buffer, length > 0x40000000 ? 0x40000000 : (DWORD)length, &res, &overlapped) || res == 0)
+			return false;
+#else
+		ssize_t res = pread(file->fd, buffer, length > 0x40000000 ? 0x40000000 : (size_t)length, offset);
+		if (res < 0 && errno == EINTR)
+			continue;
+		if (res <= 0)
+			return false;
+#endif
+		buffer += res;
+		length -= res;
+		offset += res;
+	}
+
+	return true;
+}
+
+bool blazer_file_write_at(blazer_file* file, const unsigned char* buffer, int64_t length, int64_t offset)
+{
+	while (length > 0)
+	{
+#ifdef _WIN32
+		OVERLAPPED overlapped;
+		memset(&overlapped, 0, sizeof(overlapped));
+		overlapped.Offset = (DWORD)offset;
+		overlapped.OffsetHigh = (DWORD)(offset >> 32);
+		DWORD res;
+		if (!WriteFile(file->handle, buffer, length > 0x40000000 ? 0x40000000 : (DWORD)length, &res, &overlapped) || res == 0)
+			return false;
+#else
+		ssize_t res = pwrite(file->fd, buffer, length > 0x40000000 ? 0x40000000 : (size_t)length, offset);
+		if (res < 0 && errno == EINTR)
+			continue;
+		if (res <= 0)
+			return false;
+#endif
+		buffer += res;
+		length -= res;
+		offset += res;
+	}
+
+	return true;
+}
+
+void blazer_file_close(blazer_file* file)
+{
+#ifdef _WIN32
+	CloseHandle(file->handle);
+#else
+	close(file->fd);
+#endif
+}
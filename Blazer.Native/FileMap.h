@@ -0,0 +1,78 @@
+// FileMap.h : memory mapped input files, buffered output files and files with positioned access for file functions
+// Windows build does not use CRT, so only kernel32 functions are used there
+
+#pragma once
+
+#include "stdafx.h"
+
+struct blazer_mapped_file
+{
+	// NULL for empty file
+	const unsigned char* data;
+	int64_t length;
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#endif
+};
+
+// maps whole file for reading with hint of sequential access, returns false if file cannot be opened or mapped
+bool blazer_map_file(blazer_mapped_file* file, const char* path);
+
+void blazer_unmap_file(blazer_mapped_file* file);
+
+// output file with buffer, data is written into buffer directly and buffer is written by aligned chunks
+struct blazer_file_writer
+{
+	unsigned char* buffer;
+	int64_t capacity;
+	int64_t pos;
+	int64_t written;
+	void* allocated;
+#ifdef _WIN32
+	HANDLE file;
+#else
+	int fd;
+#endif
+};
+
+// creates or truncates file, buffer has at least minCapacity bytes. Returns false if file cannot be created
+bool blazer_writer_open(blazer_file_writer* writer, const char* path, int64_t minCapacity);
+
+// writes aligned part of buffered data (or all data if final) and moves rest to start of buffer
+bool blazer_writer_flush(blazer_file_writer* writer, bool final);
+
+// returns pointer to free space of buffer with at least length bytes (buffer grows if length is greater than minCapacity
+// of blazer_writer_open), or NULL on write or allocation error. Data is written after blazer_writer_commit
+unsigned char* blazer_writer_reserve(blazer_file_writer* writer, int64_t length);
+
+static BLAZER_INLINE void blazer_writer_commit(blazer_file_writer* writer, int64_t length)
+{
+	writer->pos += length;
+}
+
+// closes file without writing of buffered data
+void blazer_writer_close(blazer_file_writer* writer);
+
+// file for positioned reads and writes from several threads
+struct blazer_file
+{
+#ifdef _WIN32
+	HANDLE handle;
+#else
+	int fd;
+#endif
+};
+
+// opens existing file for reading and returns its length
+bool blazer_file_open_read(blazer_file* file, const char* path, int64_t* length);
+
+// creates or truncates file for writing
+bool blazer_file_open_write(blazer_file* file, const char* path);
+
+// reads length bytes at offset, returns false on error or end of file
+bool blazer_file_read_at(blazer_file* file, unsigned char* buffer, int64_t length, int64_t offset);
+
+bool blazer_file_write_at(blazer_file* file, const unsigned char* buffer, int64_t length, int64_t offset);
+
+void blazer_file_close(blazer_file* file);
@@ -0,0 +1,27 @@
+// FrameIndex.h : index of blocks of framed format, which is written by encoder before footer.
+// Index is stored in control data blocks, so decoders without index support skip it. Payload of blocks:
+// 'bIdx', entry count (4 bytes), total length of data (8 bytes), entries, size of all index blocks with headers (4 bytes), 'bIdx'.
+// Entry points to block which can be decoded without previous data: offset of its header in file (8 bytes),
+// offset of its data in uncompressed stream (8 bytes) and CRC32C of uncompressed data up to next entry (4 bytes).
+// All values are little-endian, trailer is never split between blocks, so index can be found from end of file
+
+#pragma once
+
+#include "stdafx.h"
+
+#define BLAZER_INDEX_HEADER_SIZE 16
+#define BLAZER_INDEX_ENTRY_SIZE 20
+#define BLAZER_INDEX_TRAILER_SIZE 8
+
+struct blazer_index_entry
+{
+	int64_t compressedOffset;
+	int64_t uncompressedOffset;
+	uint32_t crc;
+};
+
+// size of all index blocks with headers for entryCount entries
+int64_t blazer_index_size(int64_t entryCount, int32_t blockSize, int32_t blockHeaderSize);
+
+// writes index blocks into out (it should have blazer_index_size bytes), returns count of written bytes
+int64_t blazer_index_write(const blazer_index_entry* entries, int64_t entryCount, int64_t totalLength, int32_t blockSize, bool includeCrc, unsigned char* out);
@@ -0,0 +1,172 @@
+#include "stdafx.h"
+#include "IoRing.h"
+
+#ifdef BLAZER_IO_URING
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+bool blazer_io_ring_setup(blazer_io_ring* ring, uint32_t entries)
+{
+	memset(ring, 0, sizeof(blazer_io_ring));
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	// can be forbidden by seccomp filters of containers, caller falls back to threads in this case
+	ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+	if (ring->fd < 0)
+		return false;
+
+	ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+	ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	// newer kernels map both rings by one call
+	if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0 && ring->cqRingSize > ring->sqRingSize)
+		ring->sqRingSize = ring->cqRingSize;
+
+	ring->sqRing = mmap(NULL, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	if (ring->sqRing == MAP_FAILED)
+	{
+		ring->sqRing = NULL;
+		blazer_io_ring_destroy(ring);
+		return false;
+	}
+
+	if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0)
+	{
+		ring->cqRing = ring->sqRing;
+	}
+	else
+	{
+		ring->cqRing = mmap(NULL, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+		if (ring->cqRing == MAP_FAILED)
+		{
+			ring->cqRing = NULL;
+			blazer_io_ring_destroy(ring);
+			return false;
+		}
+	}
+
+	ring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+	void* sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if (sqes == MAP_FAILED)
+	{
+		blazer_io_ring_destroy(ring);
+		return false;
+	}
+
+	unsigned char* sq = (unsigned char*)ring->sqRing;
+	unsigned char* cq = (unsigned char*)ring->cqRing;
+	ring->sqes = (struct io_uring_sqe*)sqes;
+	ring->sqHead = (uint32_t*)(sq + params.sq_off.head);
+	ring->sqTail = (uint32_t*)(sq + params.sq_off.tail);
+	ring->sqMask = *(uint32_t*)(sq + params.sq_off.ring_mask);
+	ring->sqArray = (uint32_t*)(sq + params.sq_off.array);
+	ring->sqEntries = params.sq_entries;
+	ring->cqHead = (uint32_t*)(cq + params.cq_off.head);
+	ring->cqTail = (uint32_t*)(cq + params.cq_off.tail);
+	ring->cqMask = *(uint32_t*)(cq + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+	return true;
+}
+
+void blazer_io_ring_destroy(blazer_io_ring* ring)
+{
+	if (ring->sqes != NULL)
+		munmap(ring->sqes, ring->sqesSize);
+	if (ring->cqRing != NULL && ring->cqRing != ring->sqRing)
+		munmap(ring->cqRing, ring->cqRingSize);
+	if (ring->sqRing != NULL)
+		munmap(ring->sqRing, ring->sqRingSize);
+	if (ring->fd >= 0)
+		close(ring->fd);
+	memset(ring, 0, sizeof(blazer_io_ring));
+	ring->fd = -1;
+}
+
+bool blazer_io_ring_prepare(blazer_io_ring* ring, bool write, int fd, struct iovec* iov, int64_t offset, uint64_t userData)
+{
+	// only this thread writes tail, kernel moves head
+	uint32_t tail = *ring->sqTail;
+	if (tail - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE) >= ring->sqEntries)
+		return false;
+
+	uint32_t idx = tail & ring->sqMask;
+	struct io_uring_sqe* sqe = &ring->sqes[idx];
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+	// vectored variants are supported by first kernels with io_uring (5.1)
+	sqe->opcode = write ? IORING_OP_WRITEV : IORING_OP_READV;
+	sqe->fd = fd;
+	sqe->off = (uint64_t)offset;
+	sqe->addr = (uint64_t)(uintptr_t)iov;
+	sqe->len = 1;
+	sqe->user_data = userData;
+	ring->sqArray[idx] = idx;
+	__atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+	ring->prepared++;
+	return true;
+}
+
+bool blazer_io_ring_submit(blazer_io_ring* ring, uint32_t waitCount)
+{
+	for (;;)
+	{
+		int res = (int)syscall(__NR_io_uring_enter, ring->fd, ring->prepared, waitCount, waitCount > 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+		if (res >= 0)
+		{
+			ring->prepared -= (uint32_t)res;
+			// all requests are submitted if completions are awaited
+			if (ring->prepared == 0 || waitCount == 0)
+				return true;
+			continue;
+		}
+
+		if (errno != EINTR)
+			return false;
+	}
+}
+
+bool blazer_io_ring_complete(blazer_io_ring* ring, uint64_t* userData, int32_t* result)
+{
+	uint32_t head = *ring->cqHead;
+	if (head == __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE))
+		return false;
+
+	struct io_uring_cqe* cqe = &ring->cqes[head & ring->cqMask];
+	*userData = cqe->user_data;
+	*result = cqe->res;
+	__atomic_store_n(ring->cqHead, head + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+#else
+
+bool blazer_io_ring_setup(blazer_io_ring* ring, uint32_t entries)
+{
+	(void)ring;
+	(void)entries;
+	return false;
+}
+
+void blazer_io_ring_destroy(blazer_io_ring* ring)
+{
+	(void)ring;
+}
+
+bool blazer_io_ring_submit(blazer_io_ring* ring, uint32_t waitCount)
+{
+	(void)ring;
+	(void)waitCount;
+	return false;
+}
+
+bool blazer_io_ring_complete(blazer_io_ring* ring, uint64_t* userData, int32_t* result)
+{
+	(void)ring;
+	(void)userData;
+	(void)result;
+	return false;
+}
+
+#endif
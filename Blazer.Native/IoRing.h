@@ -0,0 +1,54 @@
+// IoRing.h : minimal io_uring queues for file pipeline, system calls are used directly without liburing.
+// Ring is available only on Linux with io_uring headers (BLAZER_IO_URING), otherwise setup always fails
+// and callers should use blocking reads and writes
+
+#pragma once
+
+#include "stdafx.h"
+
+#ifdef BLAZER_IO_URING
+#include <sys/uio.h>
+#endif
+
+struct blazer_io_ring
+{
+#ifdef BLAZER_IO_URING
+	int fd;
+	uint32_t* sqHead;
+	uint32_t* sqTail;
+	uint32_t sqMask;
+	uint32_t* sqArray;
+	struct io_uring_sqe* sqes;
+	uint32_t sqEntries;
+	uint32_t* cqHead;
+	uint32_t* cqTail;
+	uint32_t cqMask;
+	struct io_uring_cqe* cqes;
+	void* sqRing;
+	size_t sqRingSize;
+	void* cqRing;
+	size_t cqRingSize;
+	size_t sqesSize;
+	// prepared requests, which are not submitted yet
+	uint32_t prepared;
+#else
+	int32_t unused;
+#endif
+};
+
+// creates ring with at least entries requests in flight, returns false if io_uring is not supported by system
+bool blazer_io_ring_setup(blazer_io_ring* ring, uint32_t entries);
+
+void blazer_io_ring_destroy(blazer_io_ring* ring);
+
+#ifdef BLAZER_IO_URING
+// prepares vectored read or write at offset of file, iov should not be changed until completion.
+// Returns false if submission queue is full
+bool blazer_io_ring_prepare(blazer_io_ring* ring, bool write, int fd, struct iovec* iov, int64_t offset, uint64_t userData);
+#endif
+
+// submits prepared requests and waits for at least waitCount completions, returns false on error
+bool blazer_io_ring_submit(blazer_io_ring* ring, uint32_t waitCount);
+
+// takes next completion (result is count of transferred bytes or negative errno), returns false if there are no completions
+bool blazer_io_ring_complete(blazer_io_ring* ring, uint64_t* userData, int32_t* result);
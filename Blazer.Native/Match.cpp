@@ -0,0 +1,64 @@
+#include "stdafx.h"
+#include "Match.h"
+#include "Cpu.h"
+
+#ifdef BLAZER_X86
+#include <immintrin.h>
+#endif
+
+// compares by 8 bytes, first different byte is lowest one in little-endian data
+static int32_t long_match8(const unsigned char* src, const unsigned char* cur, const unsigned char* curEnd)
+{
+	const unsigned char* curStart = cur;
+	while (curEnd - cur >= 8)
+	{
+		uint64_t a, b;
+		memcpy(&a, src, 8);
+		memcpy(&b, cur, 8);
+		uint64_t diff = a ^ b;
+		if (diff != 0)
+		{
+			uint32_t low = (uint32_t)diff;
+			int32_t bit = low != 0 ? blazer_ctz32(low) : 32 + blazer_ctz32((uint32_t)(diff >> 32));
+			return (int32_t)(cur - curStart) + (bit >> 3);
+		}
+
+		src += 8;
+		cur += 8;
+	}
+
+	while (cur < curEnd && *src == *cur)
+	{
+		src++;
+		cur++;
+	}
+
+	return (int32_t)(cur - curStart);
+}
+
+#ifdef BLAZER_X86
+BLAZER_TARGET_AVX2 static int32_t long_match32(const unsigned char* src, const unsigned char* cur, const unsigned char* curEnd)
+{
+	const unsigned char* curStart = cur;
+	while (curEnd - cur >= 32)
+	{
+		__m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)src), _mm256_loadu_si256((const __m256i*)cur));
+		uint32_t diff = ~(uint32_t)_mm256_movemask_epi8(eq);
+		if (diff != 0)
+			return (int32_t)(cur - curStart) + blazer_ctz32(diff);
+		src += 32;
+		cur += 32;
+	}
+
+	return (int32_t)(cur - curStart) + long_match8(src, cur, curEnd);
+}
+#endif
+
+blazer_long_match_func blazer_get_long_match()
+{
+#ifdef BLAZER_X86
+	if (blazer_cpu_features() & BLAZER_CPU_AVX2)
+		return long_match32;
+#endif
+	return long_match8;
+}
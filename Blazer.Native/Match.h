@@ -0,0 +1,75 @@
+// Match.h : search of match length for encoders
+// Data is compared by 16 bytes with SSE2 (4 bytes otherwise), long matches are extended by kernel selected for current processor
+
+#pragma once
+
+#include "stdafx.h"
+
+#ifdef BLAZER_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// matches, which are not finished after this count of bytes are extended by blazer_long_match_func
+#define BLAZER_LONG_MATCH 64
+
+// index of lowest set bit, value should not be zero
+static BLAZER_INLINE int32_t blazer_ctz32(uint32_t value)
+{
+#ifdef _MSC_VER
+	unsigned long idx;
+	_BitScanForward(&idx, value);
+	return (int32_t)idx;
+#else
+	return __builtin_ctz(value);
+#endif
+}
+
+typedef int32_t (*blazer_long_match_func)(const unsigned char* src, const unsigned char* cur, const unsigned char* curEnd);
+
+// returns best kernel for extending long matches on current processor
+blazer_long_match_func blazer_get_long_match();
+
+// returns count of equal bytes at src and cur, cur is not read after curEnd. src should be before cur
+static BLAZER_INLINE int32_t blazer_match_length(const unsigned char* src, const unsigned char* cur, const unsigned char* curEnd, blazer_long_match_func longMatch)
+{
+	const unsigned char* curStart = cur;
+	const unsigned char* curLong = curEnd - cur > BLAZER_LONG_MATCH ? cur + BLAZER_LONG_MATCH : curEnd;
+#ifdef BLAZER_SSE2
+	while (curLong - cur >= 16)
+	{
+		__m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)src), _mm_loadu_si128((const __m128i*)cur));
+		uint32_t diff = (uint32_t)_mm_movemask_epi8(eq) ^ 0xffff;
+		if (diff != 0)
+			return (int32_t)(cur - curStart) + blazer_ctz32(diff);
+		src += 16;
+		cur += 16;
+	}
+#else
+	while (curLong - cur >= 4)
+	{
+		uint32_t a, b;
+		memcpy(&a, src, 4);
+		memcpy(&b, cur, 4);
+		// data is little-endian, so first different byte is lowest one
+		if (a != b)
+			return (int32_t)(cur - curStart) + (blazer_ctz32(a ^ b) >> 3);
+		src += 4;
+		cur += 4;
+	}
+#endif
+
+	if (cur == curLong && cur < curEnd)
+		return (int32_t)(cur - curStart) + longMatch(src, cur, curEnd);
+
+	while (cur < curEnd && *src == *cur)
+	{
+		src++;
+		cur++;
+	}
+
+	return (int32_t)(cur - curStart);
+}
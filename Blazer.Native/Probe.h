@@ -0,0 +1,22 @@
+// Probe.h : fast estimation of compressibility of block before compression
+// Segments spread over block are searched for repeats in small hash table, which also has every few positions of data
+// between segments and of history, so share of segments covered by repeats is close to share of block covered by matches
+
+#pragma once
+
+#include "stdafx.h"
+
+#define BLAZER_PROBE_HASH_BITS 14
+#define BLAZER_PROBE_HASH_SIZE (1 << BLAZER_PROBE_HASH_BITS)
+
+// blocks with less repeats (per 1000 bytes) are compressed by less than 5%, so they are stored as is
+#define BLAZER_PROBE_RAW_MAX 50
+// blocks with more repeats gain most from deeper search of high encoder
+#define BLAZER_PROBE_HIGH_MIN 800
+// length of history before block, which is added to table of probe
+#define BLAZER_PROBE_HISTORY (64 * 1024)
+
+// returns count of bytes per 1000 of sampled segments of data[dataOffset..dataLength), which are covered by repeats.
+// Data before dataOffset is history, which can be repeated. hashArr should contain BLAZER_PROBE_HASH_SIZE elements,
+// it is cleared by this function
+int32_t blazer_probe_repeats(const unsigned char* data, int32_t dataOffset, int32_t dataLength, int32_t* hashArr);
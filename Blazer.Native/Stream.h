@@ -0,0 +1,17 @@
+// Stream.h : internal functions of stream algorithm for hash tables, which are primed by data of dictionary.
+// Compression of block changes only entries of its own positions, so table is returned to primed state
+// by restoring of these entries instead of copying of whole table
+
+#pragma once
+
+#include "stdafx.h"
+#include "Crc32c.h"
+
+// restores entries of hashArr, which can be changed by compression of bufferIn[bufferInOffset..bufferInLength) with level
+// and bufferInShift, from origHashArr. bufferIn should have BLAZER_DECOMPRESS_MARGIN readable bytes after data
+void blazer_stream_restore_hash(const unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, int32_t bufferInShift, int32_t* hashArr, const int32_t* origHashArr, int32_t level);
+
+// same as blazer_stream_compress_block_level and blazer_stream_decompress_block, crc of read and written data is updated
+// by tracks during processing (tracks can be null, they are not updated by high levels)
+int32_t blazer_stream_compress_track(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, int32_t bufferInShift, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, int32_t level, blazer_crc_track* inTrack, blazer_crc_track* outTrack);
+int32_t blazer_stream_decompress_track(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t bufferOutLength, blazer_crc_track* inTrack, blazer_crc_track* outTrack);
@@ -0,0 +1,20 @@
+// StreamHigh.h : high compression encoder of stream algorithm (native variant of StreamEncoderHigh)
+// Matches are searched by hash chains with lazy matching, data is written in standard stream format
+
+#pragma once
+
+#include "stdafx.h"
+
+#define BLAZER_HIGH_HASH_BITS 16
+// chains are 16-bit distances, so back references of chains are limited by this length (instead of 65792)
+#define BLAZER_HIGH_CHAIN_LEN (1 << 16)
+// hash array contains 32-bit heads of chains and then 16-bit chains
+#define BLAZER_HIGH_HASH_SIZE ((1 << BLAZER_HIGH_HASH_BITS) + BLAZER_HIGH_CHAIN_LEN / 2)
+
+// parameters are same as for blazer_stream_compress_block, hashArr should contain BLAZER_HIGH_HASH_SIZE elements.
+// maxDepth is maximum count of checked positions in chain, lazyDepth is count of next positions, which are checked for better match.
+// Search and lazy matching are stopped on sequences of niceLen bytes
+int32_t blazer_stream_compress_high(unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, int32_t bufferInShift, unsigned char* bufferOut, int32_t bufferOutOffset, int32_t* hashArr, int32_t maxDepth, int32_t lazyDepth, int32_t niceLen);
+
+// same as blazer_stream_restore_hash for hash table of high encoder: heads of positions and their chains are restored
+void blazer_stream_high_restore_hash(const unsigned char* bufferIn, int32_t bufferInOffset, int32_t bufferInLength, int32_t bufferInShift, int32_t* hashArr, const int32_t* origHashArr);
@@ -0,0 +1,173 @@
+#include "stdafx.h"
+#include "Threading.h"
+
+#ifndef _WIN32
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+static DWORD WINAPI thread_proc(LPVOID arg)
+{
+	blazer_thread* thread = (blazer_thread*)arg;
+	thread->func(thread->arg);
+	return 0;
+}
+#else
+static void* thread_proc(void* arg)
+{
+	blazer_thread* thread = (blazer_thread*)arg;
+	thread->func(thread->arg);
+	return NULL;
+}
+#endif
+
+bool blazer_thread_start(blazer_thread* thread, blazer_thread_func func, void* arg)
+{
+	thread->func = func;
+	thread->arg = arg;
+#ifdef _WIN32
+	thread->handle = CreateThread(NULL, 0, thread_proc, thread, 0, NULL);
+	return thread->handle != NULL;
+#else
+	return pthread_create(&thread->handle, NULL, thread_proc, thread) == 0;
+#endif
+}
+
+void blazer_thread_join(blazer_thread* thread)
+{
+#ifdef _WIN32
+	WaitForSingleObject(thread->handle, INFINITE);
+	CloseHandle(thread->handle);
+#else
+	pthread_join(thread->handle, NULL);
+#endif
+}
+
+int32_t blazer_cpu_count()
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int32_t)info.dwNumberOfProcessors;
+#else
+	long cnt = sysconf(_SC_NPROCESSORS_ONLN);
+	return cnt > 0 ? (int32_t)cnt : 1;
+#endif
+}
+
+void blazer_run_parallel(blazer_thread_func func, void* arg, int32_t threadCount, int32_t maxThreads)
+{
+	if (threadCount <= 0)
+		threadCount = blazer_cpu_count();
+	if (threadCount > maxThreads)
+		threadCount = maxThreads;
+
+	int32_t extraCount = threadCount - 1;
+	blazer_thread* threads = 0;
+	if (extraCount > 0)
+	{
+		threads = (blazer_thread*)blazer_alloc_zero(sizeof(blazer_thread) * extraCount);
+		if (threads == 0)
+			extraCount = 0;
+	}
+
+	int32_t started = 0;
+	while (started < extraCount && blazer_thread_start(&threads[started], func, arg))
+		started++;
+
+	func(arg);
+
+	for (int32_t i = 0; i < started; i++)
+		blazer_thread_join(&threads[i]);
+	if (threads != 0)
+		blazer_free(threads);
+}
+
+void blazer_mutex_init(blazer_mutex* mutex)
+{
+#ifdef _WIN32
+	InitializeSRWLock(&mutex->lock);
+#else
+	pthread_mutex_init(&mutex->lock, NULL);
+#endif
+}
+
+void blazer_mutex_destroy(blazer_mutex* mutex)
+{
+#ifndef _WIN32
+	pthread_mutex_destroy(&mutex->lock);
+#else
+	(void)mutex;
+#endif
+}
+
+void blazer_mutex_lock(blazer_mutex* mutex)
+{
+#ifdef _WIN32
+	AcquireSRWLockExclusive(&mutex->lock);
+#else
+	pthread_mutex_lock(&mutex->lock);
+#endif
+}
+
+void blazer_mutex_unlock(blazer_mutex* mutex)
+{
+#ifdef _WIN32
+	ReleaseSRWLockExclusive(&mutex->lock);
+#else
+	pthread_mutex_unlock(&mutex->lock);
+#endif
+}
+
+void blazer_cond_init(blazer_cond* cond)
+{
+#ifdef _WIN32
+	InitializeConditionVariable(&cond->cond);
+#else
+	pthread_cond_init(&cond->cond, NULL);
+#endif
+}
+
+void blazer_cond_destroy(blazer_cond* cond)
+{
+#ifndef _WIN32
+	pthread_cond_destroy(&cond->cond);
+#else
+	(void)cond;
+#endif
+}
+
+void blazer_cond_wait(blazer_cond* cond, blazer_mutex* mutex)
+{
+#ifdef _WIN32
+	SleepConditionVariableSRW(&cond->cond, &mutex->lock, INFINITE, 0);
+#else
+	pthread_cond_wait(&cond->cond, &mutex->lock);
+#endif
+}
+
+void blazer_cond_broadcast(blazer_cond* cond)
+{
+#ifdef _WIN32
+	WakeAllConditionVariable(&cond->cond);
+#else
+	pthread_cond_broadcast(&cond->cond);
+#endif
+}
+
+int64_t blazer_time_ns()
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter;
+	LARGE_INTEGER frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	// split to avoid overflow of counter * 10^9
+	return counter.QuadPart / frequency.QuadPart * 1000000000 + counter.QuadPart % frequency.QuadPart * 1000000000 / frequency.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
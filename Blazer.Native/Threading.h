@@ -0,0 +1,97 @@
+// Threading.h : minimal threading primitives for parallel codecs
+// Windows build does not use CRT, so only kernel32 functions are used there
+
+#pragma once
+
+#include "stdafx.h"
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+typedef void (*blazer_thread_func)(void* arg);
+
+struct blazer_thread
+{
+#ifdef _WIN32
+	HANDLE handle;
+#else
+	pthread_t handle;
+#endif
+	blazer_thread_func func;
+	void* arg;
+};
+
+// starts new thread, returns false if thread cannot be created
+bool blazer_thread_start(blazer_thread* thread, blazer_thread_func func, void* arg);
+
+void blazer_thread_join(blazer_thread* thread);
+
+// lock and condition for waiting of state changes, both should be initialized before use and destroyed after
+struct blazer_mutex
+{
+#ifdef _WIN32
+	SRWLOCK lock;
+#else
+	pthread_mutex_t lock;
+#endif
+};
+
+struct blazer_cond
+{
+#ifdef _WIN32
+	CONDITION_VARIABLE cond;
+#else
+	pthread_cond_t cond;
+#endif
+};
+
+void blazer_mutex_init(blazer_mutex* mutex);
+void blazer_mutex_destroy(blazer_mutex* mutex);
+void blazer_mutex_lock(blazer_mutex* mutex);
+void blazer_mutex_unlock(blazer_mutex* mutex);
+
+void blazer_cond_init(blazer_cond* cond);
+void blazer_cond_destroy(blazer_cond* cond);
+// releases locked mutex while waiting, mutex is locked again on return. Wake ups can be spurious
+void blazer_cond_wait(blazer_cond* cond, blazer_mutex* mutex);
+void blazer_cond_broadcast(blazer_cond* cond);
+
+// monotonic time in nanoseconds for statistics
+int64_t blazer_time_ns();
+
+// count of logical processors available for process
+int32_t blazer_cpu_count();
+
+// runs func in threadCount threads (0 - count of processors, but not more than maxThreads) including current thread
+// and waits for all of them. If new threads cannot be created, work is done by fewer threads
+void blazer_run_parallel(blazer_thread_func func, void* arg, int32_t threadCount, int32_t maxThreads);
+
+// increments value and returns new value
+static BLAZER_INLINE int32_t blazer_atomic_increment(volatile int32_t* value)
+{
+#ifdef _WIN32
+	return (int32_t)InterlockedIncrement((volatile LONG*)value);
+#else
+	return __atomic_add_fetch(value, 1, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// reads value written by other threads
+static BLAZER_INLINE int32_t blazer_atomic_load(volatile int32_t* value)
+{
+#ifdef _WIN32
+	return *value;
+#else
+	return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static BLAZER_INLINE void blazer_atomic_store(volatile int32_t* value, int32_t newValue)
+{
+#ifdef _WIN32
+	*value = newValue;
+#else
+	__atomic_store_n(value, newValue, __ATOMIC_RELEASE);
+#endif
+}
@@ -0,0 +1,34 @@
+#include "stdafx.h"
+#include "WideCopy.h"
+#include "Cpu.h"
+
+#ifdef BLAZER_X86
+#include <immintrin.h>
+#endif
+
+static void long_copy16(unsigned char* dst, const unsigned char* src, unsigned char* dstEnd)
+{
+	blazer_wild_copy16(dst, src, dstEnd);
+}
+
+#ifdef BLAZER_X86
+BLAZER_TARGET_AVX2 static void long_copy32(unsigned char* dst, const unsigned char* src, unsigned char* dstEnd)
+{
+	do
+	{
+		_mm256_storeu_si256((__m256i*)dst, _mm256_loadu_si256((const __m256i*)src));
+		dst += 32;
+		src += 32;
+	}
+	while (dst < dstEnd);
+}
+#endif
+
+blazer_long_copy_func blazer_get_long_copy()
+{
+#ifdef BLAZER_X86
+	if (blazer_cpu_features() & BLAZER_CPU_AVX2)
+		return long_copy32;
+#endif
+	return long_copy16;
+}
@@ -0,0 +1,102 @@
+// WideCopy.h : wide copy kernels for decoders
+// Kernels copy data by whole 16 or 32 byte chunks, so they can read and write up to BLAZER_DECOMPRESS_MARGIN bytes
+// after end of copied data. Decoders use them only while such headroom exists in in and out buffers
+
+#pragma once
+
+#include "stdafx.h"
+#include "Blazer.h"
+
+#ifdef BLAZER_SSE2
+#include <emmintrin.h>
+#endif
+
+// copies not longer than this count are done inline, longer ones are done by blazer_long_copy_func
+#define BLAZER_LONG_COPY 64
+
+// copies 16 bytes. Data is loaded before storing, so regions can overlap
+static BLAZER_INLINE void blazer_copy16(unsigned char* dst, const unsigned char* src)
+{
+#ifdef BLAZER_SSE2
+	_mm_storeu_si128((__m128i*)dst, _mm_loadu_si128((const __m128i*)src));
+#else
+	uint64_t v[2];
+	memcpy(v, src, 16);
+	memcpy(dst, v, 16);
+#endif
+}
+
+// copies data by 16 byte chunks till dstEnd, src should be at least 16 bytes before dst or should not overlap with it
+static BLAZER_INLINE void blazer_wild_copy16(unsigned char* dst, const unsigned char* src, unsigned char* dstEnd)
+{
+	do
+	{
+		blazer_copy16(dst, src);
+		dst += 16;
+		src += 16;
+	}
+	while (dst < dstEnd);
+}
+
+// copies back reference with offset less than 16, by repeating its pattern
+static BLAZER_INLINE void blazer_pattern_copy(unsigned char* dst, size_t offset, unsigned char* dstEnd)
+{
+	const unsigned char* src = dst - offset;
+	if (offset == 1)
+	{
+#ifdef BLAZER_SSE2
+		__m128i v = _mm_set1_epi8((char)*src);
+		do
+		{
+			_mm_storeu_si128((__m128i*)dst, v);
+			dst += 16;
+		}
+		while (dst < dstEnd);
+		return;
+#endif
+	}
+
+	// first chunk is expanded byte by byte, next chunks repeat it with step which is multiple of offset
+	for (int i = 0; i < 16; i++)
+		dst[i] = src[i];
+
+	size_t step = 16 - (16 % offset);
+	unsigned char* chunk = dst;
+	dst += step;
+	while (dst < dstEnd)
+	{
+		blazer_copy16(dst, chunk);
+		chunk += step;
+		dst += step;
+	}
+}
+
+typedef void (*blazer_long_copy_func)(unsigned char* dst, const unsigned char* src, unsigned char* dstEnd);
+
+// returns best long copy kernel for current processor (32 byte chunks with AVX2, otherwise 16 byte ones).
+// src should be at least 32 bytes before dst or should not overlap with it
+blazer_long_copy_func blazer_get_long_copy();
+
+// copies literals from in buffer, reads and writes up to BLAZER_DECOMPRESS_MARGIN bytes after end
+static BLAZER_INLINE void blazer_literal_copy(unsigned char* dst, const unsigned char* src, size_t count, blazer_long_copy_func longCopy)
+{
+	if (count <= 16)
+		blazer_copy16(dst, src);
+	else if (count <= BLAZER_LONG_COPY)
+		blazer_wild_copy16(dst, src, dst + count);
+	else
+		longCopy(dst, src, dst + count);
+}
+
+// copies back reference, writes up to BLAZER_DECOMPRESS_MARGIN bytes after end
+static BLAZER_INLINE void blazer_match_copy(unsigned char* dst, size_t offset, size_t count, blazer_long_copy_func longCopy)
+{
+	if (offset < 16)
+		blazer_pattern_copy(dst, offset, dst + count);
+	else if (count <= 16)
+		blazer_copy16(dst, dst - offset);
+	else if (count <= BLAZER_LONG_COPY || offset < 32)
+		blazer_wild_copy16(dst, dst - offset, dst + count);
+	else
+		longCopy(dst, dst - offset, dst + count);
+}
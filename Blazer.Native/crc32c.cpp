@@ -19,36 +19,62 @@
 */
 
 #include "stdafx.h"
+#include "Blazer.h"
+#include "Cpu.h"
+#include "Crc32c.h"
+#include "Threading.h"
 
 #ifndef _CRT_SECURE_NO_WARNINGS
 #define _CRT_SECURE_NO_WARNINGS
 #endif
 
-#define uint32_t unsigned __int32
-#define uint8_t unsigned __int8
-#define uint64_t unsigned __int64
+#ifdef BLAZER_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+#endif
 
-/*
-    Computes CRC-32C using Castagnoli polynomial of 0x82f63b78.
-    This polynomial is better at detecting errors than the more common CRC-32 polynomial.
-    CRC-32C is implemented in hardware on newer Intel processors.
-    This function will use the hardware if available and fall back to fast software implementation.
-*/
-extern "C" __declspec(dllexport) uint32_t crc32c_append(
-    uint32_t crc,               // initial CRC, typically 0, may be used to accumulate CRC from multiple buffers
-    const uint8_t *input,       // data to be put through the CRC algorithm
-    size_t length);             // length of the data in the input buffer
+#ifdef BLAZER_ARM64
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <arm_acle.h>
+#endif
+#endif
 
-#define NOMINMAX
+#ifndef _WIN32
+#include <pthread.h>
+#endif
 
-#include <algorithm>
+// gcc and clang require explicit target for sse4.2 instructions, but we do not want to require it for whole library
+#if defined(BLAZER_X86) && !defined(_MSC_VER)
+#define BLAZER_TARGET_SSE42 __attribute__((target("sse4.2")))
+#else
+#define BLAZER_TARGET_SSE42
+#endif
 
 typedef const uint8_t *buffer;
 
+// 64-bit registers are used by table version
+#if defined(BLAZER_X64) || defined(BLAZER_ARM64)
+#define CRC_64BIT
+#endif
+
 
 #define POLY 0x82f63b78
 #define LONG_SHIFT 8192
 #define SHORT_SHIFT 256
+// shorter buffers are processed by crc instructions, setup of folding is not paid off
+#define PCLMUL_MIN_LENGTH 256
+#define AVX512_MIN_LENGTH 1024
+// block of hybrid loop: 64 bytes are folded by vector unit while three crc instructions are executed on each of
+// three scalar streams (24 bytes), so both units are busy
+#define HYBRID_ITERATIONS 32
+#define HYBRID_VECTOR (64 * HYBRID_ITERATIONS)
+#define HYBRID_SCALAR (24 * HYBRID_ITERATIONS)
+#define HYBRID_BLOCK (HYBRID_VECTOR + 3 * HYBRID_SCALAR)
 
 
 // include it if you need speed performance instead of library size
@@ -60,20 +86,35 @@ static uint32_t long_shifts[4][256];
 
 static uint32_t short_shifts[4][256];
 
-/* Table-driven software version as a fall-back.  This is about 15 times slower
-   than using the hardware instructions.  This assumes little-endian integers,
-   as is the case on Intel processors that the assembler code here is for. */
+/* x^(2^k) mod POLY, for calculation of any power of x. Values repeat with period of 31 for this POLY */
+#define X2N_PERIOD 31
+static uint32_t x2n_table[X2N_PERIOD];
+
+/* Constants for folding of 128-bit chunks forward by 128, 384, 256 and 512 bits
+   (lanes of 512-bit register are folded to last one by 384, 256 and 128 bits) and by 2048 bits.
+   Low quadword multiplies first eight bytes of chunk. */
+static uint64_t fold_128[2];
+static uint64_t fold_lanes[4][2];
+static uint64_t fold_512[2];
+static uint64_t fold_2048[2];
+
+/* Constants for shift of crc by one, two and three scalar streams of hybrid loop. */
+static uint64_t hybrid_shifts[3];
+
+/* Table-driven software version as a fall-back (slicing by 16 bytes with 64-bit registers).  This is about
+   15 times slower than using the hardware instructions.  This assumes little-endian integers,
+   as is the case on Intel and ARM processors that the assembler code here is for. */
 static uint32_t append_table(uint32_t crci, buffer input, size_t length)
 {
     buffer next = input;
-#ifdef _M_X64
+#ifdef CRC_64BIT
     uint64_t crc;
 #else
     uint32_t crc;
 #endif
 
     crc = crci ^ 0xffffffff;
-#ifdef _M_X64
+#ifdef CRC_64BIT
     while (length && ((uintptr_t)next & 7) != 0)
     {
         crc = table[0][(crc ^ *next++) & 0xff] ^ (crc >> 8);
@@ -146,12 +187,13 @@ static inline uint32_t shift_crc(uint32_t shift_table[][256], uint32_t crc)
         ^ shift_table[3][crc >> 24];
 }
 
+#ifdef BLAZER_X86
 /* Compute CRC-32C using the Intel hardware instruction. */
-static uint32_t append_hw(uint32_t crc, buffer buf, size_t len)
+BLAZER_TARGET_SSE42 static uint32_t append_hw(uint32_t crc, buffer buf, size_t len)
 {
     buffer next = buf;
     buffer end;
-#ifdef _M_X64
+#ifdef BLAZER_X64
     uint64_t crc0, crc1, crc2;      /* need to be 64 bits for crc32q */
 #else
     uint32_t crc0, crc1, crc2;
@@ -169,7 +211,7 @@ static uint32_t append_hw(uint32_t crc, buffer buf, size_t len)
         --len;
     }
 
-#ifdef _M_X64
+#ifdef BLAZER_X64
     /* compute the crc on sets of LONG_SHIFT*3 bytes, executing three independent crc
        instructions, each on LONG_SHIFT bytes -- this is optimized for the Nehalem,
        Westmere, Sandy Bridge, and Ivy Bridge architectures, which have a
@@ -285,19 +327,254 @@ static uint32_t append_hw(uint32_t crc, buffer buf, size_t len)
     /* return a post-processed crc */
     return static_cast<uint32_t>(crc0) ^ 0xffffffff;
 }
+#endif
+
+#ifdef BLAZER_X64
+/* Folds 128-bit chunk x forward by distance of constant k and adds chunk at that distance. */
+BLAZER_TARGET_PCLMUL static BLAZER_INLINE __m128i fold(__m128i x, __m128i k, __m128i next)
+{
+    return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x00), _mm_clmulepi64_si128(x, k, 0x11)), next);
+}
+
+/* Folds remaining 16-byte chunks into x, then reduces it by crc instructions and appends tail bytes. */
+BLAZER_TARGET_PCLMUL static uint32_t fold_finish(__m128i x, buffer next, size_t len)
+{
+    __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i *>(fold_128));
+    while (len >= 16)
+    {
+        x = fold(x, k, _mm_loadu_si128(reinterpret_cast<const __m128i *>(next)));
+        next += 16;
+        len -= 16;
+    }
+
+    /* crc of folded chunk without pre- and post-processing is crc of all previous data */
+    uint64_t crc0 = _mm_crc32_u64(0, static_cast<uint64_t>(_mm_cvtsi128_si64(x)));
+    crc0 = _mm_crc32_u64(crc0, static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(x, x))));
+    return append_hw(static_cast<uint32_t>(crc0) ^ 0xffffffff, next, len);
+}
+
+/* Reduces four folded chunks to crc of all previous data (without post-processing). */
+BLAZER_TARGET_PCLMUL static BLAZER_INLINE uint32_t fold_reduce(__m128i x0, __m128i x1, __m128i x2, __m128i x3)
+{
+    __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i *>(fold_128));
+    x1 = fold(x0, k, x1);
+    x2 = fold(x1, k, x2);
+    x3 = fold(x2, k, x3);
+    uint64_t crc0 = _mm_crc32_u64(0, static_cast<uint64_t>(_mm_cvtsi128_si64(x3)));
+    return static_cast<uint32_t>(_mm_crc32_u64(crc0, static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(x3, x3)))));
+}
+
+/* Returns crc followed by zeros of hybrid_shifts constant k (crc * x^n mod POLY). */
+BLAZER_TARGET_PCLMUL static BLAZER_INLINE uint32_t shift_clmul(uint32_t crc, uint64_t k)
+{
+    __m128i p = _mm_clmulepi64_si128(_mm_cvtsi64_si128(static_cast<int64_t>(static_cast<uint64_t>(crc) << 32)), _mm_cvtsi64_si128(static_cast<int64_t>(k)), 0x00);
+    return static_cast<uint32_t>(_mm_crc32_u64(0, static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(p, p)))));
+}
+
+/* Compute CRC-32C by folding of four 128-bit chunks with carry-less multiplication. Multiplications are
+   independent of each other and are executed by other unit than crc instructions, so long buffers are processed by
+   both of them at once: each block has vector part and three scalar streams, their crcs are combined at end of block. */
+BLAZER_TARGET_PCLMUL static uint32_t append_pclmul(uint32_t crc, buffer buf, size_t len)
+{
+    buffer next = buf;
+    uint32_t crc0 = crc ^ 0xffffffff;
+    while (len >= HYBRID_BLOCK)
+    {
+        buffer scalar = next + HYBRID_VECTOR;
+        __m128i x0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(next));
+        __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(next + 16));
+        __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(next + 32));
+        __m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(next + 48));
+        x0 = _mm_xor_si128(x0, _mm_cvtsi32_si128(static_cast<int>(crc0)));
+        __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i *>(fold_512));
+        uint64_t crc1 = 0, crc2 = 0, crc3 = 0;
+        for (int i = 0; i < HYBRID_ITERATIONS; i++)
+        {
+            buffer s = scalar + 24 * i;
+            crc1 = _mm_crc32_u64(crc1, *reinterpret_cast<const uint64_t *>(s));
+            crc2 = _mm_crc32_u64(crc2, *reinterpret_cast<const uint64_t *>(s + HYBRID_SCALAR));
+            crc3 = _mm_crc32_u64(crc3, *reinterpret_cast<const uint64_t *>(s + 2 * HYBRID_SCALAR));
+            crc1 = _mm_crc32_u64(crc1, *reinterpret_cast<const uint64_t *>(s + 8));
+            crc2 = _mm_crc32_u64(crc2, *reinterpret_cast<const uint64_t *>(s + HYBRID_SCALAR + 8));
+            crc3 = _mm_crc32_u64(crc3, *reinterpret_cast<const uint64_t *>(s + 2 * HYBRID_SCALAR + 8));
+            crc1 = _mm_crc32_u64(crc1, *reinterpret_cast<const uint64_t *>(s + 16));
+            crc2 = _mm_crc32_u64(crc2, *reinterpret_cast<const uint64_t *>(s + HYBRID_SCALAR + 16));
+            crc3 = _mm_crc32_u64(crc3, *reinterpret_cast<const uint64_t *>(s + 2 * HYBRID_SCALAR + 16));
+            /* first vector chunks are loaded before loop */
+            if (i + 1 < HYBRID_ITERATIONS)
+            {
+                buffer v = next + 64 * (i + 1);
+                x0 = fold(x0, k, _mm_loadu_si128(reinterpret_cast<const __m128i *>(v)));
+                x1 = fold(x1, k, _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + 16)));
+                x2 = fold(x2, k, _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + 32)));
+                x3 = fold(x3, k, _mm_loadu_si128(reinterpret_cast<const __m128i *>(v + 48)));
+            }
+        }
+
+        crc0 = shift_clmul(fold_reduce(x0, x1, x2, x3), hybrid_shifts[2]);
+        crc0 ^= shift_clmul(static_cast<uint32_t>(crc1), hybrid_shifts[1]);
+        crc0 ^= shift_clmul(static_cast<uint32_t>(crc2), hybrid_shifts[0]);
+        crc0 ^= static_cast<uint32_t>(crc3);
+        next += HYBRID_BLOCK;
+        len -= HYBRID_BLOCK;
+    }
+
+    if (len < PCLMUL_MIN_LENGTH)
+        return append_hw(crc0 ^ 0xffffffff, next, len);
+
+    __m128i x0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(next));
+    __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(next + 16));
+    __m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(next + 32));
+    __m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(next + 48));
+    /* initial crc is added to first four bytes */
+    x0 = _mm_xor_si128(x0, _mm_cvtsi32_si128(static_cast<int>(crc0)));
+    next += 64;
+    len -= 64;
+
+    __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i *>(fold_512));
+    while (len >= 64)
+    {
+        x0 = fold(x0, k, _mm_loadu_si128(reinterpret_cast<const __m128i *>(next)));
+        x1 = fold(x1, k, _mm_loadu_si128(reinterpret_cast<const __m128i *>(next + 16)));
+        x2 = fold(x2, k, _mm_loadu_si128(reinterpret_cast<const __m128i *>(next + 32)));
+        x3 = fold(x3, k, _mm_loadu_si128(reinterpret_cast<const __m128i *>(next + 48)));
+        next += 64;
+        len -= 64;
+    }
+
+    k = _mm_loadu_si128(reinterpret_cast<const __m128i *>(fold_128));
+    x1 = fold(x0, k, x1);
+    x2 = fold(x1, k, x2);
+    x3 = fold(x2, k, x3);
+    return fold_finish(x3, next, len);
+}
 
-static bool detect_hw()
+BLAZER_TARGET_AVX512_CLMUL static BLAZER_INLINE __m512i fold512(__m512i x, __m512i k, __m512i next)
 {
-    int info[4];
-    __cpuid(info, 1);
-    return (info[2] & (1 << 20)) != 0;
+    return _mm512_ternarylogic_epi64(_mm512_clmulepi64_epi128(x, k, 0x00), _mm512_clmulepi64_epi128(x, k, 0x11), next, 0x96);
 }
 
-uint32_t (*append_func)(uint32_t, buffer, size_t);
+/* Same as append_pclmul with four 512-bit registers (16 chunks of 128 bits). */
+BLAZER_TARGET_AVX512_CLMUL static uint32_t append_avx512(uint32_t crc, buffer buf, size_t len)
+{
+    if (len < AVX512_MIN_LENGTH)
+        return append_pclmul(crc, buf, len);
+
+    buffer next = buf;
+    __m512i x0 = _mm512_loadu_si512(next);
+    __m512i x1 = _mm512_loadu_si512(next + 64);
+    __m512i x2 = _mm512_loadu_si512(next + 128);
+    __m512i x3 = _mm512_loadu_si512(next + 192);
+    x0 = _mm512_xor_si512(x0, _mm512_inserti32x4(_mm512_setzero_si512(), _mm_cvtsi32_si128(static_cast<int>(crc ^ 0xffffffff)), 0));
+    next += 256;
+    len -= 256;
+
+    /* masked broadcast and extracts with all lanes give same values as plain ones, but gcc does not warn about undefined source in them */
+    __m512i k = _mm512_maskz_broadcast_i32x4(0xffff, _mm_loadu_si128(reinterpret_cast<const __m128i *>(fold_2048)));
+    while (len >= 256)
+    {
+        x0 = fold512(x0, k, _mm512_loadu_si512(next));
+        x1 = fold512(x1, k, _mm512_loadu_si512(next + 64));
+        x2 = fold512(x2, k, _mm512_loadu_si512(next + 128));
+        x3 = fold512(x3, k, _mm512_loadu_si512(next + 192));
+        next += 256;
+        len -= 256;
+    }
+
+    k = _mm512_maskz_broadcast_i32x4(0xffff, _mm_loadu_si128(reinterpret_cast<const __m128i *>(fold_512)));
+    x1 = fold512(x0, k, x1);
+    x2 = fold512(x1, k, x2);
+    x3 = fold512(x2, k, x3);
+    while (len >= 64)
+    {
+        x3 = fold512(x3, k, _mm512_loadu_si512(next));
+        next += 64;
+        len -= 64;
+    }
+
+    /* first three lanes are folded to last one, constant of last lane is zero */
+    k = _mm512_loadu_si512(fold_lanes);
+    __m512i t = _mm512_ternarylogic_epi64(_mm512_clmulepi64_epi128(x3, k, 0x00), _mm512_clmulepi64_epi128(x3, k, 0x11),
+        _mm512_maskz_mov_epi64(0xc0, x3), 0x96);
+    __m256i h = _mm256_xor_si256(_mm512_maskz_extracti64x4_epi64(0xf, t, 0), _mm512_maskz_extracti64x4_epi64(0xf, t, 1));
+    __m128i x = _mm_xor_si128(_mm256_castsi256_si128(h), _mm256_extracti128_si256(h, 1));
+    return fold_finish(x, next, len);
+}
+#endif
+
+#ifdef BLAZER_ARM64
+/* Compute CRC-32C using the ARMv8 crc instructions, interleave is same as in append_hw. */
+BLAZER_TARGET_ARM_CRC32 static uint32_t append_arm(uint32_t crc, buffer buf, size_t len)
+{
+    buffer next = buf;
+    buffer end;
+    uint32_t crc0, crc1, crc2;
+
+    crc0 = crc ^ 0xffffffff;
+    while (len && ((uintptr_t)next & 7) != 0)
+    {
+        crc0 = __crc32cb(crc0, *next);
+        ++next;
+        --len;
+    }
+
+    while (len >= 3 * LONG_SHIFT)
+    {
+        crc1 = 0;
+        crc2 = 0;
+        end = next + LONG_SHIFT;
+        do
+        {
+            crc0 = __crc32cd(crc0, *reinterpret_cast<const uint64_t *>(next));
+            crc1 = __crc32cd(crc1, *reinterpret_cast<const uint64_t *>(next + LONG_SHIFT));
+            crc2 = __crc32cd(crc2, *reinterpret_cast<const uint64_t *>(next + 2 * LONG_SHIFT));
+            next += 8;
+        } while (next < end);
+        crc0 = shift_crc(long_shifts, crc0) ^ crc1;
+        crc0 = shift_crc(long_shifts, crc0) ^ crc2;
+        next += 2 * LONG_SHIFT;
+        len -= 3 * LONG_SHIFT;
+    }
+
+    while (len >= 3 * SHORT_SHIFT)
+    {
+        crc1 = 0;
+        crc2 = 0;
+        end = next + SHORT_SHIFT;
+        do
+        {
+            crc0 = __crc32cd(crc0, *reinterpret_cast<const uint64_t *>(next));
+            crc1 = __crc32cd(crc1, *reinterpret_cast<const uint64_t *>(next + SHORT_SHIFT));
+            crc2 = __crc32cd(crc2, *reinterpret_cast<const uint64_t *>(next + 2 * SHORT_SHIFT));
+            next += 8;
+        } while (next < end);
+        crc0 = shift_crc(short_shifts, crc0) ^ crc1;
+        crc0 = shift_crc(short_shifts, crc0) ^ crc2;
+        next += 2 * SHORT_SHIFT;
+        len -= 3 * SHORT_SHIFT;
+    }
 
-// static bool hw_available = detect_hw();
+    while (len >= 8)
+    {
+        crc0 = __crc32cd(crc0, *reinterpret_cast<const uint64_t *>(next));
+        next += 8;
+        len -= 8;
+    }
 
-void calculate_table() {
+    while (len)
+    {
+        crc0 = __crc32cb(crc0, *next);
+        ++next;
+        --len;
+    }
+
+    return crc0 ^ 0xffffffff;
+}
+#endif
+
+static uint32_t (*append_func)(uint32_t, buffer, size_t);
+
+static void calculate_table() {
 	for(int i = 0; i < 256; i++) {
 		uint32_t res = (uint32_t)i;
 		for(int t = 0; t < 16; t++) {
@@ -307,7 +584,7 @@ void calculate_table() {
 	}
 }
 
-void calculate_hw() {
+static void calculate_hw() {
 	for(int i = 0; i < 256; i++) {
 		uint32_t res = (uint32_t)i;
 		for (int k = 0; k < 8 * (SHORT_SHIFT - 4); k++) res = (res & 1) == 1 ? POLY ^ (res >> 1) : (res >> 1);
@@ -323,22 +600,205 @@ void calculate_hw() {
 	}
 }
 
-void _crc32c_init()
+/* Multiply a(x) by b(x) modulo POLY, polynomials are bit-reflected (x^0 is highest bit). */
+static uint32_t multmodp(uint32_t a, uint32_t b)
 {
-	if (append_func == NULL)
-	{
-		if (detect_hw()) {
-			append_func = append_hw;
-			calculate_hw();
-		} else {
-			calculate_table();
-			append_func = append_table;
+    uint32_t m = (uint32_t)1 << 31;
+    uint32_t p = 0;
+    for (;;)
+    {
+        if (a & m)
+        {
+            p ^= b;
+            if ((a & (m - 1)) == 0)
+                break;
+        }
+        m >>= 1;
+        b = b & 1 ? (b >> 1) ^ POLY : b >> 1;
+    }
+    return p;
+}
+
+/* Return x^n mod POLY, bit-reflected. */
+static uint32_t xpow(uint64_t n)
+{
+    uint32_t p = (uint32_t)1 << 31;
+    for (int k = 0; n != 0; n >>= 1, k++)
+    {
+        if (n & 1)
+            p = multmodp(x2n_table[k % X2N_PERIOD], p);
+    }
+    return p;
+}
+
+static void calculate_x2n() {
+	uint32_t p = (uint32_t)1 << 30;
+	for (int k = 0; k < X2N_PERIOD; k++) {
+		x2n_table[k] = p;
+		p = multmodp(p, p);
+	}
+}
+
+/* Chunk of 128 bits (first quadword L, second H) moved forward by n bits is L * x^(n + 64) + H * x^n.
+   Product of bit-reflected quadwords is shifted by one bit, so powers are lower by one. */
+static void calculate_fold(uint64_t* k, uint64_t n) {
+	k[0] = (uint64_t)xpow(n + 64 - 1) << 32;
+	k[1] = (uint64_t)xpow(n - 1) << 32;
+}
+
+static void calculate_folds() {
+	calculate_fold(fold_128, 128);
+	calculate_fold(fold_lanes[0], 384);
+	calculate_fold(fold_lanes[1], 256);
+	calculate_fold(fold_lanes[2], 128);
+	calculate_fold(fold_512, 512);
+	calculate_fold(fold_2048, 2048);
+	/* crc is multiplied by high quadword of product, so it is multiplied by x^64, and by x^32 by crc instruction,
+	   product of bit-reflected values is shifted by one more bit */
+	for (int i = 0; i < 3; i++)
+		hybrid_shifts[i] = (uint64_t)xpow(8 * HYBRID_SCALAR * (i + 1) - 33) << 32;
+}
+
+static void crc32c_init_tables()
+{
+	int32_t features = blazer_cpu_features();
+	calculate_table();
+	calculate_x2n();
+	append_func = append_table;
+#ifdef BLAZER_X86
+	if (features & BLAZER_CPU_SSE42) {
+		calculate_hw();
+		append_func = append_hw;
+#ifdef BLAZER_X64
+		if (features & BLAZER_CPU_PCLMUL) {
+			calculate_folds();
+			append_func = append_pclmul;
 		}
+		if (features & BLAZER_CPU_AVX512_CLMUL)
+			append_func = append_avx512;
+#endif
+	}
+#elif defined(BLAZER_ARM64)
+	if (features & BLAZER_CPU_ARM_CRC32) {
+		calculate_hw();
+		append_func = append_arm;
 	}
+#else
+	(void)features;
+#endif
 }
 
+#ifdef _WIN32
+static INIT_ONCE _crc32c_once = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK crc32c_init_once(PINIT_ONCE, PVOID, PVOID*)
+{
+	crc32c_init_tables();
+	return TRUE;
+}
 
-extern "C" __declspec(dllexport) uint32_t crc32c_append(uint32_t crc, buffer input, size_t length)
+static void _crc32c_init()
 {
+	InitOnceExecuteOnce(&_crc32c_once, crc32c_init_once, NULL, NULL);
+}
+#else
+static pthread_once_t _crc32c_once = PTHREAD_ONCE_INIT;
+
+static void _crc32c_init()
+{
+	pthread_once(&_crc32c_once, crc32c_init_tables);
+}
+#endif
+
+
+extern "C" BLAZER_API uint32_t crc32c_append(uint32_t crc, buffer input, size_t length)
+{
+	_crc32c_init();
 	return append_func(crc, input, length);
 }
+
+extern "C" BLAZER_API uint32_t crc32c_combine(uint32_t crcA, uint32_t crcB, uint64_t lengthB)
+{
+	_crc32c_init();
+	/* crc of A is moved forward by length of B, pre and post conditioning of both crcs cancel out */
+	return multmodp(xpow(lengthB << 3), crcA) ^ crcB;
+}
+
+/* Chunks of parallel crc are large enough to amortize combination and small enough to balance threads */
+#define PARALLEL_CHUNK (1 << 20)
+
+struct crc_parallel_job
+{
+	buffer input;
+	size_t length;
+	int32_t chunkCount;
+	uint32_t* crcs;
+	volatile int32_t nextChunk;
+};
+
+static void crc_parallel_worker(void* arg)
+{
+	crc_parallel_job* job = (crc_parallel_job*)arg;
+	int32_t chunkIdx;
+	while ((chunkIdx = blazer_atomic_increment(&job->nextChunk) - 1) < job->chunkCount)
+	{
+		size_t pos = (size_t)chunkIdx * PARALLEL_CHUNK;
+		size_t cnt = job->length - pos < PARALLEL_CHUNK ? job->length - pos : PARALLEL_CHUNK;
+		job->crcs[chunkIdx] = append_func(0, job->input + pos, cnt);
+	}
+}
+
+extern "C" BLAZER_API uint32_t crc32c_append_parallel(uint32_t crc, buffer input, size_t length, int32_t threadCount)
+{
+	_crc32c_init();
+	size_t chunkCount = (length + PARALLEL_CHUNK - 1) / PARALLEL_CHUNK;
+	if (chunkCount < 2 || threadCount == 1 || chunkCount > 0x7fffffff)
+		return append_func(crc, input, length);
+
+	crc_parallel_job job;
+	job.input = input;
+	job.length = length;
+	job.chunkCount = (int32_t)chunkCount;
+	job.crcs = (uint32_t*)blazer_alloc_zero(sizeof(uint32_t) * chunkCount);
+	job.nextChunk = 0;
+	if (job.crcs == 0)
+		return append_func(crc, input, length);
+
+	blazer_run_parallel(crc_parallel_worker, &job, threadCount, job.chunkCount);
+
+	/* all chunks except last one have same length, so their shift is calculated once */
+	uint32_t shift = xpow((uint64_t)PARALLEL_CHUNK << 3);
+	for (int32_t i = 0; i < job.chunkCount - 1; i++)
+		crc = multmodp(shift, crc) ^ job.crcs[i];
+	crc = crc32c_combine(crc, job.crcs[job.chunkCount - 1], length - (chunkCount - 1) * PARALLEL_CHUNK);
+	blazer_free(job.crcs);
+	return crc;
+}
+
+blazer_crc32c_func blazer_crc32c_kernel(int32_t kernel)
+{
+	_crc32c_init();
+	int32_t features = blazer_cpu_features();
+	(void)features;
+	switch (kernel)
+	{
+	case BLAZER_CRC32C_TABLE:
+		return append_table;
+#ifdef BLAZER_X86
+	case BLAZER_CRC32C_HW:
+		return (features & BLAZER_CPU_SSE42) ? append_hw : 0;
+#ifdef BLAZER_X64
+	case BLAZER_CRC32C_PCLMUL:
+		return (features & BLAZER_CPU_SSE42) && (features & BLAZER_CPU_PCLMUL) ? append_pclmul : 0;
+	case BLAZER_CRC32C_AVX512:
+		return (features & BLAZER_CPU_SSE42) && (features & BLAZER_CPU_AVX512_CLMUL) ? append_avx512 : 0;
+#endif
+#elif defined(BLAZER_ARM64)
+	case BLAZER_CRC32C_HW:
+		return (features & BLAZER_CPU_ARM_CRC32) ? append_arm : 0;
+#endif
+	default:
+		return 0;
+	}
+}
+
@@ -3,14 +3,12 @@
 
 static char* _dummy = "Blazer archiver by Force";
 
-void _crc32c_init();
-
 BOOL APIENTRY DllMain(HMODULE hModule,
                        DWORD  ul_reason_for_call,
                        LPVOID lpReserved
 					 )
 {
-	_crc32c_init();
+	// crc32c tables are initialized on first crc32c_append call
 	if (_dummy == 0)
 		return FALSE;
 	/*switch (ul_reason_for_call)
@@ -5,12 +5,88 @@
 
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef _WIN32
+
 #include "targetver.h"
 
 #define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
 // Windows Header Files:
 #include <windows.h>
 
+#define BLAZER_API __declspec(dllexport)
+#define BLAZER_INLINE __inline
+
+#else
+
+#include <stdlib.h>
+
+#define BLAZER_API __attribute__((visibility("default")))
+#define BLAZER_INLINE inline
+
+#endif
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define BLAZER_X64
+#endif
+
+#if defined(BLAZER_X64) || defined(_M_IX86) || defined(__i386__)
+#define BLAZER_X86
+#endif
+
+#if defined(_M_ARM64) || defined(__aarch64__)
+#define BLAZER_ARM64
+#endif
+
+// SSE2 is always available on x64, on x86 it should be enabled by compiler options
+#if defined(BLAZER_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define BLAZER_SSE2
+#endif
+
+// Windows build does not link CRT (see vcxproj), so all allocations are going through process heap there
+static BLAZER_INLINE void* blazer_alloc_zero(size_t size)
+{
+#ifdef _WIN32
+	return HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, size);
+#else
+	return calloc(1, size);
+#endif
+}
+
+static BLAZER_INLINE void blazer_free(void* ptr)
+{
+#ifdef _WIN32
+	HeapFree(GetProcessHeap(), 0, ptr);
+#else
+	free(ptr);
+#endif
+}
+
+// copies 4 bytes. Back references overlap with destination, so copy loops should not be expressed with int casts,
+// otherwise optimizer can vectorize them as non-overlapping (memcpy with constant size is compiled into single mov)
+static BLAZER_INLINE void blazer_copy4(unsigned char* dst, const unsigned char* src)
+{
+	memcpy(dst, src, 4);
+}
 
+// memmove is not an intrinsic function in MSVC and cannot be used without CRT.
+// Copies count bytes to lower address, regions can overlap
+static BLAZER_INLINE void blazer_move_down(unsigned char* dst, const unsigned char* src, size_t count)
+{
+	if ((size_t)(src - dst) >= sizeof(uint32_t))
+	{
+		while (count >= sizeof(uint32_t))
+		{
+			blazer_copy4(dst, src);
+			dst += sizeof(uint32_t);
+			src += sizeof(uint32_t);
+			count -= sizeof(uint32_t);
+		}
+	}
 
-// TODO: reference additional headers your program requires here
+	while (count-- > 0)
+		*dst++ = *src++;
+}
@@ -3,6 +3,8 @@ using System.Diagnostics;
 using System.IO;
 
 using Force.Blazer;
+using Force.Blazer.Algorithms;
+using Force.Blazer.Native;
 
 using NUnit.Framework;
 
@@ -54,5 +56,63 @@ namespace Blazer.Net.Tests
 
 			Assert.That(totalPos, Is.EqualTo(totalSize));
 		}
+
+		[Test]
+		[TestCase(typeof(StreamEncoder))]
+		[TestCase(typeof(StreamEncoderNative))]
+		public void Stream_Longer_Than_2Gb_Should_Not_Use_Stale_Positions(Type encoderType)
+		{
+			// ensuring native is inited
+			NativeHelper.SetNativeImplementation(true);
+			if (encoderType == typeof(StreamEncoderNative) && !NativeHelper.IsNativeAvailable)
+				Assert.Ignore("Native library is not available");
+
+			// blocks are repeated after 2Mb, so hash table is full of positions, which are too far for back reference.
+			// Every block is compressible by itself, so compressed data fits into memory
+			const int BlockSize = 65536;
+			var pool = new byte[32][];
+			var rnd = new Random(1);
+			for (var i = 0; i < pool.Length; i++)
+			{
+				pool[i] = new byte[BlockSize];
+				var seed = new byte[1024];
+				rnd.NextBytes(seed);
+				for (var k = 0; k < BlockSize; k += seed.Length)
+					Buffer.BlockCopy(seed, 0, pool[i], k, seed.Length);
+			}
+
+			var blockCount = (int)((5L << 29) / BlockSize); // 2.5Gb
+			var outs = new MemoryStream();
+			var options = BlazerCompressionOptions.CreateStream();
+			options.Encoder = (IEncoder)Activator.CreateInstance(encoderType);
+			options.LeaveStreamOpen = true;
+			var comp = new BlazerInputStream(outs, options);
+			for (var i = 0; i < blockCount; i++)
+				comp.Write(pool[(i * 7) % pool.Length], 0, BlockSize);
+			comp.Close();
+
+			outs.Seek(0, SeekOrigin.Begin);
+			var decomp = new BlazerOutputStream(outs);
+			var buf = new byte[BlockSize];
+			for (var i = 0; i < blockCount; i++)
+			{
+				var pos = 0;
+				while (pos < BlockSize)
+				{
+					var readed = decomp.Read(buf, pos, BlockSize - pos);
+					Assert.That(readed, Is.GreaterThan(0), "Unexpected end of data at block " + i);
+					pos += readed;
+				}
+
+				var expected = pool[(i * 7) % pool.Length];
+				for (var k = 0; k < BlockSize; k++)
+				{
+					if (buf[k] != expected[k])
+						Assert.Fail("Invalid data at block " + i + ", offset " + k);
+				}
+			}
+
+			Assert.That(decomp.Read(buf, 0, 1), Is.EqualTo(0));
+		}
 	}
 }
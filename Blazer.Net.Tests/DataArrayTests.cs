@@ -50,10 +50,13 @@ namespace Blazer.Net.Tests
 		[TestCase(typeof(StreamEncoder), typeof(StreamDecoder))]
 		[TestCase(typeof(StreamEncoderNative), typeof(StreamDecoderNative))]
 		[TestCase(typeof(StreamEncoderHigh), typeof(StreamDecoder))]
+		[TestCase(typeof(StreamEncoderHighNative), typeof(StreamDecoderNative))]
 		public void Stream_Encode_Decode_Should_Not_Resize_Array(Type encoderType, Type decoderType)
 		{
 			// ensuring native is inited
 			NativeHelper.SetNativeImplementation(true);
+			if (encoderType == typeof(StreamEncoderHighNative) && !NativeHelper.IsStreamHighAvailable)
+				Assert.Ignore("Native library does not export levels of stream encoder");
 			var bufferIn = new byte[] { 1, 2, 3, 4, 4, 4, 4, 4, 4, 4, 4, 4 };
 			var encoder = (StreamEncoder)Activator.CreateInstance(encoderType);
 			encoder.Init(bufferIn.Length);
@@ -19,8 +19,8 @@ namespace Force.Blazer.Algorithms
 		/// </summary>
 		public override void Init(int maxUncompressedBlockSize)
 		{
-			// +8 for better copying speed. allow dummy copy by 8 bytes 
-			base.Init(maxUncompressedBlockSize + 8);
+			// +32 for better copying speed: native decoder uses wide copies only while more than 32 bytes of headroom remain (BLAZER_DECOMPRESS_MARGIN)
+			base.Init(maxUncompressedBlockSize + 32);
 		}
 
 		/// <summary>
@@ -112,7 +112,9 @@ namespace Force.Blazer.Algorithms
 			_bufferInLength = 0;
 			_bufferOutIdx = 0;
 
-			if (_shiftValue >= 2 * SIZE_SHIFT)
+			// native high encoder stores positions modulo 2^32, so shift value can just overflow for it.
+			// Embedded native library of StreamEncoderNative can be older one with signed positions, so it is shifted as managed encoder
+			if (_shiftValue >= 2 * SIZE_SHIFT && IsShiftRequired)
 			{
 				ShiftHashtable();
 				_shiftValue -= SIZE_SHIFT;
@@ -396,6 +398,17 @@ namespace Force.Blazer.Algorithms
 			return idxOut;
 		}
 
+		/// <summary>
+		/// Returns true if positions in hash array should be shifted by <see cref="ShiftHashtable"/> for streams longer than 2Gb
+		/// </summary>
+		protected virtual bool IsShiftRequired
+		{
+			get
+			{
+				return true;
+			}
+		}
+
 		/// <summary>
 		/// Shifts hashtable data
 		/// </summary>
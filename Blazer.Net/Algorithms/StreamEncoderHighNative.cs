@@ -0,0 +1,90 @@
+﻿using System;
+using System.Runtime.InteropServices;
+
+namespace Force.Blazer.Algorithms
+{
+	/// <summary>
+	/// Native implementation of <see cref="StreamEncoderHigh"/>. Uses hash chains with lazy matching, so it is faster and has better compression rate.
+	/// Fully compatible with <see cref="StreamDecoder"/>
+	/// </summary>
+	public class StreamEncoderHighNative : StreamEncoder
+	{
+		/// <summary>
+		/// Default level of native encoder
+		/// </summary>
+		public const int DEFAULT_LEVEL = 8;
+
+		// same as BLAZER_HIGH_HASH_SIZE in Blazer.Native: 32-bit heads of chains and then 16-bit chains
+		private const int HEADS_LEN = 1 << 16;
+
+		private const int CHAINS_LEN = 1 << 16;
+
+		private readonly int _level;
+
+		private readonly int[] _hashArrHigh = new int[HEADS_LEN + (CHAINS_LEN / 2)];
+
+		[DllImport(@"Blazer.Native.dll", CallingConvention = CallingConvention.Cdecl)]
+		private static extern int blazer_stream_compress_block_level(
+			byte[] bufferIn, int bufferInOffset, int bufferInLength, int globalOffset, byte[] bufferOut, int bufferOutOffset, int[] hashArr, int level);
+
+		/// <summary>
+		/// Creates encoder with default level
+		/// </summary>
+		public StreamEncoderHighNative()
+			: this(DEFAULT_LEVEL)
+		{
+		}
+
+		/// <summary>
+		/// Creates encoder with level of native library (from 6 to 9, higher level is slower but gives better compression rate)
+		/// </summary>
+		public StreamEncoderHighNative(int level)
+		{
+			if (level < 6 || level > 9)
+				throw new ArgumentOutOfRangeException("level");
+			_level = level;
+		}
+
+		/// <summary>
+		/// Returns additional size for inner buffers. Can be used to store some data or for optimiations
+		/// </summary>
+		/// <returns>Size in bytes</returns>
+		public override int GetAdditionalInSize()
+		{
+			return 8;
+		}
+
+		/// <summary>
+		/// Compresses block of data. See <see cref="StreamEncoder.CompressBlockExternal"/> for details
+		/// </summary>
+		public override int CompressBlock(
+			byte[] bufferIn,
+			int bufferInOffset,
+			int bufferInLength,
+			int bufferInShift,
+			byte[] bufferOut,
+			int bufferOutOffset)
+		{
+			return blazer_stream_compress_block_level(
+				bufferIn,
+				bufferInOffset,
+				bufferInLength,
+				bufferInShift,
+				bufferOut,
+				bufferOutOffset,
+				_hashArrHigh,
+				_level);
+		}
+
+		/// <summary>
+		/// Native encoder stores positions modulo 2^32 and does not require shifting of hash array
+		/// </summary>
+		protected override bool IsShiftRequired
+		{
+			get
+			{
+				return false;
+			}
+		}
+	}
+}
@@ -5,6 +5,8 @@
 	/// </summary>
 	public enum BlazerBlockType : byte
 	{
+		// BlockOffsets = 0x12 - data of block algorithm with explicit offsets, written by native library only
+
 		/// <summary>
 		/// Empty control block
 		/// </summary>
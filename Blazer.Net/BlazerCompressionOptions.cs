@@ -2,6 +2,7 @@
 using System.Text;
 
 using Force.Blazer.Algorithms;
+using Force.Blazer.Native;
 
 namespace Force.Blazer
 {
@@ -202,7 +203,7 @@ namespace Force.Blazer
 		{
 			return new BlazerCompressionOptions
 			{
-				Encoder = new StreamEncoderHigh(),
+				Encoder = NativeHelper.IsStreamHighAvailable ? (IEncoder)new StreamEncoderHighNative() : new StreamEncoderHigh(),
 				_flags = BlazerFlags.DefaultStream,
 				FlushMode = BlazerFlushMode.RespectFlush
 			};
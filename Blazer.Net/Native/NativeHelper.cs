@@ -21,20 +21,52 @@ namespace Force.Blazer.Native
 
 		private static readonly bool _isNativePossible;
 
+		private static readonly bool _isStreamHighPossible;
+
+		private static IntPtr _module;
+
 		[DllImport("Kernel32.dll")]
 		private static extern IntPtr LoadLibrary(string path);
 
+		[DllImport("Kernel32.dll")]
+		private static extern IntPtr GetProcAddress(IntPtr module, string procName);
+
 		/// <summary>
 		/// Returns is native library is available for usage
 		/// </summary>
 		public static bool IsNativeAvailable { get; private set; }
 
+		/// <summary>
+		/// Returns is native high compression encoder (<see cref="Force.Blazer.Algorithms.StreamEncoderHighNative"/>) available for usage
+		/// </summary>
+		/// <remarks>Native library of older versions does not export levels of stream encoder</remarks>
+		public static bool IsStreamHighAvailable
+		{
+			get
+			{
+				return IsNativeAvailable && _isStreamHighPossible;
+			}
+		}
+
 		static NativeHelper()
 		{
 			_isNativePossible = Init();
+			_isStreamHighPossible = _isNativePossible && HasExport("blazer_stream_compress_block_level");
 			IsNativeAvailable = _isNativePossible;
 		}
 
+		private static bool HasExport(string name)
+		{
+			try
+			{
+				return GetProcAddress(_module, name) != IntPtr.Zero;
+			}
+			catch (Exception)
+			{
+				return false;
+			}
+		}
+
 		private static bool Init()
 		{
 			try
@@ -80,7 +112,8 @@ namespace Force.Blazer.Native
 					}
 				}
 
-				if (LoadLibrary(fileName) == IntPtr.Zero)
+				_module = LoadLibrary(fileName);
+				if (_module == IntPtr.Zero)
 					throw new InvalidOperationException("Unexpected error in dll loading");
 			}
 		}